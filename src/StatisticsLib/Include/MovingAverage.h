@@ -17,60 +17,407 @@
  *
  */
 
+
 #ifndef ___MovingEvarage_H___
 #define ___MovingEvarage_H___
 
 #include <iostream>
-#include <queue>
 #include <vector>
 #include <algorithm>
 #include <iterator>
+#include <type_traits>
+#include <math.h>
+
+#include "StatisticSpan.h"
+#include "StatisticSnapshot.h"
 
 //
 namespace NStatisticAlg
 {
+// window storage: fixed array for the compile time period, one allocation otherwise
+template <class T, size_t Period> class movingAverageWindow
+{
+public:
+	explicit movingAverageWindow(size_t) {}
+
+	size_t Size() const { return Period; }
+	T* Data() { return m_data; }
+	const T* Data() const { return m_data; }
+
+private:
+	T m_data[Period];
+};
+
+template <class T> class movingAverageWindow<T, 0>
+{
+public:
+	explicit movingAverageWindow(size_t period) : m_data(period ? period : 1) {}
+
+	size_t Size() const { return m_data.size(); }
+	T* Data() { return &m_data[0]; }
+	const T* Data() const { return &m_data[0]; }
+
+private:
+	std::vector<T> m_data;
+};
+
+//!@ingroup amgStatistic
+//! @brief Общий интерфейс скользящих средних
+//!
+//! Derived реализует Next(T) - добавление значения с возвратом текущего среднего
+//! за O(1). Базовый класс добавляет пакетную обработку массива.
+template <class Derived, class T> class CMovingAverageBase
+{
+public:
+	typedef typename std::common_type<T, double>::type result_type;
+
+   /*!@brief Сглаживание массива значений
+   * @param[in] in Исходные значения (продолжают текущее состояние)
+   * @param[out] out Сглаженные значения, не меньше in.Size() элементов
+   */
+	template <class U>
+	void Apply(NStatisticEvaluations::statisticSpan<const T> in, NStatisticEvaluations::statisticSpan<U> out)
+	{
+		Derived& self = static_cast<Derived&>(*this);
+		for (size_t i = 0; i < in.Size(); ++i)
+			out[i] = static_cast<U>(self.Next(in[i]));
+	}
+};
+
 //!@ingroup amgStatistic
-//! @brief     (Simple Moving Average) 
-//!   .
+//! @brief Реализиция алгоритма скользящего среднего (Simple Moving Average) для
+//! сглаживания набора значений.
+//!
+//! Окно хранится в непрерывном кольцевом буфере, выделяемом один раз (при периоде,
+//! заданном параметром шаблона, - без выделения памяти). Сумма окна и результат
+//! вычисляются в типе result_type (double для целых и float).
 //! 
-//! :
+//! Пример:
 //! @code
 //!    double d_data[10] = {1.234, 2.298, 4.355, 8.41, 10.54, 6.645, 11.36, 15.898, 12.999, 10.111};
-//!    vector<double> smoothed_vector;
-//!    smoothed_vector.reserve(10);
+//!    vector<double> smoothed_vector(10);
 //!
-//!    //   MovingAverage   ,   
-//!    for_each(d_data, d_data + 10, MovingAverage(smoothed_vector, 5));  // C++11
-//!	 //   
-//!    copy(smoothed_vector.begin(), smoothed_vector.end(), ostream_iterator<double>(cout, "\n"));
+//!    // сглаживание набора значений в подготовленный выходной массив
+//!    CMovingAverage average(5);
+//!    average.Apply(statisticSpan<const double>(d_data, 10), statisticSpan<double>(smoothed_vector));
+//!
+//!    // период, заданный при компиляции
+//!    CBasicMovingAverage<float, 5> average5;
+//!    float value = average5.Next(1.5f);
 //! @endcode
-class CMovingAverage
+template <class T, size_t Period = 0> class CBasicMovingAverage
+	: public CMovingAverageBase<CBasicMovingAverage<T, Period>, T>
+{
+public:
+	typedef typename CMovingAverageBase<CBasicMovingAverage<T, Period>, T>::result_type result_type;
+
+   /*!@brief Конструктор
+   * @param[in] period Размер окна (показатель сглаживания), игнорируется при Period > 0
+   */
+	explicit CBasicMovingAverage(size_t period = Period)
+		: m_window(period), m_head(0), m_size(0), m_sum(0), m_out(0) {}
+   //! @brief Конструктор функтора, дописывающего результат в вектор out
+	CBasicMovingAverage(std::vector<result_type> &out, size_t period)
+		: m_window(period), m_head(0), m_size(0), m_sum(0), m_out(&out) {}
+
+   //! @brief Добавление значения, возвращает текущее среднее окна
+	result_type Next(T num);
+   //! @brief Алгоритм сглаживания набора значений (результат - в вектор конструктора)
+	void operator()(T num)
+	{
+		const result_type average = Next(num);
+		if (m_out)
+			m_out->push_back(average);
+	}
+   /*!@brief Сглаживание массива значений
+   * @param[in] in Исходные значения (продолжают текущее окно)
+   * @param[out] out Сглаженные значения, не меньше in.Size() элементов
+   */
+	template <class U>
+	void Apply(NStatisticEvaluations::statisticSpan<const T> in, NStatisticEvaluations::statisticSpan<U> out);
+
+   //! @brief Сброс окна
+	void Reset() { m_head = m_size = 0; m_sum = 0; }
+
+	size_t GetPeriod() const { return m_window.Size(); }
+   //! @brief Количество значений в окне
+	size_t Size() const { return m_size; }
+   //! @brief Текущее среднее окна
+	result_type GetAverage() const { return m_size ? m_sum / m_size : result_type(0); }
+
+   //!@name Снимок состояния (StatisticSnapshot.h): период, сумма и значения окна
+   //@{
+	static uint32_t SnapshotKind()
+	{
+		return NStatisticEvaluations::SnapshotKind(NStatisticEvaluations::eSnapshotMovingAverage,
+			NStatisticEvaluations::SnapshotValueType<T>());
+	}
+	void SaveState(NStatisticEvaluations::statisticSnapshotWriter& writer) const;
+	bool LoadState(NStatisticEvaluations::statisticSnapshotReader& reader);
+   //@}
+
+private:
+	movingAverageWindow<T, Period> m_window;	// окно
+	size_t m_head;                      // позиция самого старого значения
+	size_t m_size;                      // количество значений в окне
+	result_type m_sum;                  // сумма элементов в окне
+	std::vector<result_type> *m_out;    // выходной вектор
+};
+
+typedef CBasicMovingAverage<double> CMovingAverage;
+
+// next value
+template <class T, size_t Period>
+typename CBasicMovingAverage<T, Period>::result_type CBasicMovingAverage<T, Period>::Next(T num)
+{
+	T* window = m_window.Data();
+	const size_t period = m_window.Size();
+
+	m_sum += num;
+	if (m_size == period)
+		m_sum -= window[m_head];
+	else
+		++m_size;
+
+	window[m_head] = num;
+	if (++m_head == period)
+		m_head = 0;
+
+	return m_sum / m_size;
+}
+
+// smooth array
+template <class T, size_t Period>
+template <class U>
+void CBasicMovingAverage<T, Period>::Apply(NStatisticEvaluations::statisticSpan<const T> in,
+	NStatisticEvaluations::statisticSpan<U> out)
+{
+	const T* input = in.Data();
+	U* output = out.Data();
+	const size_t n = in.Size();
+	const size_t period = m_window.Size();
+	T* window = m_window.Data();
+
+	// filling the window
+	size_t i = 0;
+	for (; i < n && m_size < period; ++i)
+		output[i] = static_cast<U>(Next(input[i]));
+
+	// full window: the divisor is constant, the ring is walked in contiguous chunks
+	const result_type scale = result_type(1) / period;
+	while (i < n)
+	{
+		size_t chunk = period - m_head;
+		if (chunk > n - i)
+			chunk = n - i;
+
+		result_type sum = m_sum;
+		T* slot = window + m_head;
+		for (size_t k = 0; k < chunk; ++k)
+		{
+			const T num = input[i + k];
+			sum += static_cast<result_type>(num) - slot[k];
+			slot[k] = num;
+			output[i + k] = static_cast<U>(sum * scale);
+		}
+
+		m_sum = sum;
+		i += chunk;
+		m_head += chunk;
+		if (m_head == period)
+			m_head = 0;
+	}
+}
+
+// snapshot: the values of the window in chronological order
+template <class T, size_t Period>
+void CBasicMovingAverage<T, Period>::SaveState(NStatisticEvaluations::statisticSnapshotWriter& writer) const
+{
+	const size_t period = m_window.Size();
+	const size_t oldest = m_size == period ? m_head : 0;
+	const size_t first = period - oldest < m_size ? period - oldest : m_size;
+
+	writer.Put(static_cast<uint64_t>(period));
+	writer.Put(m_sum);
+	writer.Put(static_cast<uint64_t>(m_size));
+	writer.Write(m_window.Data() + oldest, first * sizeof(T));
+	writer.Write(m_window.Data(), (m_size - first) * sizeof(T));
+}
+
+template <class T, size_t Period>
+bool CBasicMovingAverage<T, Period>::LoadState(NStatisticEvaluations::statisticSnapshotReader& reader)
 {
-    std::queue<double> m_window;	// 
-	 size_t m_period;				//    ( )
-	 double m_sum;					//    
-    std::vector<double> &m_out;		//  
+	uint64_t period = 0, size = 0;
+	result_type sum = 0;
+	if (!reader.Get(period) || !reader.Get(sum) || !reader.Get(size))
+		return false;
+	if (!period || (Period && period != Period) || size > period || size > reader.Remaining() / sizeof(T))
+		return reader.Fail();
 
+	movingAverageWindow<T, Period> window(static_cast<size_t>(period));
+	if (!reader.Read(window.Data(), static_cast<size_t>(size) * sizeof(T)))
+		return false;
+
+	m_window = window;
+	m_size = static_cast<size_t>(size);
+	m_head = m_size == period ? 0 : m_size;
+	m_sum = sum;
+	return true;
+}
+
+//!@ingroup amgStatistic
+//! @brief Экспоненциальное скользящее среднее (EMA)
+//!
+//! ema = ema + alpha * (x - ema), alpha = 2 / (period + 1); первое значение
+//! принимается за начальное среднее.
+template <class T> class CExponentialMovingAverage
+	: public CMovingAverageBase<CExponentialMovingAverage<T>, T>
+{
 public:
-    CMovingAverage(std::vector<double> &out, size_t period) : m_period(period), m_out(out) {}
-
-    //! @brief    
-    void operator()(double num)
-    {
-       m_sum += num;
-       m_window.push(num);
-       if (m_window.size() > m_period)
-		 {
-           m_sum -= m_window.front();
-           m_window.pop();
-       }
-       m_out.push_back(m_sum / m_window.size());
-    }
+	typedef typename CMovingAverageBase<CExponentialMovingAverage<T>, T>::result_type result_type;
+
+	explicit CExponentialMovingAverage(size_t period)
+		: m_alpha(result_type(2) / (result_type(period) + 1)), m_average(0), m_size(0) {}
+
+   //! @brief Коэффициент сглаживания (0, 1]
+	void SetAlpha(result_type alpha) { m_alpha = alpha; }
+	result_type GetAlpha() const { return m_alpha; }
+
+	result_type Next(T num)
+	{
+		if (m_size++ == 0)
+			m_average = num;
+		else
+			m_average += m_alpha * (num - m_average);
+		return m_average;
+	}
+
+	void Reset() { m_average = 0; m_size = 0; }
+	size_t Size() const { return m_size; }
+	result_type GetAverage() const { return m_average; }
+
+private:
+	result_type m_alpha;
+	result_type m_average;
+	size_t m_size;                      // количество значений
 };
-//
+
+//!@ingroup amgStatistic
+//! @brief Линейно взвешенное скользящее среднее (WMA)
+//!
+//! Веса 1..n, наибольший - у последнего значения. Сумма окна и взвешенная сумма
+//! обновляются рекуррентно за O(1): W' = W + n * x - S, S' = S + x - x(oldest).
+template <class T, size_t Period = 0> class CWeightedMovingAverage
+	: public CMovingAverageBase<CWeightedMovingAverage<T, Period>, T>
+{
+public:
+	typedef typename CMovingAverageBase<CWeightedMovingAverage<T, Period>, T>::result_type result_type;
+
+	explicit CWeightedMovingAverage(size_t period = Period)
+		: m_window(period), m_head(0), m_size(0), m_sum(0), m_weightedSum(0) {}
+
+	result_type Next(T num);
+
+	void Reset() { m_head = m_size = 0; m_sum = m_weightedSum = 0; }
+	size_t GetPeriod() const { return m_window.Size(); }
+	size_t Size() const { return m_size; }
+	result_type GetAverage() const
+	{
+		return m_size ? m_weightedSum / (result_type(m_size) * (m_size + 1) / 2) : result_type(0);
+	}
+
+private:
+	movingAverageWindow<T, Period> m_window;
+	size_t m_head;                      // позиция самого старого значения
+	size_t m_size;                      // количество значений в окне
+	result_type m_sum;                  // сумма элементов в окне
+	result_type m_weightedSum;          // взвешенная сумма элементов в окне
+};
+
+// next value
+template <class T, size_t Period>
+typename CWeightedMovingAverage<T, Period>::result_type CWeightedMovingAverage<T, Period>::Next(T num)
+{
+	T* window = m_window.Data();
+	const size_t period = m_window.Size();
+
+	if (m_size == period)
+	{
+		// every weight decreases by one, the oldest value leaves the window
+		m_weightedSum += result_type(period) * num - m_sum;
+		m_sum += static_cast<result_type>(num) - window[m_head];
+	}
+	else
+	{
+		++m_size;
+		m_weightedSum += result_type(m_size) * num;
+		m_sum += num;
+	}
+
+	window[m_head] = num;
+	if (++m_head == period)
+		m_head = 0;
+
+	return GetAverage();
 }
+
+//!@ingroup amgStatistic
+//! @brief Кумулятивное скользящее среднее (CMA) - среднее всех значений
+template <class T> class CCumulativeMovingAverage
+	: public CMovingAverageBase<CCumulativeMovingAverage<T>, T>
+{
+public:
+	typedef typename CMovingAverageBase<CCumulativeMovingAverage<T>, T>::result_type result_type;
+
+	CCumulativeMovingAverage() : m_average(0), m_size(0) {}
+
+	result_type Next(T num)
+	{
+		m_average += (num - m_average) / ++m_size;
+		return m_average;
+	}
+
+	void Reset() { m_average = 0; m_size = 0; }
+	size_t Size() const { return m_size; }
+	result_type GetAverage() const { return m_average; }
+
+private:
+	result_type m_average;
+	size_t m_size;                      // количество значений
+};
+
+//!@ingroup amgStatistic
+//! @brief Скользящее среднее Халла (HMA)
+//!
+//! HMA(n) = WMA(sqrt(n)) от ряда 2 * WMA(n / 2) - WMA(n); три взвешенных
+//! средних с обновлением за O(1).
+template <class T> class CHullMovingAverage
+	: public CMovingAverageBase<CHullMovingAverage<T>, T>
+{
+public:
+	typedef typename CMovingAverageBase<CHullMovingAverage<T>, T>::result_type result_type;
+
+	explicit CHullMovingAverage(size_t period)
+		: m_half(period / 2 ? period / 2 : 1), m_full(period),
+		m_smooth(sqrt((double)period) >= 1 ? (size_t)sqrt((double)period) : 1), m_period(period) {}
+
+	result_type Next(T num)
+	{
+		return m_smooth.Next(2 * m_half.Next(num) - m_full.Next(num));
+	}
+
+	void Reset() { m_half.Reset(); m_full.Reset(); m_smooth.Reset(); }
+	size_t GetPeriod() const { return m_period; }
+	size_t Size() const { return m_full.Size(); }
+	result_type GetAverage() const { return m_smooth.GetAverage(); }
+
+private:
+	CWeightedMovingAverage<T> m_half;
+	CWeightedMovingAverage<T> m_full;
+	CWeightedMovingAverage<result_type> m_smooth;
+	size_t m_period;
+};
 //
 }
 //
-
 #endif /* ___MovingEvarage_H___ */
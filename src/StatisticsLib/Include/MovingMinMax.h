@@ -0,0 +1,157 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___MovingMinMax_H___
+#define ___MovingMinMax_H___
+
+#include <cstddef>
+
+#include "MovingAverage.h"
+
+//
+namespace NStatisticAlg
+{
+// monotonic queue of the window values in a fixed ring: the front is the
+// extremum, every value is pushed and popped once (amortized O(1))
+template <class T, size_t Period, bool Max> class movingExtremumQueue
+{
+public:
+	struct entry
+	{
+		unsigned long long index;        // sample number
+		T value;
+	};
+
+	explicit movingExtremumQueue(size_t period) : m_ring(period), m_head(0), m_size(0) {}
+
+	void Push(unsigned long long index, T value)
+	{
+		entry* ring = m_ring.Data();
+		const size_t capacity = m_ring.Size();
+
+		// values dominated by the new one never become the extremum
+		while (m_size && !Before(ring[Position(m_size - 1)].value, value))
+			--m_size;
+		// the front leaves the window
+		if (m_size && ring[m_head].index + capacity <= index)
+			Pop();
+
+		entry& back = ring[Position(m_size++)];
+		back.index = index;
+		back.value = value;
+	}
+
+	T Front() const { return m_ring.Data()[m_head].value; }
+	bool Empty() const { return m_size == 0; }
+	void Clear() { m_head = m_size = 0; }
+
+private:
+	// strict order of the extremum: a stays in front of b
+	static bool Before(T a, T b) { return Max ? b < a : a < b; }
+
+	size_t Position(size_t i) const
+	{
+		const size_t position = m_head + i;
+		return position < m_ring.Size() ? position : position - m_ring.Size();
+	}
+	void Pop()
+	{
+		if (++m_head == m_ring.Size())
+			m_head = 0;
+		--m_size;
+	}
+
+	movingAverageWindow<entry, Period> m_ring;
+	size_t m_head;
+	size_t m_size;
+};
+
+//!@ingroup amgStatistic
+//! @brief Скользящие минимум и максимум по окну из period последних значений
+//!
+//! Монотонные очереди в кольцевых буферах фиксированного размера: обработка
+//! значения - амортизированное O(1) независимо от размера окна.
+//!
+//! Пример:
+//! @code
+//!    CMovingMinMax<double> peaks(10000);
+//!    for (int i = 0; i < n; ++i)
+//!    {
+//!       peaks.Next(d_data[i]);
+//!       if (peaks.GetMax() > limit)
+//!          ...
+//!    }
+//! @endcode
+template <class T, size_t Period = 0> class CMovingMinMax
+{
+public:
+   /*!@brief Конструктор
+   * @param[in] period Размер окна, игнорируется при Period > 0
+   */
+	explicit CMovingMinMax(size_t period = Period)
+		: m_min(period), m_max(period), m_count(0), m_period(period ? period : 1)
+	{
+		if (Period)
+			m_period = Period;
+	}
+
+   //! @brief Добавление значения
+	void Next(T num)
+	{
+		m_min.Push(m_count, num);
+		m_max.Push(m_count, num);
+		++m_count;
+	}
+   /*!@brief Скользящие минимум и максимум массива значений
+   * @param[in] in Исходные значения (продолжают текущее окно)
+   * @param[out] outMin Минимумы окна, не меньше in.Size() элементов
+   * @param[out] outMax Максимумы окна, не меньше in.Size() элементов
+   */
+	void Apply(NStatisticEvaluations::statisticSpan<const T> in,
+		NStatisticEvaluations::statisticSpan<T> outMin, NStatisticEvaluations::statisticSpan<T> outMax)
+	{
+		for (size_t i = 0; i < in.Size(); ++i)
+		{
+			Next(in[i]);
+			outMin[i] = m_min.Front();
+			outMax[i] = m_max.Front();
+		}
+	}
+
+   //! @brief Минимум окна (окно не пустое)
+	T GetMin() const { return m_min.Front(); }
+   //! @brief Максимум окна (окно не пустое)
+	T GetMax() const { return m_max.Front(); }
+
+	void Reset() { m_min.Clear(); m_max.Clear(); m_count = 0; }
+	size_t GetPeriod() const { return m_period; }
+   //! @brief Количество значений в окне
+	size_t Size() const { return m_count < m_period ? static_cast<size_t>(m_count) : m_period; }
+
+private:
+	movingExtremumQueue<T, Period, false> m_min;
+	movingExtremumQueue<T, Period, true> m_max;
+	unsigned long long m_count;         // количество обработанных значений
+	size_t m_period;
+};
+//
+}
+//
+#endif /* ___MovingMinMax_H___ */
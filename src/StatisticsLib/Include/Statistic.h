@@ -26,8 +26,11 @@
 #include <ctime>
 #include <math.h>
 
+#include "StatisticSpan.h"
 #include "StatisticEvaluations.h"
 #include "StatisticEvents.h"
+#include "StatisticCachedEvaluations.h"
+#include "StatisticPolicies.h"
 
 using namespace NStatisticEvaluations;
 using namespace NStatisticEvents;
@@ -35,62 +38,96 @@ using namespace NStatisticEvents;
 //
 namespace NStatistic
 {
-//!@defgroup amgStatistic 
-//! @brief   
+//!@defgroup amgStatistic Статистика
+//! @brief Общий класс статистики
 //!
-//!   ,   
-//!    .      ,
-//!     .
+//! Шаблонный класс статистики, предназначенный для доступа
+//! к основным функциям статистики. Все классы реализованы в виде шаблонов,
+//! позволяющие использовать различные типы данных.
 //!
-//! :
+//! Пример:
 //! @code
 //!    const int n = 10;
-//!    statistic<double> ex_d;        //   
+//!    statistic<double> ex_d;        // расчет статистики дробных
 //!    double d_data[n] = {1.234, 2.298, 4.355, 8.41, 10.54, 6.645, 11.36, 15.898, 12.999, 10.111};
 //!
-//!    //    ()
+//!    // заполнение очереди событиями (значениями)
 //!    for (int i = 0; i < n; ++i)
 //!       ex_d.GetStatEvents()->StatisticEvent(d_data[i]);
 //!
-//!    //   ,  ,  
-//!    ex_d.GetStatEvaluations()->VectorSum(ex_d.GetStatEvents()->GetParamsQueue());
-//!    ex_d.GetStatEvaluations()->VectorMinValue(ex_d.GetStatEvents()->GetParamsQueue());
-//!    ex_d.GetStatEvaluations()->VectorStdDeviation(ex_d.GetStatEvents()->GetParamsQueue());
+//!    // статическая оценка сумма, минимальное значение, среднеквадратическое отклонение
+//!    ex_d.GetStatEvaluations()->VectorSum(ex_d.GetStatEvents()->GetParamsView());
+//!    ex_d.GetStatEvaluations()->VectorMinValue(ex_d.GetStatEvents()->GetParamsView());
+//!    ex_d.GetStatEvaluations()->VectorStdDeviation(ex_d.GetStatEvents()->GetParamsView());
 //!
-//!    //   
+//!    // вывод статической оценки
 //!    cout << "Sum: " << ex_d.GetStatEvaluations()->GetSum() << ", "
 //!         << "Min: " << ex_d.GetStatEvaluations()->GetMin() << ", "
 //!         << "StdDeviation: " << ex_d.GetStatEvaluations()->GetStdDeviation() << endl;
 //! @endcode
 //!
-//! :
+//! Вывод:
 //! Sum: 83.85, Min: 1.234, StdDeviation: 9.51182
 //!
-template <class T> class statistic
+//! Статистика с выбранными при компиляции оценками без очереди событий -
+//! statistic<T, Policies...> (StatisticPolicies.h).
+template <class T> class statistic<T>
 {
 public:
 	statistic()
 	{
       m_statEvaluations = new statisticEvaluations<T>();
       m_statEvents = new statisticEvents<T>();
+      m_cachedEvaluations = 0;
 	}
 
    ~statistic()
    {
       delete m_statEvaluations;
       delete m_statEvents;
+      delete m_cachedEvaluations;
    }
 
-   //! @brief      
+   //! @brief Доступ к функциям расчета статической оценки
    statisticEvaluations<T>* GetStatEvaluations()
    {
       return m_statEvaluations;
    }
-   //! @brief      
+   //! @brief Доступ к функциям обработки очереди событий
    statisticEvents<T>* GetStatEvents()
    {
       return m_statEvents;
    }
+   //! @brief Доступ к оценкам очереди событий с кэшированием (создаются при первом обращении)
+   statisticCachedEvaluations<T>* GetCachedEvaluations()
+   {
+      if (!m_cachedEvaluations)
+         m_cachedEvaluations = new statisticCachedEvaluations<T>(m_statEvents);
+      return m_cachedEvaluations;
+   }
+
+   //!@name Снимок состояния (StatisticSnapshot.h): оценки и очередь событий
+   //@{
+   static uint32_t SnapshotKind()
+   {
+      return NStatisticEvaluations::SnapshotKind(eSnapshotStatistic, SnapshotValueType<T>());
+   }
+   void SaveState(statisticSnapshotWriter& writer) const
+   {
+      m_statEvaluations->SaveState(writer);
+      m_statEvents->SaveState(writer);
+   }
+   bool LoadState(statisticSnapshotReader& reader)
+   {
+      // the events are restored last, nothing is changed if they fail
+      statisticEvaluations<T> evaluations(*m_statEvaluations);
+      if (!evaluations.LoadState(reader) || !m_statEvents->LoadState(reader))
+         return false;
+
+      *m_statEvaluations = evaluations;
+      return true;
+   }
+   //@}
 private:
    // copy and assignment not allowed
    statistic(const statistic<T>&);
@@ -98,6 +135,7 @@ private:
 
    statisticEvaluations<T>* m_statEvaluations;
    statisticEvents<T>* m_statEvents;
+   statisticCachedEvaluations<T>* m_cachedEvaluations;
 };
 //
 }
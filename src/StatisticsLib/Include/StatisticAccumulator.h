@@ -0,0 +1,205 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticAccumulator_H___
+#define ___StatisticAccumulator_H___
+
+#include <math.h>
+
+#include "StatisticSnapshot.h"
+
+//
+namespace NStatisticEvaluations
+{
+//!@ingroup amgStatistic
+//! @brief Накопитель статистических оценок с обновлением за O(1)
+//!
+//! Шаблонный класс, обновляющий количество, сумму, минимум, максимум, среднее
+//! значение и сумму квадратов отклонений (M2) при каждом новом значении
+//! по рекуррентной формуле Велфорда. Не хранит сами значения.
+//!
+//! Пример:
+//! @code
+//!    statisticAccumulator<double> acc;
+//!    for (int i = 0; i < n; ++i)
+//!       acc.Add(d_data[i]);
+//!    cout << "Mean: " << acc.GetMean() << ", "
+//!         << "StdDeviation: " << acc.GetStdDeviation() << endl;
+//! @endcode
+template <class T> class statisticAccumulator
+{
+public:
+	statisticAccumulator() 
+		: m_count(0), m_sum(0), m_min(0), m_max(0), m_mean(0.0), m_m2(0.0) {}
+
+   //! @brief Добавление значения
+	void Add(T value);
+   //! @brief Добавление диапазона значений за один проход
+	template <class It> void AddRange(It first, It last);
+   //! @brief Объединение с другим накопителем (параллельная формула Чана)
+	void Merge(const statisticAccumulator<T>& other);
+   //! @brief Сброс всех значений
+	void Reset();
+
+   //!@name Методы получения текущих оценок
+   //@{
+	long long GetCount() const { return m_count; }
+	T GetSum() const { return m_sum; }
+	T GetMin() const { return m_min; }
+	T GetMax() const { return m_max; }
+	double GetMean() const { return m_mean; }
+	double GetM2() const { return m_m2; }
+	double GetDispersion() const { return m_count > 0 ? m_m2 / m_count : 0.0; }
+	double GetStdDeviation() const { return sqrt(GetDispersion()); }
+   //@}
+
+   //!@name Снимок состояния (StatisticSnapshot.h)
+   //@{
+	static uint32_t SnapshotKind() { return NStatisticEvaluations::SnapshotKind(eSnapshotAccumulator, SnapshotValueType<T>()); }
+	void SaveState(statisticSnapshotWriter& writer) const;
+	bool LoadState(statisticSnapshotReader& reader);
+   //@}
+
+private:
+	long long m_count;
+	T m_sum, m_min, m_max;
+	double m_mean, m_m2;                // mean and sum of squared deviations
+};
+
+// add value (Welford's recurrence)
+template <class T>
+void statisticAccumulator<T>::Add(T value)
+{
+	if (m_count == 0)
+		m_min = m_max = value;
+	else
+	{
+		m_min = value < m_min ? value : m_min;
+		m_max = value > m_max ? value : m_max;
+	}
+	++m_count;
+	m_sum += value;
+
+	const double delta = (double)value - m_mean;
+	m_mean += delta / m_count;
+	m_m2 += delta * ((double)value - m_mean);
+}
+
+// add range of values
+template <class T>
+template <class It>
+void statisticAccumulator<T>::AddRange(It first, It last)
+{
+	if (first == last)
+		return;
+
+	// partial accumulator of the range: moments around the first value
+	// (shifted data algorithm) in one pass, then merged into this one
+	statisticAccumulator<T> part;
+	const double shift = (double)*first;
+	T sum = 0, min = *first, max = *first;
+	double s1 = 0.0, s2 = 0.0;
+	long long n = 0;
+
+	for (; first != last; ++first, ++n)
+	{
+		const T x = *first;
+		sum += x;
+		min = x < min ? x : min;
+		max = x > max ? x : max;
+
+		const double d = (double)x - shift;
+		s1 += d;
+		s2 += d * d;
+	}
+
+	part.m_count = n;
+	part.m_sum = sum;
+	part.m_min = min;
+	part.m_max = max;
+	part.m_mean = shift + s1 / n;
+	part.m_m2 = s2 - s1 * s1 / n;
+	if (part.m_m2 < 0.0)
+		part.m_m2 = 0.0;
+
+	Merge(part);
+}
+
+// merge accumulators (Chan et al. parallel variance)
+template <class T>
+void statisticAccumulator<T>::Merge(const statisticAccumulator<T>& other)
+{
+	if (other.m_count == 0)
+		return;
+	if (m_count == 0)
+	{
+		*this = other;
+		return;
+	}
+
+	const long long count = m_count + other.m_count;
+	const double delta = other.m_mean - m_mean;
+
+	m_min = other.m_min < m_min ? other.m_min : m_min;
+	m_max = other.m_max > m_max ? other.m_max : m_max;
+	m_sum += other.m_sum;
+	m_mean += delta * other.m_count / count;
+	m_m2 += other.m_m2 + delta * delta * ((double)m_count * other.m_count / count);
+	m_count = count;
+}
+
+// clean all accumulated data
+template <class T>
+void statisticAccumulator<T>::Reset()
+{
+	m_count = 0;
+	m_sum = m_min = m_max = 0;
+	m_mean = m_m2 = 0.0;
+}
+
+// snapshot
+template <class T>
+void statisticAccumulator<T>::SaveState(statisticSnapshotWriter& writer) const
+{
+	writer.Put(m_count);
+	writer.Put(m_sum);
+	writer.Put(m_min);
+	writer.Put(m_max);
+	writer.Put(m_mean);
+	writer.Put(m_m2);
+}
+
+template <class T>
+bool statisticAccumulator<T>::LoadState(statisticSnapshotReader& reader)
+{
+	statisticAccumulator<T> state;
+	if (!reader.Get(state.m_count) || !reader.Get(state.m_sum) || !reader.Get(state.m_min)
+		|| !reader.Get(state.m_max) || !reader.Get(state.m_mean) || !reader.Get(state.m_m2))
+		return false;
+	if (state.m_count < 0 || !(state.m_m2 >= 0.0))
+		return reader.Fail();
+
+	*this = state;
+	return true;
+}
+//
+}
+//
+#endif /* ___StatisticAccumulator_H___ */
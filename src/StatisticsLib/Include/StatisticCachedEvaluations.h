@@ -0,0 +1,138 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticCachedEvaluations_H___
+#define ___StatisticCachedEvaluations_H___
+
+#include <math.h>
+
+#include "StatisticAccumulator.h"
+#include "StatisticEvents.h"
+
+//
+namespace NStatisticEvaluations
+{
+//!@ingroup amgStatistic
+//! @brief Оценки очереди событий с кэшированием и досчетом новых событий
+//!
+//! Привязывается к очереди событий и запоминает, какая ее часть уже учтена.
+//! При запросе оценок учитываются только события, добавленные после предыдущего
+//! запроса; если очередь не изменилась, возвращаются сохраненные значения.
+//! После сброса или изменения емкости очереди, а также после вытеснения событий
+//! из ограниченной очереди, оценки пересчитываются по всей очереди.
+//! В отличие от statisticEvaluations, значения прошлых расчетов не накапливаются.
+//!
+//! Пример:
+//! @code
+//!    statistic<double> ex_d;
+//!    statisticCachedEvaluations<double>* cached = ex_d.GetCachedEvaluations();
+//!    ...
+//!    // опрос раз в секунду: обрабатываются только новые события
+//!    cout << "Mean: " << cached->GetMean() << endl;
+//! @endcode
+template <class T> class statisticCachedEvaluations
+{
+public:
+	explicit statisticCachedEvaluations(const NStatisticEvents::statisticEvents<T>* events = 0)
+		: m_events(events), m_generation(0), m_sequence(0), m_valid(false),
+		  m_fullEvaluations(0), m_tailEvaluations(0) {}
+
+   //! @brief Привязка к очереди событий
+	void Bind(const NStatisticEvents::statisticEvents<T>* events) { m_events = events; Invalidate(); }
+   //! @brief Сброс сохраненных оценок (следующий запрос - полный пересчет)
+	void Invalidate() { m_valid = false; }
+   //! @brief Оценки учитывают все события очереди
+	bool IsUpToDate() const;
+
+   //! @brief Текущие оценки очереди событий
+	const statisticAccumulator<T>& GetStatistics() { Refresh(); return m_accumulator; }
+
+   //!@name Методы получения текущих оценок
+   //@{
+	long long GetCount() { return GetStatistics().GetCount(); }
+	T GetSum() { return GetStatistics().GetSum(); }
+	T GetMin() { return GetStatistics().GetMin(); }
+	T GetMax() { return GetStatistics().GetMax(); }
+	double GetMean() { return GetStatistics().GetMean(); }
+	double GetDispersion() { return GetStatistics().GetDispersion(); }
+	double GetStdDeviation() { return GetStatistics().GetStdDeviation(); }
+   //@}
+
+   //!@name Количество полных пересчетов и досчетов (для контроля)
+   //@{
+	unsigned long long GetFullEvaluationsCount() const { return m_fullEvaluations; }
+	unsigned long long GetTailEvaluationsCount() const { return m_tailEvaluations; }
+   //@}
+
+private:
+	void Refresh();
+
+	const NStatisticEvents::statisticEvents<T>* m_events;
+	statisticAccumulator<T> m_accumulator;
+	unsigned long long m_generation;    // processed history version and position
+	unsigned long long m_sequence;
+	bool m_valid;
+
+	unsigned long long m_fullEvaluations;
+	unsigned long long m_tailEvaluations;
+};
+
+// up to date
+template <class T>
+bool statisticCachedEvaluations<T>::IsUpToDate() const
+{
+	return m_events && m_valid && m_generation == m_events->GetHistoryGeneration()
+		&& m_sequence == m_events->GetHistorySequence();
+}
+
+// fold in the new tail or evaluate the whole history
+template <class T>
+void statisticCachedEvaluations<T>::Refresh()
+{
+	if (!m_events || IsUpToDate())
+		return;
+
+	const unsigned long long generation = m_events->GetHistoryGeneration();
+	const unsigned long long sequence = m_events->GetHistorySequence();
+	const statisticSpan<const T> history = m_events->GetParamsView();
+
+	// the tail is at the end of the storage while nothing has been evicted
+	if (m_valid && generation == m_generation && sequence > m_sequence && history.Size() == sequence)
+	{
+		const size_t tail = static_cast<size_t>(sequence - m_sequence);
+		const statisticSpan<const T> added = history.Subspan(history.Size() - tail, tail);
+		m_accumulator.AddRange(added.begin(), added.end());
+		++m_tailEvaluations;
+	}
+	else
+	{
+		m_accumulator.Reset();
+		m_accumulator.AddRange(history.begin(), history.end());
+		++m_fullEvaluations;
+	}
+
+	m_generation = generation;
+	m_sequence = sequence;
+	m_valid = true;
+}
+//
+}
+//
+#endif /* ___StatisticCachedEvaluations_H___ */
@@ -0,0 +1,69 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticClock_H___
+#define ___StatisticClock_H___
+
+#include <chrono>
+
+//
+namespace NStatisticEvents
+{
+//!@ingroup amgStatistic
+//! @brief Источник времени событий
+enum EClockType
+{
+	eClockSteady = 0,                   //!< std::chrono::steady_clock
+	eClockTsc                           //!< счетчик тактов процессора (TSC), калибруется один раз
+};
+
+//! @brief Монотонное время в наносекундах (steady_clock)
+inline long long SteadyClockNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//!@ingroup amgStatistic
+//! @brief Время по счетчику тактов процессора (TSC)
+//!
+//! При первом обращении частота TSC калибруется по steady_clock, после чего
+//! получение времени сводится к чтению счетчика и целочисленному умножению.
+//! Если инвариантный TSC недоступен, используется steady_clock.
+class statisticTscClock
+{
+public:
+   //! @brief Доступность инвариантного TSC
+	static bool Available();
+   //! @brief Время в наносекундах (в той же шкале, что и SteadyClockNs)
+	static long long NowNs();
+   //! @brief Количество тактов в секунду (по результатам калибровки)
+	static double TicksPerSecond();
+};
+
+//! @brief Время в наносекундах по выбранному источнику
+inline long long StatisticClockNs(EClockType clock)
+{
+	return clock == eClockTsc ? statisticTscClock::NowNs() : SteadyClockNs();
+}
+//
+}
+//
+#endif /* ___StatisticClock_H___ */
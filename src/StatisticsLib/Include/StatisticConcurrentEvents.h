@@ -0,0 +1,310 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticConcurrentEvents_H___
+#define ___StatisticConcurrentEvents_H___
+
+#include <cstddef>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstring>
+#include <stdint.h>
+
+#include "StatisticAccumulator.h"
+
+//
+namespace NStatisticEvents
+{
+// process wide ordinal of the calling thread (1, 2, 3, ...)
+inline unsigned StatisticThreadOrdinal()
+{
+	static std::atomic<unsigned> next(1);
+	static thread_local unsigned ordinal = next.fetch_add(1, std::memory_order_relaxed);
+	return ordinal;
+}
+
+// Shards claimed by one thread. The claims are released when the thread exits,
+// unless their statisticConcurrentEvents has been destroyed before (the live
+// instances are tracked by id in StatisticConcurrentEvents.cpp).
+struct statisticShardClaims
+{
+	struct claim
+	{
+		uint64_t instance;
+		void* shard;
+		std::atomic<unsigned>* owner;
+	};
+
+	statisticShardClaims() : pruneAt(16) {}
+	~statisticShardClaims();
+
+	// shard of the instance claimed by this thread (0 - none)
+	void* Find(uint64_t instance) const
+	{
+		for (size_t i = claims.size(); i > 0; --i)
+		{
+			if (claims[i - 1].instance == instance)
+				return claims[i - 1].shard;
+		}
+		return 0;
+	}
+	// the claims of destroyed instances are dropped from time to time
+	void Add(uint64_t instance, void* shard, std::atomic<unsigned>* owner);
+
+	std::vector<claim> claims;
+	size_t pruneAt;
+};
+
+inline statisticShardClaims& ThreadShardClaims()
+{
+	static thread_local statisticShardClaims claims;
+	return claims;
+}
+
+// ids of the live instances
+uint64_t RegisterShardedInstance();
+void UnregisterShardedInstance(uint64_t instance);
+
+//!@ingroup amgStatistic
+//! @brief Многопоточный прием событий с разбиением по потокам (shards)
+//!
+//! Каждый поток записывает события в собственный накопитель (shard), выровненный
+//! по кэш-линии, без блокировок и без общих атомарных переменных. Оценки
+//! объединяются по запросу читателя (GetStatistics). Накопитель закрепляется
+//! за потоком при первом событии и освобождается при завершении потока, накопленные
+//! оценки остаются в нем. Если работающих потоков больше, чем накопителей, лишние
+//! потоки записывают события под общей блокировкой.
+//!
+//! Пример:
+//! @code
+//!    statisticConcurrentEvents<double> events(64);
+//!
+//!    // рабочие потоки
+//!    events.StatisticEvent(latency);
+//!
+//!    // поток мониторинга
+//!    statisticAccumulator<double> current = events.GetStatistics();
+//!    cout << "Mean: " << current.GetMean() << endl;
+//! @endcode
+template <class T> class statisticConcurrentEvents
+{
+public:
+   /*!@brief Конструктор
+   * @param[in] shards Количество накопителей (0 - по два на аппаратный поток)
+   */
+	explicit statisticConcurrentEvents(size_t shards = 0);
+	~statisticConcurrentEvents();
+
+   //! @brief Регистрация события (может вызываться из любого потока)
+	void StatisticEvent(T parameter);
+   //! @brief Объединенные оценки всех потоков
+	NStatisticEvaluations::statisticAccumulator<T> GetStatistics() const;
+   //! @brief Количество событий
+	long long EventsCount() const { return GetStatistics().GetCount(); }
+	size_t ShardsCount() const { return m_shards.size(); }
+   //! @brief Количество накопителей, закрепленных за работающими потоками
+	size_t ClaimedShardsCount() const;
+   //! @brief Количество событий, записанных под общей блокировкой (нет свободного накопителя)
+	long long OverflowEventsCount() const;
+
+   //! @brief Сброс всех значений (не должен выполняться одновременно с записью)
+	void ResetAllEventsData();
+
+private:
+	// copy and assignment not allowed
+	statisticConcurrentEvents(const statisticConcurrentEvents<T>&);
+	statisticConcurrentEvents<T>& operator=(const statisticConcurrentEvents<T>&);
+
+	typedef NStatisticEvaluations::statisticAccumulator<T> accumulator;
+
+	static const size_t c_cacheLine = 64;
+	static const size_t c_words = (sizeof(accumulator) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	// One writer per shard. The owner updates its private accumulator and
+	// publishes it word by word; readers copy the published words under a
+	// sequence lock, so neither side ever waits for the other.
+	struct shard
+	{
+		shard() : owner(0), sequence(0)
+		{
+			for (size_t i = 0; i < c_words; ++i)
+				published[i].store(0, std::memory_order_relaxed);
+		}
+
+		void Publish()
+		{
+			uint64_t words[c_words] = {};
+			memcpy(words, &local, sizeof(local));
+			for (size_t i = 0; i < c_words; ++i)
+				published[i].store(words[i], std::memory_order_relaxed);
+		}
+
+		accumulator Read() const
+		{
+			uint64_t words[c_words];
+			for (size_t i = 0; i < c_words; ++i)
+				words[i] = published[i].load(std::memory_order_relaxed);
+
+			accumulator copy;
+			memcpy(&copy, words, sizeof(copy));
+			return copy;
+		}
+
+		char padBefore[c_cacheLine];
+		std::atomic<unsigned> owner;            // ordinal of the owning thread
+		std::atomic<unsigned> sequence;         // odd while an update is in progress
+		accumulator local;                      // written by the owner only
+		std::atomic<uint64_t> published[c_words];
+		char padAfter[c_cacheLine];
+	};
+
+	shard* ClaimShard(unsigned ordinal);
+
+	std::vector<shard> m_shards;
+	uint64_t m_instance;                    // id for the claims of the threads
+
+	mutable std::mutex m_overflowMutex;     // threads without a shard
+	accumulator m_overflow;
+};
+
+template <class T>
+statisticConcurrentEvents<T>::statisticConcurrentEvents(size_t shards)
+	: m_shards(shards ? shards : 2 * (std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 8)),
+	  m_instance(RegisterShardedInstance())
+{
+}
+
+template <class T>
+statisticConcurrentEvents<T>::~statisticConcurrentEvents()
+{
+	UnregisterShardedInstance(m_instance);
+}
+
+// claim a free shard, the claim is kept by the thread until it exits
+template <class T>
+typename statisticConcurrentEvents<T>::shard* statisticConcurrentEvents<T>::ClaimShard(unsigned ordinal)
+{
+	const size_t count = m_shards.size();
+	const size_t start = ordinal % count;
+	for (size_t i = 0; i < count; ++i)
+	{
+		shard& candidate = m_shards[start + i < count ? start + i : start + i - count];
+		unsigned owner = candidate.owner.load(std::memory_order_relaxed);
+		// acquire: the accumulator of the previous owner is complete
+		if (owner == 0 && candidate.owner.compare_exchange_strong(owner, ordinal, std::memory_order_acquire))
+		{
+			ThreadShardClaims().Add(m_instance, &candidate, &candidate.owner);
+			return &candidate;
+		}
+	}
+	return 0;
+}
+
+// statistic event
+template <class T>
+void statisticConcurrentEvents<T>::StatisticEvent(T parameter)
+{
+	shard* own = static_cast<shard*>(ThreadShardClaims().Find(m_instance));
+	if (!own)
+		own = ClaimShard(StatisticThreadOrdinal());
+	if (!own)
+	{
+		std::lock_guard<std::mutex> lock(m_overflowMutex);
+		m_overflow.Add(parameter);
+		return;
+	}
+
+	const unsigned sequence = own->sequence.load(std::memory_order_relaxed);
+	own->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	own->local.Add(parameter);
+	own->Publish();
+
+	own->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// merge all shards
+template <class T>
+NStatisticEvaluations::statisticAccumulator<T> statisticConcurrentEvents<T>::GetStatistics() const
+{
+	NStatisticEvaluations::statisticAccumulator<T> result;
+	for (size_t i = 0; i < m_shards.size(); ++i)
+	{
+		const shard& current = m_shards[i];
+		accumulator copy;
+		unsigned before, after = 0;
+		do
+		{
+			before = current.sequence.load(std::memory_order_acquire);
+			if (before & 1)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			copy = current.Read();
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = current.sequence.load(std::memory_order_relaxed);
+		} while ((before & 1) || before != after);
+
+		result.Merge(copy);
+	}
+
+	std::lock_guard<std::mutex> lock(m_overflowMutex);
+	result.Merge(m_overflow);
+	return result;
+}
+
+template <class T>
+size_t statisticConcurrentEvents<T>::ClaimedShardsCount() const
+{
+	size_t claimed = 0;
+	for (size_t i = 0; i < m_shards.size(); ++i)
+		claimed += m_shards[i].owner.load(std::memory_order_relaxed) != 0;
+
+	return claimed;
+}
+
+template <class T>
+long long statisticConcurrentEvents<T>::OverflowEventsCount() const
+{
+	std::lock_guard<std::mutex> lock(m_overflowMutex);
+	return m_overflow.GetCount();
+}
+
+// clean all events data
+template <class T>
+void statisticConcurrentEvents<T>::ResetAllEventsData()
+{
+	for (size_t i = 0; i < m_shards.size(); ++i)
+	{
+		m_shards[i].local.Reset();
+		m_shards[i].Publish();
+	}
+
+	std::lock_guard<std::mutex> lock(m_overflowMutex);
+	m_overflow.Reset();
+}
+//
+}
+//
+#endif /* ___StatisticConcurrentEvents_H___ */
@@ -23,18 +23,45 @@
 #include <iostream>
 #include <queue>
 #include <vector>
+#include <iterator>
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+#include "StatisticSpan.h"
+#include "StatisticKernels.h"
+#include "StatisticAccumulator.h"
+#include "StatisticThreadPool.h"
+#include "StatisticRadixSort.h"
+#include "StatisticInstrumentation.h"
 
 //
 namespace NStatisticEvaluations
 {
 //!@ingroup amgStatistic
-//! @brief   
+//! @brief Сводка статистических оценок, полученная за один проход по данным
 //!
-//!  ,     
-//!    : , ,   .. 
-//!      .    .
+//! Результат метода statisticEvaluations::Summarize: сумма, минимум, максимум,
+//! среднее значение, дисперсия и среднеквадратическое отклонение.
+template <class T> struct statisticSummary
+{
+	statisticSummary() 
+		: count(0), sum(0), min(0), max(0), 
+		  mean(0.0), dispersion(0.0), std_deviation(0.0) {}
+
+	int count;              // number of processed values
+	T sum, min, max;
+	double mean, dispersion, std_deviation;
+};
+
+//!@ingroup amgStatistic
+//! @brief Класс статической оценки
+//!
+//! Шаблонный класс, предназначенный для расчета основных 
+//! функций оценки статических данных: сумма, среднее, дисперсия и т.д. 
+//! Также позволяет получить значения расчитынных оценок. Работает с очередью событий.
 //! 
-//! :
+//! Пример:
 //! @code
 //!    statistic<int> ex1;
 //!    int i_data[n] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
@@ -50,38 +77,119 @@ template <class T> class statisticEvaluations
 public:
 	statisticEvaluations() 
 		: m_sum(0), m_min(0), m_max(0), m_mean(0), 
-		  m_dispersion(0), m_math_expectation(0), m_std_deviation(0) {}
+		  m_dispersion(0), m_math_expectation(0), m_std_deviation(0),
+		  m_parallelThreshold(0), m_pool(0),
+		  m_summationMode(NStatisticKernels::eSummationPairwise) {}
 
 	// statistic parameters evaluation
     // delete after all ;)
-    T Sum(T* data, const int n);
-    T MeanValue(T* data, const int n);
-	T Min(T* data, const int n);
-	T Max(T* data, const int n);
-	T Dispersion(T* data, const int n);
-	double StdDeviation(T* data, const int n);
-	T MathExpectation(T* data, const int n);
+    T Sum(const T* data, const int n);
+    T MeanValue(const T* data, const int n);
+	T Min(const T* data, const int n);
+	T Max(const T* data, const int n);
+	T Dispersion(const T* data, const int n);
+	double StdDeviation(const T* data, const int n);
+	T MathExpectation(const T* data, const int n);
+   //! @brief Расчет всех оценок (сумма, минимум, максимум, среднее, дисперсия,
+   //! ср. кв. отклонение) за один проход по массиву
+	statisticSummary<T> Summarize(const T* data, const int n);
 
 	// statistic parameters event evaluation
-   //! @brief     ( )
-	T VectorSum(std::vector<T> data);
-   //! @brief      ( )
-	T VectorMeanValue(std::vector<T> data);
-   //! @brief      ( )
-	T VectorMinValue(std::vector<T> data);
-   //! @brief      ( )
-	T VectorMaxValue(std::vector<T> data);
-   //! @brief      ( )
-	T VectorDispersion(std::vector<T> data);
-   //! @brief     ( )
-	double VectorStdDeviation(std::vector<T> data);
-   //! @brief      ( )
-	T VectorMathExpectation(std::vector<T> data);
-
-   //! @brief   
+	// (vector, span and iterator pair versions, the data is never copied)
+   //! @brief Подсчет суммы набора событий (очередь событий)
+	T VectorSum(const std::vector<T>& data) { return VectorSum(statisticSpan<const T>(data)); }
+	T VectorSum(statisticSpan<const T> data) { return VectorSum(data.begin(), data.end()); }
+	template <class It> T VectorSum(It first, It last);
+   //! @brief Подсчет среднего значения набора событий (очередь событий)
+	T VectorMeanValue(const std::vector<T>& data) { return VectorMeanValue(statisticSpan<const T>(data)); }
+	T VectorMeanValue(statisticSpan<const T> data) { return VectorMeanValue(data.begin(), data.end()); }
+	template <class It> T VectorMeanValue(It first, It last);
+   //! @brief Подсчет минимального значения набора событий (очередь событий)
+	T VectorMinValue(const std::vector<T>& data) { return VectorMinValue(statisticSpan<const T>(data)); }
+	T VectorMinValue(statisticSpan<const T> data) { return VectorMinValue(data.begin(), data.end()); }
+	template <class It> T VectorMinValue(It first, It last);
+   //! @brief Подсчет среднего значения набора событий (очередь событий)
+	T VectorMaxValue(const std::vector<T>& data) { return VectorMaxValue(statisticSpan<const T>(data)); }
+	T VectorMaxValue(statisticSpan<const T> data) { return VectorMaxValue(data.begin(), data.end()); }
+	template <class It> T VectorMaxValue(It first, It last);
+   //! @brief Подсчет математического ожидания набора событий (очередь событий)
+	T VectorDispersion(const std::vector<T>& data) { return VectorDispersion(statisticSpan<const T>(data)); }
+	T VectorDispersion(statisticSpan<const T> data) { return VectorDispersion(data.begin(), data.end()); }
+	template <class It> T VectorDispersion(It first, It last);
+   //! @brief Подсчет дисперсии набора событий (очередь событий)
+	double VectorStdDeviation(const std::vector<T>& data) { return VectorStdDeviation(statisticSpan<const T>(data)); }
+	double VectorStdDeviation(statisticSpan<const T> data) { return VectorStdDeviation(data.begin(), data.end()); }
+	template <class It> double VectorStdDeviation(It first, It last);
+   //! @brief Подсчет среднего отклонения набора событий (очередь событий)
+	T VectorMathExpectation(const std::vector<T>& data) { return VectorMathExpectation(statisticSpan<const T>(data)); }
+	T VectorMathExpectation(statisticSpan<const T> data) { return VectorMathExpectation(data.begin(), data.end()); }
+	template <class It> T VectorMathExpectation(It first, It last);
+   //! @brief Расчет всех оценок за один проход по вектору данных (очереди событий)
+	statisticSummary<T> VectorSummarize(const std::vector<T>& data) { return VectorSummarize(statisticSpan<const T>(data)); }
+	statisticSummary<T> VectorSummarize(statisticSpan<const T> data) { return VectorSummarize(data.begin(), data.end()); }
+	template <class It> statisticSummary<T> VectorSummarize(It first, It last);
+
+	// order statistics: the data is copied into a scratch buffer kept between the
+	// calls and partially ordered there by selection (a parallel radix sort in the
+	// parallel mode); quantiles use linear interpolation between order statistics
+   //! @brief Квантиль уровня q из [0, 1]
+	double Quantile(const T* data, const int n, double q) { return VectorQuantile(data, data + n, q); }
+	double VectorQuantile(const std::vector<T>& data, double q) { return VectorQuantile(statisticSpan<const T>(data), q); }
+	double VectorQuantile(statisticSpan<const T> data, double q) { return VectorQuantile(data.begin(), data.end(), q); }
+	template <class It> double VectorQuantile(It first, It last, double q);
+   /*!@brief Несколько квантилей за один проход разбиения
+   * @param[in] q Уровни квантилей из [0, 1] (ограничиваются отрезком, для NaN квантиль - NaN)
+   * @param[out] out Значения квантилей
+   * @param[in] count Количество квантилей
+   */
+	void VectorQuantiles(statisticSpan<const T> data, const double* q, double* out, size_t count)
+	{
+		VectorQuantiles(data.begin(), data.end(), q, out, count);
+	}
+	template <class It> void VectorQuantiles(It first, It last, const double* q, double* out, size_t count);
+   //! @brief Медиана
+	double Median(const T* data, const int n) { return VectorMedian(data, data + n); }
+	double VectorMedian(const std::vector<T>& data) { return VectorMedian(statisticSpan<const T>(data)); }
+	double VectorMedian(statisticSpan<const T> data) { return VectorMedian(data.begin(), data.end()); }
+	template <class It> double VectorMedian(It first, It last) { return VectorQuantile(first, last, 0.5); }
+   //! @brief Интерквартильный размах (Q3 - Q1)
+	double VectorInterquartileRange(const std::vector<T>& data) { return VectorInterquartileRange(statisticSpan<const T>(data)); }
+	double VectorInterquartileRange(statisticSpan<const T> data) { return VectorInterquartileRange(data.begin(), data.end()); }
+	template <class It> double VectorInterquartileRange(It first, It last);
+   //! @brief Медианное абсолютное отклонение (медиана |x - медиана|)
+	double VectorMedianAbsoluteDeviation(const std::vector<T>& data)
+	{
+		return VectorMedianAbsoluteDeviation(statisticSpan<const T>(data));
+	}
+	double VectorMedianAbsoluteDeviation(statisticSpan<const T> data)
+	{
+		return VectorMedianAbsoluteDeviation(data.begin(), data.end());
+	}
+	template <class It> double VectorMedianAbsoluteDeviation(It first, It last);
+
+   /*!@brief Режим параллельного расчета оценок непрерывных данных (массив, вектор, span)
+   * @param[in] threshold Минимальное количество элементов для параллельного расчета
+   * (0 - параллельный расчет отключен)
+   * @param[in] pool Пул потоков (0 - общий пул процесса)
+   */
+	void SetParallelEvaluation(size_t threshold, statisticThreadPool* pool = 0);
+   /*!@brief Способ суммирования непрерывных данных (сумма, среднее, дисперсия).
+   * По умолчанию - блочное попарное суммирование (eSummationPairwise)
+   */
+	void SetSummationMode(NStatisticKernels::ESummationMode mode) { m_summationMode = mode; }
+	NStatisticKernels::ESummationMode GetSummationMode() const { return m_summationMode; }
+
+   //! @brief Сброс всех значений
 	void ResetAllStatData();
 
-   //!@name  /   
+   //!@name Снимок состояния (StatisticSnapshot.h): оценки и способ суммирования
+   //@{
+	static uint32_t SnapshotKind() { return NStatisticEvaluations::SnapshotKind(eSnapshotEvaluations, SnapshotValueType<T>()); }
+	void SaveState(statisticSnapshotWriter& writer) const;
+	bool LoadState(statisticSnapshotReader& reader);
+   //@}
+
+   //!@name Методы получения/установки значений статических оценок
    //@{
 	// get/set statistic parameters functions
 	T GetSum();
@@ -101,174 +209,492 @@ public:
    //@}
 
 private:
+	// evaluation loops shared by the array, vector and span versions
+	template <class It> static T SumOf(It first, It last);
+	template <class It> static T MinOf(It first, It last);
+	template <class It> static T MaxOf(It first, It last);
+	template <class It> static T SquaredDeviationOf(It first, It last, T mean);
+	template <class It> static statisticAccumulator<T> AccumulateOf(It first, It last);
+	// contiguous data goes to the vectorized kernels, large arrays are split
+	// between the threads of the pool in the parallel mode
+	T SumOf(const T* first, const T* last) const;
+	T MinOf(const T* first, const T* last) const;
+	T MaxOf(const T* first, const T* last) const;
+	T SquaredDeviationOf(const T* first, const T* last, T mean) const;
+	statisticAccumulator<T> AccumulateOf(const T* first, const T* last) const;
+
+	// evaluate map() over parts of the array in parallel and combine the results
+	template <class R, class Map, class Combine>
+	R ParallelReduce(const T* data, size_t n, Map map, Combine combine) const;
+	bool IsParallel(size_t n) const { return m_parallelThreshold && n >= m_parallelThreshold; }
+
+	// put the order statistics of the given sorted ranks in place in the scratch buffer
+	template <class V> void SelectRanks(std::vector<V>& values, std::vector<V>& buffer);
+	template <class V> static void MultiSelect(V* first, V* last, size_t offset,
+		const size_t* rankFirst, const size_t* rankLast);
+	// ranks of the quantiles q, then interpolation between the selected values;
+	// the levels are clamped to [0, 1], a NaN level has no rank and a NaN quantile
+	static bool QuantileLevel(double q, double& level)
+	{
+		level = q < 0.0 ? 0.0 : (q > 1.0 ? 1.0 : q);
+		return q == q;
+	}
+	void QuantileRanks(size_t n, const double* q, size_t count);
+	template <class V> void InterpolateQuantiles(const std::vector<V>& values, const double* q,
+		double* out, size_t count) const;
+
+	static const size_t c_maxParallelParts = 256;
 
 	T m_sum, m_min, m_max, m_mean, m_dispersion, m_math_expectation;
 	double m_std_deviation;
+
+	size_t m_parallelThreshold;         // parallel evaluation mode
+	statisticThreadPool* m_pool;
+	NStatisticKernels::ESummationMode m_summationMode;
+
+	std::vector<T> m_scratch;           // order statistics buffers, reused between calls
+	std::vector<T> m_sortBuffer;
+	std::vector<double> m_deviations;
+	std::vector<double> m_deviationsBuffer;
+	std::vector<size_t> m_ranks;
 };
 
-// sum value
+// evaluation loops
 template <class T>
-T statisticEvaluations<T>::Sum(T *data, const int n)
+template <class It>
+T statisticEvaluations<T>::SumOf(It first, It last)
 {
-	for (int i = 0; i < n; ++i)
-		m_sum += data[i];
+	T sum = 0;
+	for (; first != last; ++first)
+		sum += *first;
 
-	return m_sum;
+	return sum;
 }
 template <class T>
-T  statisticEvaluations<T>::VectorSum(std::vector<T> data)
+template <class It>
+T statisticEvaluations<T>::MinOf(It first, It last)
 {
-	for (int i = 0; i < static_cast<int>(data.size()); ++i)
-		m_sum += data.at(i);
+	T min = *first;
+	for (++first; first != last; ++first)
+		min = *first < min ? *first : min;
 
-	return m_sum;
+	return min;
 }
-// mean value
 template <class T>
-T  statisticEvaluations<T>::MeanValue(T *data, const int n)
+template <class It>
+T statisticEvaluations<T>::MaxOf(It first, It last)
 {
-	T sum = 0;
-	for (int i = 0; i < n; ++i)
-		sum += data[i];
+	T max = *first;
+	for (++first; first != last; ++first)
+		max = *first > max ? *first : max;
 
-	m_mean = sum / n; // float
-
-	return m_mean;
+	return max;
 }
 template <class T>
-T statisticEvaluations<T>::VectorMeanValue(std::vector<T> data)
+template <class It>
+T statisticEvaluations<T>::SquaredDeviationOf(It first, It last, T mean)
 {
 	T sum = 0;
-	int size = data.size();
+	for (; first != last; ++first)
+	{
+		const T k = *first - mean;
+		sum += k * k;
+	}
 
-	for (int i = 0; i < size; ++i)
-		sum += data.at(i);
+	return sum;
+}
 
-	m_mean = sum / size;	//  int
+template <class T>
+template <class It>
+statisticAccumulator<T> statisticEvaluations<T>::AccumulateOf(It first, It last)
+{
+	statisticAccumulator<T> accumulator;
+	accumulator.AddRange(first, last);
 
-	return m_mean;
+	return accumulator;
+}
+
+// parallel evaluation
+template <class T>
+void statisticEvaluations<T>::SetParallelEvaluation(size_t threshold, statisticThreadPool* pool)
+{
+	m_parallelThreshold = threshold;
+	m_pool = pool;
 }
-// min value
 template <class T>
-T statisticEvaluations<T>::Min(T* data, const int n)
+template <class R, class Map, class Combine>
+R statisticEvaluations<T>::ParallelReduce(const T* data, size_t n, Map map, Combine combine) const
 {
-	int imin;
-	for (int i = imin = 0; i < n; ++i)
-		if (data[i] < data[imin])
-			imin = i; // int forever
+	statisticThreadPool& pool = m_pool ? *m_pool : statisticThreadPool::Instance();
+
+	// a few parts per thread to even out the load, none shorter than the threshold
+	size_t parts = 4 * pool.ThreadsCount();
+	if (parts > n / m_parallelThreshold)
+		parts = n / m_parallelThreshold;
+	if (parts > c_maxParallelParts)
+		parts = c_maxParallelParts;
+	if (parts < 2)
+		return map(data, n);
+
+	R partial[c_maxParallelParts];
+	const size_t chunk = n / parts;
+	pool.ParallelFor(parts, [&](size_t i)
+	{
+		const size_t begin = i * chunk;
+		const size_t size = i + 1 == parts ? n - begin : chunk;
+		partial[i] = map(data + begin, size);
+	});
 
-	m_min = data[imin];
+	R result = partial[0];
+	for (size_t i = 1; i < parts; ++i)
+		result = combine(result, partial[i]);
 
-	return m_min;
+	return result;
+}
+
+// contiguous data
+template <class T>
+T statisticEvaluations<T>::SumOf(const T* first, const T* last) const
+{
+	const size_t n = last - first;
+	const NStatisticKernels::ESummationMode mode = m_summationMode;
+	if (!IsParallel(n))
+		return NStatisticKernels::Sum(first, n, mode);
+
+	return ParallelReduce<T>(first, n,
+		[mode](const T* data, size_t size) { return NStatisticKernels::Sum(data, size, mode); },
+		[](T a, T b) { return a + b; });
 }
 template <class T>
-T statisticEvaluations<T>::VectorMinValue(std::vector<T> data)
+T statisticEvaluations<T>::MinOf(const T* first, const T* last) const
 {
-	int imin;
-	for (int i = imin = 0; i < static_cast<int>(data.size()); ++i)
-		if (data.at(i) < data.at(imin))
-			imin = i; // int forever
+	const size_t n = last - first;
+	if (!IsParallel(n))
+		return NStatisticKernels::Min(first, n);
 
-	m_min = data.at(imin);
+	return ParallelReduce<T>(first, n,
+		[](const T* data, size_t size) { return NStatisticKernels::Min(data, size); },
+		[](T a, T b) { return b < a ? b : a; });
+}
+template <class T>
+T statisticEvaluations<T>::MaxOf(const T* first, const T* last) const
+{
+	const size_t n = last - first;
+	if (!IsParallel(n))
+		return NStatisticKernels::Max(first, n);
 
-	return m_min;
+	return ParallelReduce<T>(first, n,
+		[](const T* data, size_t size) { return NStatisticKernels::Max(data, size); },
+		[](T a, T b) { return b > a ? b : a; });
+}
+template <class T>
+T statisticEvaluations<T>::SquaredDeviationOf(const T* first, const T* last, T mean) const
+{
+	const size_t n = last - first;
+	const NStatisticKernels::ESummationMode mode = m_summationMode;
+	if (!IsParallel(n))
+		return NStatisticKernels::SquaredDeviation(first, n, mean, mode);
+
+	return ParallelReduce<T>(first, n,
+		[mean, mode](const T* data, size_t size)
+		{
+			return NStatisticKernels::SquaredDeviation(data, size, mean, mode);
+		},
+		[](T a, T b) { return a + b; });
 }
+template <class T>
+statisticAccumulator<T> statisticEvaluations<T>::AccumulateOf(const T* first, const T* last) const
+{
+	const size_t n = last - first;
+	if (!IsParallel(n))
+		return AccumulateOf<const T*>(first, last);
 
-// max value
+	return ParallelReduce<statisticAccumulator<T> >(first, n,
+		[](const T* data, size_t size) { return AccumulateOf<const T*>(data, data + size); },
+		[](statisticAccumulator<T> a, const statisticAccumulator<T>& b) { a.Merge(b); return a; });
+}
+
+// sum value
+template <class T>
+T statisticEvaluations<T>::Sum(const T *data, const int n)
+{
+	return VectorSum(data, data + n);
+}
 template <class T>
-T statisticEvaluations<T>::Max(T* data, const int n)
+template <class It>
+T statisticEvaluations<T>::VectorSum(It first, It last)
 {
-	int imax;
-	for (int i = imax = 0; i < n; ++i)
-		if (data[i] > data[imax])
-			imax = i;
+	STATISTIC_INSTRUMENT_EVALUATION(std::distance(first, last));
+	m_sum += SumOf(first, last);
 
-	m_max = data[imax];
+	return m_sum;
+}
+// mean value
+template <class T>
+T  statisticEvaluations<T>::MeanValue(const T *data, const int n)
+{
+	return VectorMeanValue(data, data + n);
+}
+template <class T>
+template <class It>
+T statisticEvaluations<T>::VectorMeanValue(It first, It last)
+{
+	STATISTIC_INSTRUMENT_EVALUATION(std::distance(first, last));
+	const int size = static_cast<int>(std::distance(first, last));
+	if (size > 0)
+		m_mean = SumOf(first, last) / size;	// округление int
 
-	return m_max;
+	return m_mean;
+}
+// min value
+template <class T>
+T statisticEvaluations<T>::Min(const T* data, const int n)
+{
+	return VectorMinValue(data, data + n);
 }
 template <class T>
-T statisticEvaluations<T>::VectorMaxValue(std::vector<T> data)
+template <class It>
+T statisticEvaluations<T>::VectorMinValue(It first, It last)
 {
-	int imax;   // = 0
-	for (int i = imax = 0; i < static_cast<int>(data.size()); ++i)
-		if (data.at(i) > data.at(imax))
-			imax = i;
+	STATISTIC_INSTRUMENT_EVALUATION(std::distance(first, last));
+	if (first != last)
+		m_min = MinOf(first, last);
 
-	m_max = data.at(imax);
+	return m_min;
+}
+
+// max value
+template <class T>
+T statisticEvaluations<T>::Max(const T* data, const int n)
+{
+	return VectorMaxValue(data, data + n);
+}
+template <class T>
+template <class It>
+T statisticEvaluations<T>::VectorMaxValue(It first, It last)
+{
+	STATISTIC_INSTRUMENT_EVALUATION(std::distance(first, last));
+	if (first != last)
+		m_max = MaxOf(first, last);
 
 	return m_max;
 }
 
 // math expectation
 template <class T>
-T statisticEvaluations<T>::MathExpectation(T *data, const int n)
+T statisticEvaluations<T>::MathExpectation(const T *data, const int n)
 {
-	T sum = 0;
-    for(int i = 0; i < n; ++i)
-		sum += data[i];
-
-	m_math_expectation = sum / n;
+	return VectorMathExpectation(data, data + n);
+}
+template <class T>
+template <class It>
+T statisticEvaluations<T>::VectorMathExpectation(It first, It last)
+{
+	STATISTIC_INSTRUMENT_EVALUATION(std::distance(first, last));
+	const int size = static_cast<int>(std::distance(first, last));
+	if (size > 0)
+		m_math_expectation = SumOf(first, last) / size;
 
     return m_math_expectation;
 }
+
+// dispersion
 template <class T>
-T statisticEvaluations<T>::VectorMathExpectation(std::vector<T> data)
+T statisticEvaluations<T>::Dispersion(const T *data, const int n)
 {
-	T sum = 0;
-	int size = data.size();
+	return VectorDispersion(data, data + n);
+}
+template <class T>
+template <class It>
+T statisticEvaluations<T>::VectorDispersion(It first, It last)
+{
+	STATISTIC_INSTRUMENT_EVALUATION(std::distance(first, last));
+	const int size = static_cast<int>(std::distance(first, last));
+	if (size > 0)
+	{
+		m_dispersion += SquaredDeviationOf(first, last, GetMean());
+		m_dispersion /= size;
+	}
 
-    for(int i = 0; i < size; ++i)
-		sum += data.at(i);
+	return m_dispersion;
+}
 
-	m_math_expectation = sum / size;
+// standart deviation
+template <class T>
+double statisticEvaluations<T>::StdDeviation(const T *data, const int n)
+{
+	return VectorStdDeviation(data, data + n);
+}
+template <class T>
+template <class It>
+double statisticEvaluations<T>::VectorStdDeviation(It first, It last)
+{
+	m_std_deviation = sqrt((double)(VectorDispersion(first, last)));
+	return m_std_deviation;
+}
 
-    return m_math_expectation;
+// single pass summary
+template <class T>
+statisticSummary<T> statisticEvaluations<T>::Summarize(const T* data, const int n)
+{
+	return VectorSummarize(data, data + n);
+}
+template <class T>
+template <class It>
+statisticSummary<T> statisticEvaluations<T>::VectorSummarize(It first, It last)
+{
+	STATISTIC_INSTRUMENT_EVALUATION(std::distance(first, last));
+	statisticSummary<T> summary;
+	if (first == last)
+		return summary;
+
+	const statisticAccumulator<T> accumulator = AccumulateOf(first, last);
+
+	summary.count = static_cast<int>(accumulator.GetCount());
+	summary.sum = accumulator.GetSum();
+	summary.min = accumulator.GetMin();
+	summary.max = accumulator.GetMax();
+	summary.mean = accumulator.GetMean();
+	summary.dispersion = accumulator.GetDispersion();
+	summary.std_deviation = accumulator.GetStdDeviation();
+
+	m_sum = summary.sum;
+	m_min = summary.min;
+	m_max = summary.max;
+	m_mean = m_math_expectation = (T)summary.mean;
+	m_dispersion = (T)summary.dispersion;
+	m_std_deviation = summary.std_deviation;
+
+	return summary;
 }
 
-// dispersion
+// order statistics
 template <class T>
-T statisticEvaluations<T>::Dispersion(T *data, const int n)
+template <class V>
+void statisticEvaluations<T>::MultiSelect(V* first, V* last, size_t offset,
+	const size_t* rankFirst, const size_t* rankLast)
 {
-	T k;
+	// the middle rank splits the range and the ranks, every rank is placed by
+	// one introselect (std::nth_element) over a shrinking range
+	while (rankFirst != rankLast)
+	{
+		const size_t* middle = rankFirst + (rankLast - rankFirst) / 2;
+		V* nth = first + (*middle - offset);
+		std::nth_element(first, nth, last);
+
+		MultiSelect(first, nth, offset, rankFirst, middle);
+		first = nth + 1;
+		offset = *middle + 1;
+		rankFirst = middle + 1;
+	}
+}
 
-	for (int i = 0; i < n; ++i)
+template <class T>
+template <class V>
+void statisticEvaluations<T>::SelectRanks(std::vector<V>& values, std::vector<V>& buffer)
+{
+	if (IsParallel(values.size()))
 	{
-		k = (data[i] - GetMean()) * (data[i] - GetMean());
-		m_dispersion += k;
+		ParallelRadixSort(values, buffer, m_pool ? *m_pool : statisticThreadPool::Instance());
+		return;
 	}
-	m_dispersion /= n;
+	MultiSelect(&values[0], &values[0] + values.size(), 0, m_ranks.data(), m_ranks.data() + m_ranks.size());
+}
 
-	return m_dispersion;
+template <class T>
+void statisticEvaluations<T>::QuantileRanks(size_t n, const double* q, size_t count)
+{
+	m_ranks.clear();
+	for (size_t i = 0; i < count; ++i)
+	{
+		double level = 0.0;
+		if (!QuantileLevel(q[i], level))
+			continue;
+		const size_t rank = static_cast<size_t>(floor(level * (n - 1)));
+		m_ranks.push_back(rank);
+		if (rank + 1 < n)
+			m_ranks.push_back(rank + 1);
+	}
+	std::sort(m_ranks.begin(), m_ranks.end());
+	m_ranks.erase(std::unique(m_ranks.begin(), m_ranks.end()), m_ranks.end());
 }
+
 template <class T>
-T statisticEvaluations<T>::VectorDispersion(std::vector<T> data)
+template <class V>
+void statisticEvaluations<T>::InterpolateQuantiles(const std::vector<V>& values, const double* q,
+	double* out, size_t count) const
 {
-	T k;
-	int size = data.size();
+	const size_t n = values.size();
+	for (size_t i = 0; i < count; ++i)
+	{
+		double level = 0.0;
+		if (!QuantileLevel(q[i], level))
+		{
+			out[i] = std::numeric_limits<double>::quiet_NaN();
+			continue;
+		}
+		const double h = level * (n - 1);
+		const size_t rank = static_cast<size_t>(floor(h));
+		const double low = (double)values[rank];
+		out[i] = rank + 1 < n ? low + (h - rank) * ((double)values[rank + 1] - low) : low;
+	}
+}
 
-	for (int i = 0; i < size; ++i)
+template <class T>
+template <class It>
+void statisticEvaluations<T>::VectorQuantiles(It first, It last, const double* q, double* out, size_t count)
+{
+	STATISTIC_INSTRUMENT_EVALUATION(std::distance(first, last));
+	m_scratch.assign(first, last);
+	STATISTIC_INSTRUMENT(eCounterBytesCopied, m_scratch.size() * sizeof(T));
+	if (m_scratch.empty())
 	{
-		k = (data.at(i) - GetMean()) * (data.at(i) - GetMean());
-		m_dispersion += k;
+		std::fill(out, out + count, 0.0);
+		return;
 	}
-	m_dispersion /= size;
 
-	return m_dispersion;
+	QuantileRanks(m_scratch.size(), q, count);
+	SelectRanks(m_scratch, m_sortBuffer);
+	InterpolateQuantiles(m_scratch, q, out, count);
 }
 
-// standart deviation
 template <class T>
-double statisticEvaluations<T>::StdDeviation(T *data, const int n)
+template <class It>
+double statisticEvaluations<T>::VectorQuantile(It first, It last, double q)
 {
-	m_std_deviation = sqrt((double)(Dispersion(data, n)));
-	return m_std_deviation;
+	double value = 0.0;
+	VectorQuantiles(first, last, &q, &value, 1);
+	return value;
 }
+
 template <class T>
-double statisticEvaluations<T>::VectorStdDeviation(std::vector<T> data)
+template <class It>
+double statisticEvaluations<T>::VectorInterquartileRange(It first, It last)
 {
-	m_std_deviation = sqrt((double)(VectorDispersion(data)));
-	return m_std_deviation;
+	const double q[2] = {0.25, 0.75};
+	double quartiles[2];
+	VectorQuantiles(first, last, q, quartiles, 2);
+	return quartiles[1] - quartiles[0];
+}
+
+template <class T>
+template <class It>
+double statisticEvaluations<T>::VectorMedianAbsoluteDeviation(It first, It last)
+{
+	const double median = VectorMedian(first, last);
+	if (m_scratch.empty())
+		return 0.0;
+
+	m_deviations.resize(m_scratch.size());
+	for (size_t i = 0; i < m_scratch.size(); ++i)
+		m_deviations[i] = fabs((double)m_scratch[i] - median);
+
+	const double half = 0.5;
+	double value = 0.0;
+	QuantileRanks(m_deviations.size(), &half, 1);
+	SelectRanks(m_deviations, m_deviationsBuffer);
+	InterpolateQuantiles(m_deviations, &half, &value, 1);
+	return value;
 }
 
 // clean all stat evaluations data
@@ -351,6 +777,43 @@ void statisticEvaluations<T>::SetMathExpectation(T _mathExpectation)
 {
 	m_math_expectation = _mathExpectation;
 }
+
+// snapshot
+template <class T>
+void statisticEvaluations<T>::SaveState(statisticSnapshotWriter& writer) const
+{
+	writer.Put(m_sum);
+	writer.Put(m_min);
+	writer.Put(m_max);
+	writer.Put(m_mean);
+	writer.Put(m_dispersion);
+	writer.Put(m_math_expectation);
+	writer.Put(m_std_deviation);
+	writer.Put(static_cast<uint32_t>(m_summationMode));
+}
+
+template <class T>
+bool statisticEvaluations<T>::LoadState(statisticSnapshotReader& reader)
+{
+	T sum, min, max, mean, dispersion, mathExpectation;
+	double stdDeviation = 0.0;
+	uint32_t summationMode = 0;
+	if (!reader.Get(sum) || !reader.Get(min) || !reader.Get(max) || !reader.Get(mean) || !reader.Get(dispersion)
+		|| !reader.Get(mathExpectation) || !reader.Get(stdDeviation) || !reader.Get(summationMode))
+		return false;
+	if (summationMode > NStatisticKernels::eSummationCompensated)
+		return reader.Fail();
+
+	m_sum = sum;
+	m_min = min;
+	m_max = max;
+	m_mean = mean;
+	m_dispersion = dispersion;
+	m_math_expectation = mathExpectation;
+	m_std_deviation = stdDeviation;
+	m_summationMode = static_cast<NStatisticKernels::ESummationMode>(summationMode);
+	return true;
+}
 //
 }
 //
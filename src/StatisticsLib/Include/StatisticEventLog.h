@@ -0,0 +1,379 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticEventLog_H___
+#define ___StatisticEventLog_H___
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <stdint.h>
+
+#include "StatisticSpan.h"
+#include "StatisticClock.h"
+
+//
+namespace NStatisticEvents
+{
+// Event log file: 64 byte header followed by the values in the native byte
+// order. The optional timestamps (ns) are kept in the same format in the
+// "<log>.ts" file, so the values stay contiguous for the kernels; both files
+// carry the id of the log, so the times of another (rewritten) log are ignored.
+struct statisticLogHeader
+{
+	char magic[4];                      // "SLOG"
+	uint32_t version;
+	uint32_t valueType;                 // statisticLogValueType<T>
+	uint32_t valueSize;
+	uint64_t count;                     // values committed by the last Flush
+	uint64_t id;                        // set when the log is created, 0 in old logs
+	uint8_t reserved[32];
+};
+
+const uint32_t c_logVersion = 1;
+const size_t c_logHeaderSize = sizeof(statisticLogHeader);
+
+// value type code: kind (0 unsigned, 1 signed, 2 floating point) and size
+template <class T> struct statisticLogValueType
+{
+	static const uint32_t value = (std::is_floating_point<T>::value ? 2u :
+		std::is_signed<T>::value ? 1u : 0u) << 16 | static_cast<uint32_t>(sizeof(T));
+};
+
+//!@ingroup amgStatistic
+//! @brief Файл журнала событий с буферизованной дозаписью (внутренний класс)
+class statisticLogFile
+{
+public:
+	statisticLogFile();
+	~statisticLogFile() { Close(); }
+
+   /*!@brief Открытие файла
+   * @param[in] append Продолжение существующего журнала того же типа
+   * (значения после последнего Flush отбрасываются)
+   * @param[in] id Идентификатор нового журнала (продолженный сохраняет свой)
+   * @return false при ошибке ввода-вывода или несовпадении формата
+   */
+	bool Open(const std::string& path, uint32_t valueType, uint32_t valueSize, bool append, uint64_t id);
+	void Close();
+	bool IsOpen() const { return m_file != -1; }
+
+   //! @brief Дозапись count значений
+	bool Append(const void* values, size_t count);
+   //! @brief Запись буфера и количества значений в заголовок
+	bool Flush(bool sync);
+   //! @brief Отбрасывание значений после первых count
+	bool Truncate(uint64_t count);
+   //! @brief Дополнение нулевыми значениями до count
+	bool Extend(uint64_t count);
+
+	uint64_t Count() const { return m_count; }
+	uint64_t Id() const { return m_header.id; }
+
+private:
+	// copy and assignment not allowed
+	statisticLogFile(const statisticLogFile&);
+	statisticLogFile& operator=(const statisticLogFile&);
+
+	bool WriteBuffer();
+
+	static const size_t c_bufferSize = 1 << 20;
+
+	intptr_t m_file;                    // descriptor or HANDLE, -1 if closed
+	statisticLogHeader m_header;
+	uint32_t m_valueSize;
+	uint64_t m_count;                   // values appended (written and buffered)
+	uint64_t m_written;                 // values in the file
+	std::vector<char> m_buffer;
+	size_t m_used;
+	bool m_failed;
+};
+
+//!@ingroup amgStatistic
+//! @brief Файл, отображенный в память только для чтения (внутренний класс)
+class statisticMappedFile
+{
+public:
+	statisticMappedFile();
+	~statisticMappedFile() { Close(); }
+
+	bool Open(const std::string& path);
+	void Close();
+
+	const unsigned char* Data() const { return m_data; }
+	size_t Size() const { return m_size; }
+
+private:
+	// copy and assignment not allowed
+	statisticMappedFile(const statisticMappedFile&);
+	statisticMappedFile& operator=(const statisticMappedFile&);
+
+	const unsigned char* m_data;
+	size_t m_size;
+	intptr_t m_mapping;                 // mapping HANDLE (Windows)
+};
+
+//! @brief Проверка заголовка отображенного журнала, количество значений (-1 при ошибке)
+long long StatisticLogCount(const statisticMappedFile& file, uint32_t valueType, uint32_t valueSize);
+//! @brief Идентификатор отображенного журнала (заголовок проверен StatisticLogCount)
+uint64_t StatisticLogId(const statisticMappedFile& file);
+//! @brief Новый идентификатор журнала (не 0)
+uint64_t NewStatisticLogId();
+//! @brief Удаление файла журнала (false - файл не удален)
+bool RemoveStatisticLog(const std::string& path);
+
+//!@ingroup amgStatistic
+//! @brief Запись двоичного журнала событий
+//!
+//! Значения дописываются в конец файла через буфер; количество значений в
+//! заголовке обновляется в Flush и Close, поэтому после аварийного завершения
+//! журнал остается согласованным до последнего Flush. Время событий (нс)
+//! сохраняется в файле "<path>.ts", если журнал открыт с withTimes; события,
+//! записанные без времени, при продолжении журнала с withTimes получают время 0.
+//!
+//! Пример:
+//! @code
+//!    statisticEventLogWriter<double> log;
+//!    log.Open("latency.slog", true);
+//!    ex_d.GetStatEvents()->SetEventLog(&log);
+//!    ...
+//!    log.Close();
+//! @endcode
+template <class T> class statisticEventLogWriter
+{
+public:
+	statisticEventLogWriter() : m_withTimes(false) {}
+	~statisticEventLogWriter() { Close(); }
+
+   /*!@brief Открытие журнала
+   * @param[in] withTimes Сохранение времени событий
+   * @param[in] append Дозапись в существующий журнал
+   */
+	bool Open(const std::string& path, bool withTimes = false, bool append = false);
+   //! @brief Запись буферов и заголовков (sync - сброс на диск)
+	bool Flush(bool sync = false);
+	void Close();
+	bool IsOpen() const { return m_values.IsOpen(); }
+	bool HasTimes() const { return m_withTimes; }
+   //! @brief Количество записанных значений
+	unsigned long long Size() const { return m_values.Count(); }
+
+   //!@name Дозапись событий (без явного времени используется steady_clock)
+   //@{
+	bool Append(T value) { return Append(&value, 1); }
+	bool Append(T value, long long time) { return Append(&value, &time, 1); }
+	bool Append(const T* values, size_t n);
+	bool Append(const T* values, size_t n, long long time);
+	bool Append(const T* values, const long long* times, size_t n);
+   //@}
+
+private:
+	// copy and assignment not allowed
+	statisticEventLogWriter(const statisticEventLogWriter&);
+	statisticEventLogWriter& operator=(const statisticEventLogWriter&);
+
+	statisticLogFile m_values;
+	statisticLogFile m_times;
+	bool m_withTimes;
+};
+
+//!@ingroup amgStatistic
+//! @brief Чтение двоичного журнала событий через отображение в память
+//!
+//! Значения журнала доступны как непрерывный диапазон без копирования, поэтому
+//! любые оценки statisticEvaluations выполняются над файлами, превышающими
+//! объем памяти (страницы подгружаются операционной системой).
+//!
+//! Пример:
+//! @code
+//!    statisticEventLogReader<double> log;
+//!    if (log.Open("latency.slog"))
+//!        ex_d.GetStatEvaluations()->VectorSummarize(log.GetValues());
+//! @endcode
+template <class T> class statisticEventLogReader
+{
+public:
+	statisticEventLogReader() : m_count(0), m_timesCount(0) {}
+
+   //! @brief Открытие журнала (false - файл отсутствует, поврежден или другого типа)
+	bool Open(const std::string& path);
+	void Close();
+
+   //! @brief Значения журнала (пусто, если журнал не открыт)
+	NStatisticEvaluations::statisticSpan<const T> GetValues() const
+	{
+		// a closed reader has no mapping to offset into
+		if (!m_count)
+			return NStatisticEvaluations::statisticSpan<const T>();
+		return NStatisticEvaluations::statisticSpan<const T>(
+			reinterpret_cast<const T*>(m_values.Data() + c_logHeaderSize), m_count);
+	}
+   //! @brief Наличие времени событий
+	bool HasTimes() const { return m_timesCount != 0; }
+   //! @brief Время событий, нс (параллельно значениям)
+	NStatisticEvaluations::statisticSpan<const long long> GetTimes() const
+	{
+		if (!m_timesCount)
+			return NStatisticEvaluations::statisticSpan<const long long>();
+		return NStatisticEvaluations::statisticSpan<const long long>(
+			reinterpret_cast<const long long*>(m_times.Data() + c_logHeaderSize), m_timesCount);
+	}
+	size_t Size() const { return m_count; }
+
+private:
+	statisticMappedFile m_values;
+	statisticMappedFile m_times;
+	size_t m_count;
+	size_t m_timesCount;
+};
+
+// writer
+template <class T>
+bool statisticEventLogWriter<T>::Open(const std::string& path, bool withTimes, bool append)
+{
+	Close();
+	if (!m_values.Open(path, statisticLogValueType<T>::value, sizeof(T), append, NewStatisticLogId()))
+		return false;
+
+	// the times of a rewritten log belong to the old values
+	const std::string timesPath = path + ".ts";
+	if (!append && !RemoveStatisticLog(timesPath))
+	{
+		Close();
+		return false;
+	}
+
+	m_withTimes = withTimes;
+	if (!withTimes)
+		return true;
+
+	// the times file of another log is started over
+	if (!m_times.Open(timesPath, statisticLogValueType<long long>::value, sizeof(long long), append, m_values.Id())
+		|| (m_times.Id() != m_values.Id() && !m_times.Open(timesPath, statisticLogValueType<long long>::value,
+			sizeof(long long), false, m_values.Id())))
+	{
+		Close();
+		return false;
+	}
+
+	// the values are kept: times after the committed values are dropped, the values
+	// appended without times get the time 0
+	const uint64_t count = m_values.Count();
+	if ((m_times.Count() > count && !m_times.Truncate(count)) || !m_times.Extend(count) || !m_times.Flush(false))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+template <class T>
+bool statisticEventLogWriter<T>::Flush(bool sync)
+{
+	// the times are committed first: the reader takes them only with as many values
+	bool result = true;
+	if (m_withTimes)
+		result = m_times.Flush(sync);
+
+	return m_values.Flush(sync) && result;
+}
+
+template <class T>
+void statisticEventLogWriter<T>::Close()
+{
+	m_times.Close();
+	m_values.Close();
+	m_withTimes = false;
+}
+
+template <class T>
+bool statisticEventLogWriter<T>::Append(const T* values, size_t n)
+{
+	if (m_withTimes)
+		return Append(values, n, SteadyClockNs());
+
+	return m_values.Append(values, n);
+}
+
+template <class T>
+bool statisticEventLogWriter<T>::Append(const T* values, size_t n, long long time)
+{
+	if (!m_values.Append(values, n))
+		return false;
+
+	for (size_t i = 0; m_withTimes && i < n; ++i)
+	{
+		if (!m_times.Append(&time, 1))
+			return false;
+	}
+	return true;
+}
+
+template <class T>
+bool statisticEventLogWriter<T>::Append(const T* values, const long long* times, size_t n)
+{
+	if (!m_values.Append(values, n))
+		return false;
+
+	return !m_withTimes || m_times.Append(times, n);
+}
+
+// reader
+template <class T>
+bool statisticEventLogReader<T>::Open(const std::string& path)
+{
+	Close();
+	if (!m_values.Open(path))
+		return false;
+
+	const long long count = StatisticLogCount(m_values, statisticLogValueType<T>::value, sizeof(T));
+	if (count < 0)
+	{
+		Close();
+		return false;
+	}
+	m_count = static_cast<size_t>(count);
+
+	// the times are optional, a damaged times file or the times of another log are ignored
+	if (m_times.Open(path + ".ts"))
+	{
+		const long long times = StatisticLogCount(m_times, statisticLogValueType<long long>::value,
+			sizeof(long long));
+		if (times == count && StatisticLogId(m_times) == StatisticLogId(m_values))
+			m_timesCount = m_count;
+		else
+			m_times.Close();
+	}
+	return true;
+}
+
+template <class T>
+void statisticEventLogReader<T>::Close()
+{
+	m_values.Close();
+	m_times.Close();
+	m_count = 0;
+	m_timesCount = 0;
+}
+//
+}
+//
+#endif /* ___StatisticEventLog_H___ */
@@ -23,20 +23,41 @@
 #include <iostream>
 #include <queue>
 #include <vector>
+#include <utility>
 #include <ctime>
 #include <cstdlib>
 #include <cerrno>
 
+#include "StatisticSpan.h"
+#include "StatisticAccumulator.h"
+#include "StatisticRing.h"
+#include "StatisticWindow.h"
+#include "StatisticTDigest.h"
+#include "StatisticHistogram.h"
+#include "StatisticClock.h"
+#include "StatisticRate.h"
+#include "StatisticEventLog.h"
+#include "StatisticInstrumentation.h"
+
 //
 namespace NStatisticEvents
 {
 //!@ingroup amgStatistic
-//! @brief   ,   
+//! @brief Режим фиксации времени событий
+enum ETimestampMode
+{
+	eTimestampNone = 0,                 //!< время событий не фиксируется
+	eTimestampLast,                     //!< время первого и последнего события
+	eTimestampEvents                    //!< время каждого события сохраняется вместе с очередью
+};
+
+//!@ingroup amgStatistic
+//! @brief Класс статических событий, очереди статических событий
 //!
-//!  ,     ,  
-//!        .
+//! Шаблонный класс, предназначенный для формарования очереди событий, получения 
+//! доступа и подсчета времени и скорости поступления событий.
 //! 
-//! :
+//! Пример:
 //! @code
 //!    statistic<int> ex1;  
 //!    int data[n] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
@@ -44,39 +65,184 @@ namespace NStatisticEvents
 //!    for (int i = 0; i < 5; ++i)
 //!        ex1.GetStatEvents()->StatisticEvent(data[i]);
 //!
-//!    ex1.GetStatEvaluations()->VectorStdDeviation(ex1.GetStatEvents()->GetParamsQueue());
+//!    ex1.GetStatEvaluations()->VectorStdDeviation(ex1.GetStatEvents()->GetParamsView());
 //!    
 //!    cout << "StdDeviation: " << ex1.GetStatEvaluations()->GetStdDeveation() << endl;
 //! @endcode
 template <class T> class statisticEvents
 {
 public:
-	statisticEvents() { m_eventsCounter = 0; }
+	statisticEvents() 
+		: m_currentStatParameter(), m_eventsCounter(0), m_historyGeneration(0), m_historySequence(0),
+		m_onlineMode(false), m_keepHistory(true),
+		m_timestampMode(eTimestampLast), m_clock(eClockSteady), m_firstEventTime(0), m_lastEventTime(0),
+		m_rateMeter(false), m_quantileSketch(false), m_histogramEnabled(false), m_log(0) {}
 
-   /*!@brief   
-   * @param[in] parameter  (  )
+   /*!@brief Формирование очереди событий
+   * @param[in] parameter Событий (число произвольного типа)
    */
 	void StatisticEvent(T parameter);
-   //! @brief    
+   /*!@brief Формирование очереди событий из пакета значений
+   * (время фиксируется один раз для всего пакета)
+   * @param[in] parameters Массив событий
+   * @param[in] n Количество событий
+   */
+	void StatisticEvents(const T* parameters, size_t n);
+   //! @brief Доступ к очереди событий
 	std::vector<T> GetParamsQueue();
-   //! @brief      
+   //! @brief Доступ к очереди событий без копирования
+   //! (при ограниченной емкости - окно событий в порядке хранения)
+	NStatisticEvaluations::statisticSpan<const T> GetParamsView() const;
+   //! @brief Доступ к очереди событий без копирования в хронологическом порядке
+	NStatisticEvaluations::statisticRingView<T> GetHistoryView() const;
+
+   /*!@brief Ограничение очереди событий кольцевым буфером
+   * @param[in] capacity Количество хранимых последних событий (0 - без ограничения)
+   */
+	void SetHistoryCapacity(size_t capacity);
+	size_t GetHistoryCapacity() const { return m_paramsRing.Capacity(); }
+   //! @brief Номер версии очереди событий: изменяется при сбросе и изменении емкости,
+   //! когда ранее полученные из очереди данные перестают быть ее началом
+	unsigned long long GetHistoryGeneration() const { return m_historyGeneration; }
+   //! @brief Количество событий, добавленных в очередь в текущей версии
+   //! (при ограниченной емкости - включая вытесненные)
+	unsigned long long GetHistorySequence() const { return m_historySequence; }
+   //! @brief Получение к текущему значению очереди событий
 	T GetCurrStatParameter();
-   //! @brief     
+   //! @brief Получение количества событий в очереди
 	int EventsCount();
    
-   //! @brief     TODO
-	void EventTime();	                  // get event time
-   //! @brief     TODO
-	double EventsSpeed();	              // number of events in time
+   /*!@brief Режим фиксации времени событий
+   * @param[in] mode Режим (по умолчанию - время первого и последнего события)
+   * @param[in] clock Источник времени
+   */
+	void SetTimestampMode(ETimestampMode mode, EClockType clock = eClockSteady);
+	ETimestampMode GetTimestampMode() const { return m_timestampMode; }
+	EClockType GetClockType() const { return m_clock; }
+
+   //! @brief Время последнего события, нс (монотонное время, 0 - нет событий)
+	long long EventTime() const { return m_lastEventTime; }
+   //! @brief Время первого события, нс
+	long long FirstEventTime() const { return m_firstEventTime; }
+   //! @brief Скорость поступления событий, событий/с: сглаженная за 1 минуту при
+   //! включенном измерителе скорости, иначе средняя от первого события до текущего момента
+	double EventsSpeed() const;
+
+   /*!@brief Измеритель скорости поступления событий
+   * @param[in] enabled Регистрировать события в измерителе (O(1) на событие или пакет)
+   */
+	void SetRateMeter(bool enabled) { m_rateMeter = enabled; }
+	bool IsRateMeter() const { return m_rateMeter; }
+   //! @brief Измеритель скорости (допускает чтение из потока мониторинга)
+	const statisticRateMeter& GetRateMeter() const { return m_rate; }
+
+   /*!@brief Оценка квантилей событий (t-digest) без хранения событий
+   * @param[in] enabled Добавлять события в оценку квантилей
+   * @param[in] compression Параметр сжатия оценки
+   */
+	void SetQuantileSketch(bool enabled, double compression = 100.0);
+	bool IsQuantileSketch() const { return m_quantileSketch; }
+	const NStatisticEvaluations::statisticTDigest& GetQuantileSketch() const { return m_digest; }
+
+   /*!@brief Гистограмма событий с лог-линейными корзинами (значения приводятся к long long)
+   * @param[in] enabled Регистрировать события в гистограмме
+   * @param[in] lowest Наименьшее различимое значение
+   * @param[in] highest Наибольшее регистрируемое значение
+   * @param[in] digits Количество значащих цифр
+   */
+	void SetHistogram(bool enabled, long long lowest = 1, long long highest = 3600000000000LL, int digits = 3);
+	bool IsHistogram() const { return m_histogramEnabled; }
+	const NStatisticEvaluations::statisticHistogram& GetHistogram() const { return m_histogram; }
+
+   /*!@brief Добавление скользящего окна времени
+   * @param[in] length Длительность окна, нс
+   * @param[in] buckets Количество корзин окна
+   * @return Номер окна
+   */
+	size_t AddTimeWindow(long long length, size_t buckets);
+	size_t TimeWindowsCount() const { return m_windows.size(); }
+	const NStatisticEvaluations::statisticTimeWindow<T>& GetTimeWindow(size_t window) const { return m_windows[window]; }
+   //! @brief Оценки событий за окно времени, заканчивающееся текущим моментом
+	NStatisticEvaluations::statisticAccumulator<T> GetWindowStatistics(size_t window) const;
+   //! @brief Время событий, нс (режим eTimestampEvents), в порядке GetParamsView
+	NStatisticEvaluations::statisticSpan<const long long> GetTimesView() const;
+   //! @brief Время событий, нс (режим eTimestampEvents), в хронологическом порядке
+	std::vector<long long> GetTimesQueue() const;
+
+   /*!@brief Режим оперативного (online) расчета оценок
+   * @param[in] online Обновлять накопитель оценок при каждом событии (O(1))
+   * @param[in] keepHistory Сохранять события в очереди
+   */
+	void SetOnlineMode(bool online, bool keepHistory = true);
+	bool IsOnlineMode() const { return m_onlineMode; }
+   //! @brief Текущие оценки (количество, сумма, мин., макс., среднее, дисперсия),
+   //! обновляемые в оперативном режиме
+	const NStatisticEvaluations::statisticAccumulator<T>& GetOnlineStatistics() const { return m_online; }
+
+   /*!@brief Запись событий в двоичный журнал
+   * @param[in] log Открытый журнал (0 - запись отключена); время событий берется из
+   * режима фиксации времени, владение журналом не передается
+   */
+	void SetEventLog(statisticEventLogWriter<T>* log) { m_log = log; }
+	statisticEventLogWriter<T>* GetEventLog() const { return m_log; }
+
+   //!@name Снимок состояния (StatisticSnapshot.h)
+   //! Сохраняются история и время событий, счетчики, оперативные оценки, оценка
+   //! квантилей и гистограмма. Измеритель скорости и окна времени не сохраняются:
+   //! их шкала времени (steady_clock) не переживает перезапуск.
+   //@{
+	static uint32_t SnapshotKind()
+	{
+		return NStatisticEvaluations::SnapshotKind(NStatisticEvaluations::eSnapshotEvents,
+			NStatisticEvaluations::SnapshotValueType<T>());
+	}
+	void SaveState(NStatisticEvaluations::statisticSnapshotWriter& writer) const;
+   //! @brief Восстановление (при ошибке объект не изменяется; емкость истории
+   //! сверх сохраненных событий - не более 2^28)
+	bool LoadState(NStatisticEvaluations::statisticSnapshotReader& reader);
+   //@}
 
 	void ResetAllEventsData();
 
 private:
 	std::vector<T> m_paramsQueue;       // statistic parameters vector
+	NStatisticEvaluations::statisticRingBuffer<T> m_paramsRing;	// bounded history
 	T m_currentStatParameter;	         // current statistic parameter
 	int m_eventsCounter;
+	unsigned long long m_historyGeneration;	// history changes for the cached evaluations
+	unsigned long long m_historySequence;
+
+	NStatisticEvaluations::statisticAccumulator<T> m_online;	// online mode evaluations
+	bool m_onlineMode;
+	bool m_keepHistory;
+
+	void StampEvents(const T* parameters, size_t n);
+	void StoreTimes(long long time, size_t n);
+	void LogEvents(const T* parameters, size_t n);
+	void InstrumentHistoryGrowth(size_t n) const;
+
+	ETimestampMode m_timestampMode;
+	EClockType m_clock;
+	long long m_firstEventTime;         // event times, ns
+	long long m_lastEventTime;
+	std::vector<long long> m_timesQueue;	// per event times, parallel to the events queue
+	NStatisticEvaluations::statisticRingBuffer<long long> m_timesRing;
+
+	statisticRateMeter m_rate;          // events rate
+	bool m_rateMeter;
+
+	std::vector<NStatisticEvaluations::statisticTimeWindow<T> > m_windows;	// time sliding windows
+
+	NStatisticEvaluations::statisticTDigest m_digest;	// quantiles
+	bool m_quantileSketch;
+
+	NStatisticEvaluations::statisticHistogram m_histogram;	// log-linear histogram
+	bool m_histogramEnabled;
 
-	time_t m_time;                      // event time
+	statisticEventLogWriter<T>* m_log;  // binary events log
+
+	// the largest history capacity restored above the stored events
+	static const uint64_t c_maxLoadedCapacity = 1ULL << 28;
 };
 
 // statistic event
@@ -84,19 +250,197 @@ template <class T>
 void statisticEvents<T>::StatisticEvent(T parameter)
 {
 	m_currentStatParameter = parameter;
-	m_paramsQueue.push_back(parameter);
+	if (m_keepHistory)
+	{
+		if (m_paramsRing.Capacity())
+			m_paramsRing.Push(parameter);
+		else
+		{
+			InstrumentHistoryGrowth(1);
+			m_paramsQueue.push_back(parameter);
+		}
+		++m_historySequence;
+	}
+	if (m_onlineMode)
+		m_online.Add(parameter);
+	if (m_quantileSketch)
+		m_digest.Add((double)parameter);
+	if (m_histogramEnabled)
+		m_histogram.Record((long long)parameter);
 
-	// check time
-	m_time = time(NULL);
+	StampEvents(&parameter, 1);
+	if (m_log)
+		LogEvents(&parameter, 1);
 	m_eventsCounter++;
+	STATISTIC_INSTRUMENT(eCounterEventsIngested, 1);
+}
+
+// statistic events batch
+template <class T>
+void statisticEvents<T>::StatisticEvents(const T* parameters, size_t n)
+{
+	if (!n)
+		return;
+
+	m_currentStatParameter = parameters[n - 1];
+	if (m_keepHistory)
+	{
+		if (m_paramsRing.Capacity())
+		{
+			// only the last capacity values survive
+			const size_t first = n > m_paramsRing.Capacity() ? n - m_paramsRing.Capacity() : 0;
+			for (size_t i = first; i < n; ++i)
+				m_paramsRing.Push(parameters[i]);
+		}
+		else
+		{
+			InstrumentHistoryGrowth(n);
+			m_paramsQueue.insert(m_paramsQueue.end(), parameters, parameters + n);
+		}
+		m_historySequence += n;
+	}
+	if (m_onlineMode)
+		m_online.AddRange(parameters, parameters + n);
+	if (m_quantileSketch)
+		m_digest.AddRange(parameters, parameters + n);
+	if (m_histogramEnabled)
+	{
+		for (size_t i = 0; i < n; ++i)
+			m_histogram.Record((long long)parameters[i]);
+	}
+
+	StampEvents(parameters, n);
+	if (m_log)
+		LogEvents(parameters, n);
+	m_eventsCounter += static_cast<int>(n);
+	STATISTIC_INSTRUMENT(eCounterEventsIngested, n);
+}
+
+// one clock read for n events
+template <class T>
+void statisticEvents<T>::StampEvents(const T* parameters, size_t n)
+{
+	if (m_timestampMode == eTimestampNone && !m_rateMeter && m_windows.empty())
+		return;
+
+	const long long time = StatisticClockNs(m_clock);
+	if (m_rateMeter)
+		m_rate.Mark(n, time);
+	for (size_t i = 0; i < m_windows.size(); ++i)
+		m_windows[i].AddRange(parameters, parameters + n, time);
+	if (m_timestampMode == eTimestampNone)
+		return;
+
+	if (!m_firstEventTime)
+		m_firstEventTime = time;
+	m_lastEventTime = time;
+
+	if (m_timestampMode == eTimestampEvents && m_keepHistory)
+		StoreTimes(time, n);
+}
+
+template <class T>
+void statisticEvents<T>::StoreTimes(long long time, size_t n)
+{
+	if (m_timesRing.Capacity())
+	{
+		if (n > m_timesRing.Capacity())
+			n = m_timesRing.Capacity();
+		for (size_t i = 0; i < n; ++i)
+			m_timesRing.Push(time);
+	}
+	else
+		m_timesQueue.insert(m_timesQueue.end(), n, time);
+}
+
+// instrumentation: the events queue is reallocated and moved to add n events
+template <class T>
+void statisticEvents<T>::InstrumentHistoryGrowth(size_t n) const
+{
+#if defined(STATISTIC_INSTRUMENTATION)
+	if (m_paramsQueue.size() + n > m_paramsQueue.capacity())
+	{
+		STATISTIC_INSTRUMENT(eCounterHistoryReallocations, 1);
+		STATISTIC_INSTRUMENT(eCounterBytesCopied, m_paramsQueue.size() * sizeof(T));
+	}
+#else
+	(void)n;
+#endif
+}
+
+// the stamp of the events is reused by the log
+template <class T>
+void statisticEvents<T>::LogEvents(const T* parameters, size_t n)
+{
+	if (!m_log->HasTimes())
+		m_log->Append(parameters, n);
+	else
+		m_log->Append(parameters, n, m_timestampMode == eTimestampNone ? StatisticClockNs(m_clock) : m_lastEventTime);
 }
 
 template <class T>
 std::vector<T> statisticEvents<T>::GetParamsQueue()
 {
+	STATISTIC_INSTRUMENT(eCounterBytesCopied,
+		(m_paramsRing.Capacity() ? m_paramsRing.Size() : m_paramsQueue.size()) * sizeof(T));
+	if (m_paramsRing.Capacity())
+	{
+		std::vector<T> queue(m_paramsRing.Size());
+		if (!queue.empty())
+			m_paramsRing.CopyTo(&queue[0]);
+		return queue;
+	}
 	return m_paramsQueue;
 }
 
+template <class T>
+NStatisticEvaluations::statisticSpan<const T> statisticEvents<T>::GetParamsView() const
+{
+	if (m_paramsRing.Capacity())
+		return m_paramsRing.Storage();
+	return NStatisticEvaluations::statisticSpan<const T>(m_paramsQueue);
+}
+
+template <class T>
+NStatisticEvaluations::statisticRingView<T> statisticEvents<T>::GetHistoryView() const
+{
+	if (m_paramsRing.Capacity())
+		return m_paramsRing.View();
+
+	NStatisticEvaluations::statisticRingView<T> view;
+	view.first = NStatisticEvaluations::statisticSpan<const T>(m_paramsQueue);
+	return view;
+}
+
+// bounded history
+template <class T>
+void statisticEvents<T>::SetHistoryCapacity(size_t capacity)
+{
+	// keep the latest events of the current history
+	std::vector<T> history = GetParamsQueue();
+	const size_t first = capacity && history.size() > capacity ? history.size() - capacity : 0;
+
+	std::vector<long long> times = GetTimesQueue();
+
+	m_paramsRing.SetCapacity(capacity);
+	std::vector<T>().swap(m_paramsQueue);
+	for (size_t i = first; i < history.size(); ++i)
+	{
+		if (capacity)
+			m_paramsRing.Push(history[i]);
+		else
+			m_paramsQueue.push_back(history[i]);
+	}
+
+	m_timesRing.SetCapacity(m_timestampMode == eTimestampEvents ? capacity : 0);
+	std::vector<long long>().swap(m_timesQueue);
+	for (size_t i = first; i < times.size(); ++i)
+		StoreTimes(times[i], 1);
+
+	++m_historyGeneration;
+	m_historySequence = history.size() - first;
+}
+
 // get current stat parameter
 template <class T>
 T statisticEvents<T>::GetCurrStatParameter()
@@ -111,52 +455,120 @@ int statisticEvents<T>::EventsCount()
 	return m_eventsCounter;
 }
 
-// event time
+// timestamps
 template <class T>
-void statisticEvents<T>::EventTime()
+void statisticEvents<T>::SetTimestampMode(ETimestampMode mode, EClockType clock)
 {
-	struct tm *eventTime;
-	//errno_t err;
-	double msTime;
+	if (mode == eTimestampEvents && m_timestampMode != eTimestampEvents)
+	{
+		// a wrapped history is rebuilt in chronological order first, so that it
+		// starts at the beginning of its storage as the new times ring does
+		// (the order of the events is the same, the generation does not change)
+		if (m_paramsRing.Capacity())
+		{
+			const std::vector<T> history = GetParamsQueue();
+			m_paramsRing.SetCapacity(m_paramsRing.Capacity());
+			for (size_t i = 0; i < history.size(); ++i)
+				m_paramsRing.Push(history[i]);
+		}
+
+		// events stored so far have no time (0), the times stay parallel to the queue
+		const size_t size = m_paramsRing.Capacity() ? m_paramsRing.Size() : m_paramsQueue.size();
+		m_timesRing.SetCapacity(m_paramsRing.Capacity());
+		std::vector<long long>().swap(m_timesQueue);
+		StoreTimes(0, size);
+	}
+	else if (mode != eTimestampEvents)
+	{
+		m_timesRing.SetCapacity(0);
+		std::vector<long long>().swap(m_timesQueue);
+	}
 
-	//err = localtime_s(&eventTime, &m_time);
-	eventTime = localtime(&m_time);
-	//if (err) {
-	//	std::cout << "Invalid argument to localtime_s" << std::endl;
-	//	exit(1);
-	//}
+	// times of different clocks are not comparable
+	if (clock != m_clock)
+		m_firstEventTime = m_lastEventTime = 0;
 
-	msTime = eventTime->tm_sec / 1000;
-	std::cout << msTime << " ms" << std::endl;
+	m_timestampMode = mode;
+	m_clock = clock;
 }
 
-// number of events
 template <class T>
-double statisticEvents<T>::EventsSpeed()
+NStatisticEvaluations::statisticSpan<const long long> statisticEvents<T>::GetTimesView() const
 {
-	double speed = 0;
-	struct tm *curTimeInfo;
-	struct tm *eventTimeInfo;
-	//errno_t curTimeErr, eventTimeErr;
+	if (m_timesRing.Capacity())
+		return m_timesRing.Storage();
+	return NStatisticEvaluations::statisticSpan<const long long>(m_timesQueue);
+}
+
+template <class T>
+std::vector<long long> statisticEvents<T>::GetTimesQueue() const
+{
+	STATISTIC_INSTRUMENT(eCounterBytesCopied,
+		(m_timesRing.Capacity() ? m_timesRing.Size() : m_timesQueue.size()) * sizeof(long long));
+	if (m_timesRing.Capacity())
+	{
+		std::vector<long long> times(m_timesRing.Size());
+		if (!times.empty())
+			m_timesRing.CopyTo(&times[0]);
+		return times;
+	}
+	return m_timesQueue;
+}
+
+// number of events per second
+template <class T>
+double statisticEvents<T>::EventsSpeed() const
+{
+	if (m_rateMeter)
+		return m_rate.OneMinuteRate();
+	if (m_timestampMode == eTimestampNone || !m_eventsCounter || !m_firstEventTime)
+		return 0;
+
+	const long long elapsed = StatisticClockNs(m_clock) - m_firstEventTime;
+	if (elapsed <= 0)
+		return 0;
+	return m_eventsCounter * 1e9 / elapsed;
+}
+
+// quantiles
+template <class T>
+void statisticEvents<T>::SetQuantileSketch(bool enabled, double compression)
+{
+	if (compression != m_digest.GetCompression())
+		m_digest = NStatisticEvaluations::statisticTDigest(compression);
+	m_quantileSketch = enabled;
+}
 
-	time_t currentTime = time(NULL);
-	curTimeInfo = localtime(&currentTime);
-	//if (curTimeErr) {
-	//	std::cout << "Invalid argument to localtime_s" << std::endl;
-	//	exit(1);
-	//}
-	std::cout << "curTimeInfo: " << curTimeInfo->tm_sec << std::endl;
+// histogram
+template <class T>
+void statisticEvents<T>::SetHistogram(bool enabled, long long lowest, long long highest, int digits)
+{
+	if (enabled && (lowest != m_histogram.GetLowest() || highest != m_histogram.GetHighest()
+		|| digits != m_histogram.GetSignificantDigits()))
+		m_histogram = NStatisticEvaluations::statisticHistogram(lowest, highest, digits);
+	m_histogramEnabled = enabled;
+}
 
-	eventTimeInfo = localtime(&m_time);
-	//if (eventTimeErr) {
-	//	std::cout << "Invalid argument to localtime_s" << std::endl;
-	//	exit(1);
-	//}
-	std::cout << "eventTimeInfo: " << eventTimeInfo->tm_sec << std::endl;
+// time sliding windows
+template <class T>
+size_t statisticEvents<T>::AddTimeWindow(long long length, size_t buckets)
+{
+	m_windows.push_back(NStatisticEvaluations::statisticTimeWindow<T>(length, buckets));
+	return m_windows.size() - 1;
+}
 
-	speed = (curTimeInfo->tm_sec - eventTimeInfo->tm_sec) / 60;	// TEST TEST TEST
+template <class T>
+NStatisticEvaluations::statisticAccumulator<T> statisticEvents<T>::GetWindowStatistics(size_t window) const
+{
+	return m_windows[window].GetStatistics(StatisticClockNs(m_clock));
+}
 
-	return speed;
+// online mode
+template <class T>
+void statisticEvents<T>::SetOnlineMode(bool online, bool keepHistory)
+{
+	m_onlineMode = online;
+	m_keepHistory = keepHistory || !online;
 }
 
 // clean all events queue data
@@ -164,6 +576,124 @@ template <class T>
 void statisticEvents<T>::ResetAllEventsData()
 {
 	m_eventsCounter = 0;
+	++m_historyGeneration;
+	m_historySequence = 0;
+	m_paramsQueue.clear();
+	m_paramsRing.Clear();
+	m_online.Reset();
+	m_timesQueue.clear();
+	m_timesRing.Clear();
+	m_firstEventTime = m_lastEventTime = 0;
+	m_rate.Reset();
+	m_digest.Reset();
+	m_histogram.Reset();
+	for (size_t i = 0; i < m_windows.size(); ++i)
+		m_windows[i].Clear();
+}
+
+// snapshot
+template <class T>
+void statisticEvents<T>::SaveState(NStatisticEvaluations::statisticSnapshotWriter& writer) const
+{
+	writer.Put(m_currentStatParameter);
+	writer.Put(m_eventsCounter);
+	writer.Put(static_cast<uint8_t>(m_keepHistory));
+	writer.Put(static_cast<uint8_t>(m_onlineMode));
+	writer.Put(static_cast<uint8_t>(m_quantileSketch));
+	writer.Put(static_cast<uint8_t>(m_histogramEnabled));
+	writer.Put(static_cast<uint32_t>(m_timestampMode));
+	writer.Put(static_cast<uint32_t>(m_clock));
+	writer.Put(m_firstEventTime);
+	writer.Put(m_lastEventTime);
+
+	// history and times in chronological order
+	const NStatisticEvaluations::statisticRingView<T> history = GetHistoryView();
+	writer.Put(static_cast<uint64_t>(m_paramsRing.Capacity()));
+	writer.Put(static_cast<uint64_t>(history.Size()));
+	writer.Write(history.first.Data(), history.first.Size() * sizeof(T));
+	writer.Write(history.second.Data(), history.second.Size() * sizeof(T));
+
+	NStatisticEvaluations::statisticRingView<long long> times = m_timesRing.View();
+	if (!m_timesRing.Capacity())
+		times.first = NStatisticEvaluations::statisticSpan<const long long>(m_timesQueue);
+	writer.Put(static_cast<uint64_t>(times.Size()));
+	writer.Write(times.first.Data(), times.first.Size() * sizeof(long long));
+	writer.Write(times.second.Data(), times.second.Size() * sizeof(long long));
+
+	m_online.SaveState(writer);
+	if (m_quantileSketch)
+		m_digest.SaveState(writer);
+	if (m_histogramEnabled)
+		m_histogram.SaveState(writer);
+}
+
+template <class T>
+bool statisticEvents<T>::LoadState(NStatisticEvaluations::statisticSnapshotReader& reader)
+{
+	T current;
+	int counter = 0;
+	uint8_t keepHistory = 0, online = 0, sketch = 0, histogramEnabled = 0;
+	uint32_t timestampMode = 0, clock = 0;
+	long long firstTime = 0, lastTime = 0;
+	uint64_t capacity = 0;
+	std::vector<T> history;
+	std::vector<long long> times;
+	if (!reader.Get(current) || !reader.Get(counter) || !reader.Get(keepHistory) || !reader.Get(online)
+		|| !reader.Get(sketch) || !reader.Get(histogramEnabled) || !reader.Get(timestampMode) || !reader.Get(clock)
+		|| !reader.Get(firstTime) || !reader.Get(lastTime) || !reader.Get(capacity)
+		|| !reader.GetArray(history) || !reader.GetArray(times))
+		return false;
+	// a capacity above the stored history is allocated, so it is bounded
+	if (timestampMode > eTimestampEvents || clock > eClockTsc || (capacity && history.size() > capacity)
+		|| (capacity > history.size() && capacity > c_maxLoadedCapacity)
+		|| times.size() != (timestampMode == eTimestampEvents ? history.size() : 0))
+		return reader.Fail();
+
+	NStatisticEvaluations::statisticAccumulator<T> onlineState;
+	NStatisticEvaluations::statisticTDigest digest;
+	NStatisticEvaluations::statisticHistogram histogram;
+	if (!onlineState.LoadState(reader) || (sketch && !digest.LoadState(reader))
+		|| (histogramEnabled && !histogram.LoadState(reader)))
+		return false;
+
+	// the history is built aside, the object changes only when nothing can fail
+	NStatisticEvaluations::statisticRingBuffer<T> paramsRing(static_cast<size_t>(capacity));
+	for (size_t i = 0; capacity && i < history.size(); ++i)
+		paramsRing.Push(history[i]);
+	if (capacity)
+		std::vector<T>().swap(history);
+
+	NStatisticEvaluations::statisticRingBuffer<long long> timesRing(
+		timestampMode == eTimestampEvents ? static_cast<size_t>(capacity) : 0);
+	for (size_t i = 0; timesRing.Capacity() && i < times.size(); ++i)
+		timesRing.Push(times[i]);
+	if (timesRing.Capacity())
+		std::vector<long long>().swap(times);
+
+	// the rate meter, the time windows and the log stay as they are
+	m_currentStatParameter = current;
+	m_eventsCounter = counter;
+	m_keepHistory = keepHistory != 0;
+	m_onlineMode = online != 0;
+	m_timestampMode = static_cast<ETimestampMode>(timestampMode);
+	m_clock = static_cast<EClockType>(clock);
+	m_firstEventTime = firstTime;
+	m_lastEventTime = lastTime;
+
+	std::swap(m_paramsRing, paramsRing);
+	m_paramsQueue.swap(history);
+	std::swap(m_timesRing, timesRing);
+	m_timesQueue.swap(times);
+
+	m_online = onlineState;
+	m_quantileSketch = sketch != 0;
+	std::swap(m_digest, digest);
+	m_histogramEnabled = histogramEnabled != 0;
+	std::swap(m_histogram, histogram);
+
+	++m_historyGeneration;
+	m_historySequence = m_paramsRing.Capacity() ? m_paramsRing.Size() : m_paramsQueue.size();
+	return true;
 }
 //
 }
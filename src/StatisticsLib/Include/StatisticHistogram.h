@@ -0,0 +1,150 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticHistogram_H___
+#define ___StatisticHistogram_H___
+
+#include <cstddef>
+#include <vector>
+
+#include "StatisticSnapshot.h"
+
+//
+namespace NStatisticEvaluations
+{
+//!@ingroup amgStatistic
+//! @brief Гистограмма с лог-линейными корзинами (HDR histogram)
+//!
+//! Диапазон значений [lowest, highest] делится на корзины-степени двойки,
+//! каждая из которых делится на одинаковое количество линейных подкорзин, так
+//! что относительная погрешность значения не превышает 10^-digits. Память
+//! фиксирована и выделяется в конструкторе; регистрация значения - несколько
+//! целочисленных операций без ветвлений (значения вне диапазона ограничиваются
+//! его границами).
+//!
+//! Пример:
+//! @code
+//!    statisticHistogram latency(1, 3600000000LL, 3);   // 1 мкс .. 1 ч, 3 значащих цифры
+//!    latency.Record(elapsedUs);
+//!    ...
+//!    cout << "p99.9: " << latency.GetValueAtPercentile(99.9) << " us" << endl;
+//! @endcode
+class statisticHistogram
+{
+public:
+   /*!@brief Конструктор
+   * @param[in] lowest Наименьшее различимое значение (1..2^40)
+   * @param[in] highest Наибольшее регистрируемое значение (>= 2 * lowest)
+   * @param[in] digits Количество значащих цифр (1..5)
+   */
+	statisticHistogram(long long lowest, long long highest, int digits);
+   //! @brief Минимальная гистограмма (значения 0..2 с точностью 1 цифра)
+	statisticHistogram();
+
+   //! @brief Регистрация значения count раз
+	void Record(long long value, long long count = 1)
+	{
+		// clamp to the range with conditional moves
+		value = value < 0 ? 0 : value;
+		value = value > m_highestTrackable ? m_highestTrackable : value;
+
+		m_counts[CountsIndex(value)] += count;
+		m_totalCount += count;
+		m_sum += static_cast<double>(value) * count;
+		m_min = value < m_min ? value : m_min;
+		m_max = value > m_max ? value : m_max;
+	}
+   //! @brief Добавление значений другой гистограммы
+	void Merge(const statisticHistogram& other);
+   //! @brief Сброс всех значений (память сохраняется)
+	void Reset();
+
+   //!@name Оценки
+   //@{
+	long long GetTotalCount() const { return m_totalCount; }
+   //! @brief Значение процентиля percentile из [0, 100] (верхняя граница подкорзины)
+	long long GetValueAtPercentile(double percentile) const;
+	double GetMean() const { return m_totalCount ? m_sum / m_totalCount : 0.0; }
+	double GetStdDeviation() const;
+	long long GetMin() const { return m_totalCount ? m_min : 0; }
+	long long GetMax() const { return m_totalCount ? m_max : 0; }
+   //! @brief Количество значений, неотличимых от value
+	long long GetCountAtValue(long long value) const;
+   //@}
+
+   //!@name Параметры
+   //@{
+	long long GetLowest() const { return m_lowest; }
+	long long GetHighest() const { return m_highest; }
+	int GetSignificantDigits() const { return m_digits; }
+   //! @brief Объем памяти счетчиков, байт
+	size_t GetMemorySize() const { return m_counts.size() * sizeof(long long); }
+   //@}
+
+   //!@name Границы подкорзин
+   //@{
+	long long LowestEquivalentValue(long long value) const;
+	long long HighestEquivalentValue(long long value) const;
+   //@}
+
+   //!@name Снимок состояния (StatisticSnapshot.h)
+   //@{
+	static uint32_t SnapshotKind() { return NStatisticEvaluations::SnapshotKind(eSnapshotHistogram); }
+	void SaveState(statisticSnapshotWriter& writer) const;
+	bool LoadState(statisticSnapshotReader& reader);
+   //@}
+
+private:
+	// the largest lowest value: 2 * lowest and the bucket bounds must not overflow
+	static const long long c_maxLowest = 1LL << 40;
+
+	void Init(long long lowest, long long highest, int digits);
+
+	static int LeadingZeros(unsigned long long value);
+
+	size_t CountsIndex(long long value) const
+	{
+		const int bucket = m_leadingZeroCountBase - LeadingZeros(value | m_subBucketMask);
+		const long long subBucket = value >> (bucket + m_unitMagnitude);
+		return static_cast<size_t>(((long long)(bucket + 1) << m_subBucketHalfCountMagnitude)
+			+ subBucket - m_subBucketHalfCount);
+	}
+	long long ValueFromIndex(size_t index) const;
+
+	long long m_lowest, m_highest;
+	int m_digits;
+
+	int m_unitMagnitude;                // log2 of the lowest value
+	int m_subBucketHalfCountMagnitude;
+	long long m_subBucketCount;         // linear sub buckets in a bucket
+	long long m_subBucketHalfCount;
+	unsigned long long m_subBucketMask;
+	int m_leadingZeroCountBase;
+	long long m_highestTrackable;       // highest value of the last bucket
+
+	std::vector<long long> m_counts;
+	long long m_totalCount;
+	double m_sum;
+	long long m_min, m_max;
+};
+//
+}
+//
+#endif /* ___StatisticHistogram_H___ */
@@ -0,0 +1,144 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticInstrumentation_H___
+#define ___StatisticInstrumentation_H___
+
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+
+//
+namespace NStatisticEvaluations
+{
+//!@ingroup amgStatistic
+//! @brief Счетчики самоконтроля библиотеки
+//!
+//! Счетчики ведутся в statisticEvents и statisticEvaluations, если проект собран
+//! с макросом STATISTIC_INSTRUMENTATION (макрос задается для всего проекта, иначе
+//! шаблоны разных единиц трансляции будут различаться). Без макроса счетчики
+//! не изменяются и не стоят ничего.
+enum EInstrumentationCounter
+{
+	eCounterEventsIngested = 0,         //!< зарегистрированные события
+	eCounterEvaluations,                //!< выполненные оценки
+	eCounterElementsScanned,            //!< элементы, просмотренные оценками
+	eCounterBytesCopied,                //!< байты копий данных: рост очереди событий, копии
+	                                    //!< очереди по значению, буферы порядковых статистик
+	eCounterHistoryReallocations,       //!< перераспределения памяти очереди событий
+	eCounterEvaluationTimeNs,           //!< суммарное время оценок, нс
+	eCounterCount
+};
+
+//! @brief Значения счетчиков самоконтроля
+struct statisticInstrumentationSnapshot
+{
+	statisticInstrumentationSnapshot()
+		: eventsIngested(0), evaluations(0), elementsScanned(0), bytesCopied(0),
+		  historyReallocations(0), evaluationTimeNs(0) {}
+
+	unsigned long long eventsIngested;
+	unsigned long long evaluations;
+	unsigned long long elementsScanned;
+	unsigned long long bytesCopied;
+	unsigned long long historyReallocations;
+	unsigned long long evaluationTimeNs;
+};
+
+#if defined(STATISTIC_INSTRUMENTATION)
+const bool c_instrumentationEnabled = true;
+#else
+const bool c_instrumentationEnabled = false;
+#endif
+
+//! @brief Сумма счетчиков всех потоков (включая завершенные)
+statisticInstrumentationSnapshot InstrumentationSnapshot();
+//! @brief Счетчики вызывающего потока
+statisticInstrumentationSnapshot ThreadInstrumentationSnapshot();
+//! @brief Обнуление счетчиков всех потоков (приращения, выполняемые в это время
+//! другими потоками, учитываются после обнуления)
+void ResetInstrumentation();
+
+// counters of one thread: written by the owner thread only, read by the snapshots;
+// a reset does not write the values, it keeps their current sum as the baseline
+// subtracted by the snapshots (a store of zero could be overwritten by the owner);
+// the padding keeps the counters of different threads on different cache lines
+struct instrumentationCounters
+{
+	char padBefore[64];
+	std::atomic<unsigned long long> values[eCounterCount];
+	std::atomic<unsigned long long> baseline[eCounterCount];
+	char padAfter[64];
+};
+
+// counters block of the calling thread, the blocks of finished threads are reused
+instrumentationCounters* RegisterThreadCounters();
+
+inline instrumentationCounters& ThreadCounters()
+{
+	static thread_local instrumentationCounters* counters = RegisterThreadCounters();
+	return *counters;
+}
+
+// single writer, so a relaxed load and store instead of a locked add
+inline void InstrumentationAdd(EInstrumentationCounter counter, unsigned long long n)
+{
+	std::atomic<unsigned long long>& value = ThreadCounters().values[counter];
+	value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// one evaluation over n elements, timed from construction to destruction
+class instrumentationScope
+{
+public:
+	explicit instrumentationScope(size_t n) : m_start(std::chrono::steady_clock::now())
+	{
+		InstrumentationAdd(eCounterEvaluations, 1);
+		InstrumentationAdd(eCounterElementsScanned, n);
+	}
+	~instrumentationScope()
+	{
+		const std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - m_start;
+		InstrumentationAdd(eCounterEvaluationTimeNs,
+			std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	}
+
+private:
+	// copy and assignment not allowed
+	instrumentationScope(const instrumentationScope&);
+	instrumentationScope& operator=(const instrumentationScope&);
+
+	std::chrono::steady_clock::time_point m_start;
+};
+//
+}
+
+// hooks of the instrumented code
+#if defined(STATISTIC_INSTRUMENTATION)
+#define STATISTIC_INSTRUMENT(counter, n) \
+	NStatisticEvaluations::InstrumentationAdd(NStatisticEvaluations::counter, (n))
+#define STATISTIC_INSTRUMENT_EVALUATION(n) \
+	NStatisticEvaluations::instrumentationScope statisticInstrumentationScope(n)
+#else
+#define STATISTIC_INSTRUMENT(counter, n) ((void)0)
+#define STATISTIC_INSTRUMENT_EVALUATION(n) ((void)0)
+#endif
+//
+#endif /* ___StatisticInstrumentation_H___ */
@@ -0,0 +1,262 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef ___StatisticKernels_H___
+#define ___StatisticKernels_H___
+
+#include <cstddef>
+#include <cstdlib>
+#include <cmath>
+#include <type_traits>
+#include <stdint.h>
+
+//
+namespace NStatisticKernels
+{
+//!@ingroup amgStatistic
+//! @brief Набор инструкций, используемый вычислительными ядрами
+enum EInstructionSet
+{
+	eInstructionSetScalar = 0,
+	eInstructionSetSSE2,
+	eInstructionSetAVX2,
+	eInstructionSetAVX512
+};
+
+//! @brief Способ суммирования вещественных массивов
+enum ESummationMode
+{
+	eSummationFast = 0,     //!< независимые аккумуляторы, ошибка O(n)
+	eSummationPairwise,     //!< блочное попарное суммирование, ошибка O(log n)
+	eSummationCompensated   //!< компенсированное суммирование (Неймайер), ошибка O(1)
+};
+
+//! @brief Лучший набор инструкций, поддерживаемый процессором (CPUID)
+EInstructionSet SupportedInstructionSet();
+//! @brief Набор инструкций, выбранный для вычислений
+EInstructionSet ActiveInstructionSet();
+//! @brief Ограничение набора инструкций (для тестов и замеров производительности).
+//! Набор, не поддерживаемый процессором, заменяется лучшим доступным.
+void SetInstructionSet(EInstructionSet set);
+
+//!@name Векторизованные ядра для float, double, int32 и int64
+//! Выбор реализации (SSE2/AVX2/AVX-512/скалярная) выполняется один раз во время
+//! выполнения. Min/Max требуют n > 0.
+//@{
+float SumKernel(const float* data, size_t n);
+double SumKernel(const double* data, size_t n);
+int32_t SumKernel(const int32_t* data, size_t n);
+int64_t SumKernel(const int64_t* data, size_t n);
+
+float MinKernel(const float* data, size_t n);
+double MinKernel(const double* data, size_t n);
+int32_t MinKernel(const int32_t* data, size_t n);
+int64_t MinKernel(const int64_t* data, size_t n);
+
+float MaxKernel(const float* data, size_t n);
+double MaxKernel(const double* data, size_t n);
+int32_t MaxKernel(const int32_t* data, size_t n);
+int64_t MaxKernel(const int64_t* data, size_t n);
+
+//! @brief Сумма квадратов отклонений от mean
+float SquaredDeviationKernel(const float* data, size_t n, float mean);
+double SquaredDeviationKernel(const double* data, size_t n, double mean);
+int32_t SquaredDeviationKernel(const int32_t* data, size_t n, int32_t mean);
+int64_t SquaredDeviationKernel(const int64_t* data, size_t n, int64_t mean);
+//@}
+
+//!@name Точное суммирование float и double
+//! Попарное суммирование выполняется векторным циклом по блокам из 256 значений
+//! и не уступает SumKernel по скорости; компенсированное примерно вдвое медленнее.
+//@{
+float PairwiseSumKernel(const float* data, size_t n);
+double PairwiseSumKernel(const double* data, size_t n);
+float CompensatedSumKernel(const float* data, size_t n);
+double CompensatedSumKernel(const double* data, size_t n);
+float PairwiseSquaredDeviationKernel(const float* data, size_t n, float mean);
+double PairwiseSquaredDeviationKernel(const double* data, size_t n, double mean);
+//@}
+
+// kernel type with the same representation as T (void if there is no kernel)
+template <class T> struct kernelType { typedef void type; };
+template <> struct kernelType<float> { typedef float type; };
+template <> struct kernelType<double> { typedef double type; };
+template <> struct kernelType<int>
+{
+	typedef std::conditional<sizeof(int) == 4, int32_t, void>::type type;
+};
+template <> struct kernelType<long>
+{
+	typedef std::conditional<sizeof(long) == 8, int64_t,
+		std::conditional<sizeof(long) == 4, int32_t, void>::type>::type type;
+};
+template <> struct kernelType<long long>
+{
+	typedef std::conditional<sizeof(long long) == 8, int64_t, void>::type type;
+};
+
+// generic loops, used for types without a kernel
+template <class T> T SumOf(const T* data, size_t n, void*)
+{
+	T sum = 0;
+	for (size_t i = 0; i < n; ++i)
+		sum += data[i];
+
+	return sum;
+}
+template <class T> T MinOf(const T* data, size_t n, void*)
+{
+	T min = data[0];
+	for (size_t i = 1; i < n; ++i)
+		min = data[i] < min ? data[i] : min;
+
+	return min;
+}
+template <class T> T MaxOf(const T* data, size_t n, void*)
+{
+	T max = data[0];
+	for (size_t i = 1; i < n; ++i)
+		max = data[i] > max ? data[i] : max;
+
+	return max;
+}
+template <class T> T SquaredDeviationOf(const T* data, size_t n, T mean, void*)
+{
+	T sum = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		const T k = data[i] - mean;
+		sum += k * k;
+	}
+
+	return sum;
+}
+
+template <class T> T SumOf(const T* data, size_t n, ESummationMode mode, void*)
+{
+	if (mode != eSummationCompensated)
+		return SumOf(data, n, (void*)0);
+
+	T sum = 0, error = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		const T t = sum + data[i];
+		error += std::abs(sum) >= std::abs(data[i]) ? (sum - t) + data[i] : (data[i] - t) + sum;
+		sum = t;
+	}
+
+	return sum + error;
+}
+template <class T> T SquaredDeviationOf(const T* data, size_t n, T mean, ESummationMode, void*)
+{
+	return SquaredDeviationOf(data, n, mean, (void*)0);
+}
+
+// kernel calls
+template <class T, class K> T SumOf(const T* data, size_t n, K*)
+{
+	return (T)SumKernel(reinterpret_cast<const K*>(data), n);
+}
+template <class T, class K> T MinOf(const T* data, size_t n, K*)
+{
+	return (T)MinKernel(reinterpret_cast<const K*>(data), n);
+}
+template <class T, class K> T MaxOf(const T* data, size_t n, K*)
+{
+	return (T)MaxKernel(reinterpret_cast<const K*>(data), n);
+}
+template <class T, class K> T SquaredDeviationOf(const T* data, size_t n, T mean, K*)
+{
+	return (T)SquaredDeviationKernel(reinterpret_cast<const K*>(data), n, (K)mean);
+}
+
+// summation modes, integer sums are exact in any order
+inline float SumOfMode(const float* data, size_t n, ESummationMode mode)
+{
+	return mode == eSummationPairwise ? PairwiseSumKernel(data, n)
+		: mode == eSummationCompensated ? CompensatedSumKernel(data, n) : SumKernel(data, n);
+}
+inline double SumOfMode(const double* data, size_t n, ESummationMode mode)
+{
+	return mode == eSummationPairwise ? PairwiseSumKernel(data, n)
+		: mode == eSummationCompensated ? CompensatedSumKernel(data, n) : SumKernel(data, n);
+}
+template <class K> K SumOfMode(const K* data, size_t n, ESummationMode)
+{
+	return SumKernel(data, n);
+}
+inline float SquaredDeviationOfMode(const float* data, size_t n, float mean, ESummationMode mode)
+{
+	return mode == eSummationFast ? SquaredDeviationKernel(data, n, mean)
+		: PairwiseSquaredDeviationKernel(data, n, mean);
+}
+inline double SquaredDeviationOfMode(const double* data, size_t n, double mean, ESummationMode mode)
+{
+	return mode == eSummationFast ? SquaredDeviationKernel(data, n, mean)
+		: PairwiseSquaredDeviationKernel(data, n, mean);
+}
+template <class K> K SquaredDeviationOfMode(const K* data, size_t n, K mean, ESummationMode)
+{
+	return SquaredDeviationKernel(data, n, mean);
+}
+
+template <class T, class K> T SumOf(const T* data, size_t n, ESummationMode mode, K*)
+{
+	return (T)SumOfMode(reinterpret_cast<const K*>(data), n, mode);
+}
+template <class T, class K> T SquaredDeviationOf(const T* data, size_t n, T mean, ESummationMode mode, K*)
+{
+	return (T)SquaredDeviationOfMode(reinterpret_cast<const K*>(data), n, (K)mean, mode);
+}
+
+//! @brief Сумма элементов массива
+template <class T> T Sum(const T* data, size_t n)
+{
+	return SumOf(data, n, (typename kernelType<T>::type*)0);
+}
+//! @brief Сумма элементов массива выбранным способом
+template <class T> T Sum(const T* data, size_t n, ESummationMode mode)
+{
+	return SumOf(data, n, mode, (typename kernelType<T>::type*)0);
+}
+//! @brief Минимальный элемент массива (n > 0)
+template <class T> T Min(const T* data, size_t n)
+{
+	return MinOf(data, n, (typename kernelType<T>::type*)0);
+}
+//! @brief Максимальный элемент массива (n > 0)
+template <class T> T Max(const T* data, size_t n)
+{
+	return MaxOf(data, n, (typename kernelType<T>::type*)0);
+}
+//! @brief Сумма квадратов отклонений элементов массива от mean
+template <class T> T SquaredDeviation(const T* data, size_t n, T mean)
+{
+	return SquaredDeviationOf(data, n, mean, (typename kernelType<T>::type*)0);
+}
+//! @brief Сумма квадратов отклонений от mean выбранным способом
+//! (для eSummationCompensated используется попарное суммирование)
+template <class T> T SquaredDeviation(const T* data, size_t n, T mean, ESummationMode mode)
+{
+	return SquaredDeviationOf(data, n, mean, mode, (typename kernelType<T>::type*)0);
+}
+//
+}
+//
+#endif /* ___StatisticKernels_H___ */
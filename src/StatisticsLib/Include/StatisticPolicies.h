@@ -0,0 +1,279 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticPolicies_H___
+#define ___StatisticPolicies_H___
+
+#include <limits>
+#include <math.h>
+
+// constexpr for the functions that modify the object (C++14 and later)
+#ifndef STATISTIC_CONSTEXPR14
+#if __cplusplus >= 201402L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+#define STATISTIC_CONSTEXPR14 constexpr
+#else
+#define STATISTIC_CONSTEXPR14
+#endif
+#endif
+
+//
+namespace NStatistic
+{
+// empty bases take no space in MSVC too (GCC and Clang always lay them out so)
+#ifndef STATISTIC_EMPTY_BASES
+#if defined(_MSC_VER)
+#define STATISTIC_EMPTY_BASES __declspec(empty_bases)
+#else
+#define STATISTIC_EMPTY_BASES
+#endif
+#endif
+
+// Count, Mean and Variance share one running count, mean and sum of squared
+// deviations (Welford): the statistic keeps the moments of the highest order
+// requested and their parts only read them
+template <class T, int Order> class statisticMoments;
+
+template <class T> class statisticMoments<T, 0>
+{
+public:
+	constexpr statisticMoments() {}
+
+	STATISTIC_CONSTEXPR14 void AddMoments(T) {}
+	STATISTIC_CONSTEXPR14 void ResetMoments() {}
+};
+
+template <class T> class statisticMoments<T, 1>
+{
+public:
+	constexpr statisticMoments() : m_n(0) {}
+
+	STATISTIC_CONSTEXPR14 void AddMoments(T) { ++m_n; }
+	STATISTIC_CONSTEXPR14 void ResetMoments() { m_n = 0; }
+
+	long long m_n;
+};
+
+template <class T> class statisticMoments<T, 2>
+{
+public:
+	constexpr statisticMoments() : m_n(0), m_mean(0.0) {}
+
+	STATISTIC_CONSTEXPR14 void AddMoments(T value)
+	{
+		++m_n;
+		m_mean += ((double)value - m_mean) / m_n;
+	}
+	STATISTIC_CONSTEXPR14 void ResetMoments() { m_n = 0; m_mean = 0.0; }
+
+	long long m_n;
+	double m_mean;
+};
+
+template <class T> class statisticMoments<T, 3>
+{
+public:
+	constexpr statisticMoments() : m_n(0), m_mean(0.0), m_m2(0.0) {}
+
+	STATISTIC_CONSTEXPR14 void AddMoments(T value)
+	{
+		++m_n;
+		const double delta = (double)value - m_mean;
+		m_mean += delta / m_n;
+		m_m2 += delta * ((double)value - m_mean);
+	}
+	STATISTIC_CONSTEXPR14 void ResetMoments() { m_n = 0; m_mean = m_m2 = 0.0; }
+
+	long long m_n;
+	double m_mean, m_m2;
+};
+
+// order of the moments a policy reads (0 - none)
+template <class Policy> struct statisticPolicyMoments { static const int value = 0; };
+
+template <class... Policies> struct statisticMomentsOrder;
+template <> struct statisticMomentsOrder<> { static const int value = 0; };
+template <class Policy, class... Policies> struct statisticMomentsOrder<Policy, Policies...>
+{
+	static const int value = statisticPolicyMoments<Policy>::value > statisticMomentsOrder<Policies...>::value ?
+		statisticPolicyMoments<Policy>::value : statisticMomentsOrder<Policies...>::value;
+};
+
+//!@name Стратегии (policies) статистики statistic<T, Policies...>
+//! Каждая стратегия добавляет в объект статистики только свои поля и методы;
+//! Count, Mean и Variance используют общие количество и среднее значение.
+//! Часть стратегии part<T, S> получает тип статистики S.
+//@{
+//! @brief Количество значений (GetCount)
+struct Count
+{
+	template <class T, class S> class part
+	{
+	public:
+		STATISTIC_CONSTEXPR14 void Add(T) {}
+		STATISTIC_CONSTEXPR14 void Reset() {}
+
+		constexpr long long GetCount() const { return static_cast<const S&>(*this).m_n; }
+	};
+};
+
+//! @brief Сумма значений (GetSum)
+struct Sum
+{
+	template <class T, class S> class part
+	{
+	public:
+		constexpr part() : m_sum(0) {}
+
+		STATISTIC_CONSTEXPR14 void Add(T value) { m_sum += value; }
+		STATISTIC_CONSTEXPR14 void Reset() { m_sum = 0; }
+
+		constexpr T GetSum() const { return m_sum; }
+
+	private:
+		T m_sum;
+	};
+};
+
+//! @brief Минимум и максимум (GetMin, GetMax; для пустой статистики - границы типа)
+struct MinMax
+{
+	template <class T, class S> class part
+	{
+	public:
+		constexpr part() : m_min(std::numeric_limits<T>::max()), m_max(std::numeric_limits<T>::lowest()) {}
+
+		STATISTIC_CONSTEXPR14 void Add(T value)
+		{
+			m_min = value < m_min ? value : m_min;
+			m_max = value > m_max ? value : m_max;
+		}
+		STATISTIC_CONSTEXPR14 void Reset()
+		{
+			m_min = std::numeric_limits<T>::max();
+			m_max = std::numeric_limits<T>::lowest();
+		}
+
+		constexpr T GetMin() const { return m_min; }
+		constexpr T GetMax() const { return m_max; }
+
+	private:
+		T m_min, m_max;
+	};
+};
+
+//! @brief Среднее значение (GetMean)
+struct Mean
+{
+	template <class T, class S> class part
+	{
+	public:
+		STATISTIC_CONSTEXPR14 void Add(T) {}
+		STATISTIC_CONSTEXPR14 void Reset() {}
+
+		constexpr double GetMean() const { return static_cast<const S&>(*this).m_mean; }
+	};
+};
+
+//! @brief Дисперсия и среднеквадратическое отклонение (GetDispersion, GetStdDeviation),
+//! рекуррентная формула Велфорда
+struct Variance
+{
+	template <class T, class S> class part
+	{
+	public:
+		STATISTIC_CONSTEXPR14 void Add(T) {}
+		STATISTIC_CONSTEXPR14 void Reset() {}
+
+		constexpr double GetDispersion() const
+		{
+			return static_cast<const S&>(*this).m_n > 0 ?
+				static_cast<const S&>(*this).m_m2 / static_cast<const S&>(*this).m_n : 0.0;
+		}
+		double GetStdDeviation() const { return sqrt(GetDispersion()); }
+	};
+};
+//@}
+
+template <> struct statisticPolicyMoments<Count> { static const int value = 1; };
+template <> struct statisticPolicyMoments<Mean> { static const int value = 2; };
+template <> struct statisticPolicyMoments<Variance> { static const int value = 3; };
+
+//!@ingroup amgStatistic
+//! @brief Статистика с выбранными при компиляции оценками
+//!
+//! Объект содержит только поля перечисленных стратегий (количество и среднее
+//! значение - одни на все стратегии) и размещается без выделения динамической
+//! памяти; добавление значения обновляет только их.
+//! Начиная с C++14 объект можно заполнить и опросить в constexpr-выражении.
+//! statistic<T> без стратегий - прежний класс статистики (Statistic.h).
+//!
+//! Пример:
+//! @code
+//!    statistic<double, Count, Sum, MinMax, Variance> latency;
+//!    latency.Add(1.5);
+//!    latency.Add(2.5);
+//!    cout << latency.GetCount() << " " << latency.GetSum() << " " << latency.GetMax() << " "
+//!         << latency.GetStdDeviation() << endl;
+//!
+//!    constexpr double data[] = {1.0, 2.0, 3.0};
+//!    static_assert(statistic<double, Sum>(data).GetSum() == 6.0, "");   // C++14
+//! @endcode
+template <class T, class... Policies>
+class STATISTIC_EMPTY_BASES statistic
+	: public statisticMoments<T, statisticMomentsOrder<Policies...>::value>,
+	  public Policies::template part<T, statistic<T, Policies...> >...
+{
+	typedef statisticMoments<T, statisticMomentsOrder<Policies...>::value> moments;
+
+public:
+	constexpr statistic() {}
+   //! @brief Статистика массива значений
+	template <size_t N>
+	STATISTIC_CONSTEXPR14 explicit statistic(const T (&data)[N])
+	{
+		AddRange(data, data + N);
+	}
+
+   //! @brief Добавление значения
+	STATISTIC_CONSTEXPR14 void Add(T value)
+	{
+		moments::AddMoments(value);
+		const int expand[] = {0, (Policies::template part<T, statistic>::Add(value), 0)...};
+		(void)expand;
+	}
+   //! @brief Добавление диапазона значений
+	template <class It>
+	STATISTIC_CONSTEXPR14 void AddRange(It first, It last)
+	{
+		for (; first != last; ++first)
+			Add(*first);
+	}
+   //! @brief Сброс всех значений
+	STATISTIC_CONSTEXPR14 void Reset()
+	{
+		moments::ResetMoments();
+		const int expand[] = {0, (Policies::template part<T, statistic>::Reset(), 0)...};
+		(void)expand;
+	}
+};
+//
+}
+//
+#endif /* ___StatisticPolicies_H___ */
@@ -0,0 +1,161 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticRadixSort_H___
+#define ___StatisticRadixSort_H___
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <stdint.h>
+
+#include "StatisticThreadPool.h"
+
+//
+namespace NStatisticEvaluations
+{
+// unsigned key with the order of T (void if T has no key)
+template <class T, class Enable = void> struct radixKey
+{
+	typedef void type;
+};
+template <class T> struct radixKey<T, typename std::enable_if<std::is_integral<T>::value
+	&& !std::is_same<T, bool>::value>::type>
+{
+	typedef typename std::make_unsigned<T>::type type;
+
+	static type Key(T value)
+	{
+		// signed values: the sign bit is flipped
+		const type sign = std::is_signed<T>::value ? type(type(1) << (sizeof(T) * 8 - 1)) : type(0);
+		return type(type(value) ^ sign);
+	}
+};
+template <class T> struct radixKey<T, typename std::enable_if<std::is_floating_point<T>::value
+	&& (sizeof(T) == 4 || sizeof(T) == 8)>::type>
+{
+	typedef typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type type;
+
+	static type Key(T value)
+	{
+		// negative values: all bits flipped, positive values: the sign bit set
+		type bits;
+		memcpy(&bits, &value, sizeof(T));
+		const type sign = type(1) << (sizeof(T) * 8 - 1);
+		return (bits & sign) ? type(~bits) : type(bits | sign);
+	}
+};
+
+//!@ingroup amgStatistic
+//! @brief Параллельная поразрядная сортировка (LSD, разряды по 8 бит)
+//!
+//! Сортирует целые и float/double значения за sizeof(T) проходов: гистограммы
+//! частей массива строятся на потоках пула, затем каждая часть переносит свои
+//! значения в вычисленные позиции. Проходы с одинаковым разрядом у всех
+//! значений пропускаются. Для остальных типов используется std::sort.
+//! @param[in,out] data Сортируемые значения
+//! @param[in,out] buffer Вспомогательный буфер (размер меняется при необходимости)
+//! @param[in] pool Пул потоков
+template <class T>
+void ParallelRadixSort(std::vector<T>& data, std::vector<T>& buffer, statisticThreadPool& pool);
+
+// types without a key
+template <class T>
+void RadixSort(std::vector<T>& data, std::vector<T>&, statisticThreadPool&, void*)
+{
+	std::sort(data.begin(), data.end());
+}
+
+template <class T, class K>
+void RadixSort(std::vector<T>& data, std::vector<T>& buffer, statisticThreadPool& pool, K*)
+{
+	const size_t c_digits = 256;
+	const size_t n = data.size();
+	if (n < 2)
+		return;
+	buffer.resize(n);
+
+	size_t parts = pool.ThreadsCount();
+	if (parts > n / 4096)
+		parts = n / 4096;
+	if (parts < 1)
+		parts = 1;
+	const size_t chunk = n / parts;
+
+	// counts[part][digit], then the output positions
+	std::vector<size_t> counts(parts * c_digits);
+	T* source = &data[0];
+	T* target = &buffer[0];
+
+	for (size_t pass = 0; pass < sizeof(T); ++pass)
+	{
+		const int shift = static_cast<int>(pass * 8);
+		std::fill(counts.begin(), counts.end(), 0);
+		pool.ParallelFor(parts, [&](size_t part)
+		{
+			size_t* count = &counts[part * c_digits];
+			const size_t end = part + 1 == parts ? n : (part + 1) * chunk;
+			for (size_t i = part * chunk; i < end; ++i)
+				++count[(radixKey<T>::Key(source[i]) >> shift) & 0xFF];
+		});
+
+		// a digit shared by all values does not change the order
+		size_t position = 0;
+		bool skip = false;
+		for (size_t digit = 0; digit < c_digits && !skip; ++digit)
+		{
+			size_t total = 0;
+			for (size_t part = 0; part < parts; ++part)
+			{
+				const size_t count = counts[part * c_digits + digit];
+				counts[part * c_digits + digit] = position + total;
+				total += count;
+			}
+			skip = total == n;
+			position += total;
+		}
+		if (skip)
+			continue;
+
+		pool.ParallelFor(parts, [&](size_t part)
+		{
+			size_t* offset = &counts[part * c_digits];
+			const size_t end = part + 1 == parts ? n : (part + 1) * chunk;
+			for (size_t i = part * chunk; i < end; ++i)
+				target[offset[(radixKey<T>::Key(source[i]) >> shift) & 0xFF]++] = source[i];
+		});
+		std::swap(source, target);
+	}
+
+	if (source != &data[0])
+		data.swap(buffer);
+}
+
+template <class T>
+void ParallelRadixSort(std::vector<T>& data, std::vector<T>& buffer, statisticThreadPool& pool)
+{
+	RadixSort(data, buffer, pool, (typename radixKey<T>::type*)0);
+}
+//
+}
+//
+#endif /* ___StatisticRadixSort_H___ */
@@ -0,0 +1,112 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticRate_H___
+#define ___StatisticRate_H___
+
+#include <atomic>
+
+#include "StatisticClock.h"
+
+//
+namespace NStatisticEvents
+{
+//!@ingroup amgStatistic
+//! @brief Измеритель скорости поступления событий
+//!
+//! Экспоненциально сглаженные скорости за 1, 5 и 15 минут (пересчет раз в 5 с,
+//! выполняется при записи или чтении), мгновенная скорость по счетчику событий
+//! за последнюю завершенную секунду и средняя скорость с момента запуска.
+//! Запись и чтение выполняются за O(1) без блокировок; чтение из другого потока
+//! (например, потока мониторинга) не задерживает запись. Время - монотонное, нс.
+//!
+//! Пример:
+//! @code
+//!    statisticRateMeter meter;
+//!    meter.Mark();
+//!    ...
+//!    double rate = meter.OneMinuteRate();    // событий/с
+//! @endcode
+class statisticRateMeter
+{
+public:
+	statisticRateMeter();
+	explicit statisticRateMeter(long long startTime);
+	statisticRateMeter(const statisticRateMeter& other);
+	statisticRateMeter& operator=(const statisticRateMeter& other);
+
+   //! @brief Регистрация n событий
+	void Mark(unsigned long long n = 1) { Mark(n, SteadyClockNs()); }
+   //! @brief Регистрация n событий в момент времени now, нс
+	void Mark(unsigned long long n, long long now);
+
+   //! @brief Количество зарегистрированных событий
+	unsigned long long Count() const { return m_count.load(std::memory_order_relaxed); }
+
+   //!@name Скорость, событий/с (now - момент времени, нс)
+   //@{
+	double MeanRate() const { return MeanRate(SteadyClockNs()); }
+	double MeanRate(long long now) const;
+	double OneMinuteRate() const { return OneMinuteRate(SteadyClockNs()); }
+	double OneMinuteRate(long long now) const { return Rate(eRateOneMinute, now); }
+	double FiveMinuteRate() const { return FiveMinuteRate(SteadyClockNs()); }
+	double FiveMinuteRate(long long now) const { return Rate(eRateFiveMinute, now); }
+	double FifteenMinuteRate() const { return FifteenMinuteRate(SteadyClockNs()); }
+	double FifteenMinuteRate(long long now) const { return Rate(eRateFifteenMinute, now); }
+   //! @brief Количество событий за последнюю завершенную секунду
+	double InstantRate() const { return InstantRate(SteadyClockNs()); }
+	double InstantRate(long long now) const;
+   //@}
+
+   //! @brief Сброс измерителя (не выполняется одновременно с записью)
+	void Reset() { Reset(SteadyClockNs()); }
+	void Reset(long long startTime);
+
+   //! @brief Интервал пересчета сглаженных скоростей, нс
+	static const long long c_tickInterval = 5000000000LL;
+
+private:
+	enum ERate
+	{
+		eRateOneMinute = 0,
+		eRateFiveMinute,
+		eRateFifteenMinute,
+		eRatesCount
+	};
+
+	// per second counters: the second tag in the high bits, the count in the low bits
+	static const int c_bucketsCount = 4;
+	static const int c_countBits = 40;
+
+	double Rate(ERate rate, long long now) const;
+	void Tick(long long now) const;
+	void CopyFrom(const statisticRateMeter& other);
+
+	std::atomic<unsigned long long> m_count;
+	mutable std::atomic<unsigned long long> m_uncounted;  // events since the last tick
+	mutable std::atomic<long long> m_lastTick;
+	mutable std::atomic<double> m_rates[eRatesCount];    // events/s, < 0 until the first tick
+	std::atomic<unsigned long long> m_buckets[c_bucketsCount];
+	std::atomic<long long> m_startTime;
+};
+//
+}
+//
+#endif /* ___StatisticRate_H___ */
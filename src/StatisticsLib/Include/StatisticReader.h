@@ -0,0 +1,319 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticReader_H___
+#define ___StatisticReader_H___
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <type_traits>
+
+#include "StatisticEvents.h"
+
+//
+namespace NStatisticEvents
+{
+//!@name Разбор чисел без выделения памяти
+//! Разбирается число в начале [first, last); возвращается указатель на первый
+//! символ после числа (first, если число не найдено). Вещественные числа с
+//! мантиссой до 2^53 и десятичным порядком до 22 переводятся точно одним
+//! умножением или делением (быстрый путь Клингера), остальные - strtod.
+//@{
+const char* StatisticParseNumber(const char* first, const char* last, double& value);
+const char* StatisticParseNumber(const char* first, const char* last, long long& value);
+//@}
+
+//! @brief Размер блока чтения файла по умолчанию
+const size_t c_readerChunkSize = 1 << 22;
+
+//!@ingroup amgStatistic
+//! @brief Чтение файла блоками в фоновом потоке с двойной буферизацией
+//!
+//! Пока вызывающий поток обрабатывает один блок, фоновый поток читает
+//! следующий во второй буфер. Все блоки, кроме последнего, имеют размер chunkSize.
+class statisticChunkReader
+{
+public:
+	statisticChunkReader();
+	~statisticChunkReader() { Close(); }
+
+	bool Open(const std::string& path, size_t chunkSize = c_readerChunkSize);
+	void Close();
+
+   /*!@brief Следующий блок файла (предыдущий блок возвращается фоновому потоку)
+   * @return false - конец файла или ошибка чтения
+   */
+	bool Next(const char*& data, size_t& size);
+   //! @brief Ошибка чтения
+	bool IsFailed() const { return m_failed; }
+
+private:
+	// copy and assignment not allowed
+	statisticChunkReader(const statisticChunkReader&);
+	statisticChunkReader& operator=(const statisticChunkReader&);
+
+	void ReadLoop();
+
+	std::FILE* m_file;
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+
+	std::vector<char> m_buffers[2];     // double buffering
+	size_t m_sizes[2];
+	bool m_full[2];                     // filled and not yet released by the consumer
+	int m_current;                      // buffer held by the consumer, -1 if none
+	bool m_done;                        // no more chunks
+	bool m_failed;
+	bool m_stop;
+};
+
+//!@ingroup amgStatistic
+//! @brief Потоковое чтение числового столбца CSV-файла
+//!
+//! Файл читается блоками в фоновом потоке, числа разбираются без iostream и
+//! передаются обработчику пакетами по одному на блок, так что обработка
+//! пакета совмещается с чтением следующего блока. Строки, в которых столбец не
+//! является числом (заголовок), пропускаются.
+//!
+//! Пример:
+//! @code
+//!    statisticCsvReader<double> csv(2);   // третий столбец
+//!    if (csv.Open("capture.csv"))
+//!        csv.ReadTo(*ex_d.GetStatEvents());
+//! @endcode
+template <class T> class statisticCsvReader
+{
+public:
+   /*!@brief Конструктор
+   * @param[in] column Номер столбца (с 0)
+   * @param[in] delimiter Разделитель столбцов
+   */
+	explicit statisticCsvReader(size_t column = 0, char delimiter = ',')
+		: m_column(column), m_delimiter(delimiter), m_skippedLines(0) {}
+
+	bool Open(const std::string& path, size_t chunkSize = c_readerChunkSize);
+	void Close() { m_chunks.Close(); m_carry.clear(); }
+
+   //! @brief Чтение всех значений, consumer(const T* values, size_t n) - по пакетам
+	template <class F> unsigned long long Read(F consumer);
+   //! @brief Чтение всех значений в очередь событий (пакетами)
+	unsigned long long ReadTo(statisticEvents<T>& events)
+	{
+		return Read([&events](const T* values, size_t n) { events.StatisticEvents(values, n); });
+	}
+
+   //! @brief Количество пропущенных строк
+	unsigned long long GetSkippedLines() const { return m_skippedLines; }
+	bool IsFailed() const { return m_chunks.IsFailed(); }
+
+private:
+	void ParseLine(const char* first, const char* last);
+	static const char* ParseValue(const char* first, const char* last, T& value);
+
+	statisticChunkReader m_chunks;
+	size_t m_column;
+	char m_delimiter;
+	std::vector<T> m_values;            // values of the current chunk
+	std::vector<char> m_carry;          // line split between two chunks
+	unsigned long long m_skippedLines;
+};
+
+//!@ingroup amgStatistic
+//! @brief Потоковое чтение двоичного файла значений T (машинный порядок байт)
+//!
+//! Значения передаются обработчику прямо из буферов чтения, без копирования.
+template <class T> class statisticBinaryReader
+{
+public:
+	bool Open(const std::string& path, size_t chunkSize = c_readerChunkSize)
+	{
+		// whole values in every chunk
+		chunkSize = chunkSize < sizeof(T) ? sizeof(T) : chunkSize - chunkSize % sizeof(T);
+		return m_chunks.Open(path, chunkSize);
+	}
+	void Close() { m_chunks.Close(); }
+
+   //! @brief Чтение всех значений, consumer(const T* values, size_t n) - по блокам
+	template <class F> unsigned long long Read(F consumer);
+   //! @brief Чтение всех значений в очередь событий (блоками)
+	unsigned long long ReadTo(statisticEvents<T>& events)
+	{
+		return Read([&events](const T* values, size_t n) { events.StatisticEvents(values, n); });
+	}
+
+	bool IsFailed() const { return m_chunks.IsFailed(); }
+
+private:
+	statisticChunkReader m_chunks;
+};
+
+// csv reader
+template <class T>
+bool statisticCsvReader<T>::Open(const std::string& path, size_t chunkSize)
+{
+	m_carry.clear();
+	m_values.clear();
+	m_skippedLines = 0;
+	return m_chunks.Open(path, chunkSize);
+}
+
+template <class T>
+template <class F>
+unsigned long long statisticCsvReader<T>::Read(F consumer)
+{
+	unsigned long long total = 0;
+	const char* data = 0;
+	size_t size = 0;
+	while (m_chunks.Next(data, size))
+	{
+		m_values.clear();
+		const char* const end = data + size;
+		const char* line = data;
+		if (!m_carry.empty())
+		{
+			// finish the line started in the previous chunk
+			const char* eol = static_cast<const char*>(memchr(data, '\n', size));
+			m_carry.insert(m_carry.end(), data, eol ? eol : end);
+			if (!eol)
+				continue;
+
+			ParseLine(&m_carry[0], &m_carry[0] + m_carry.size());
+			m_carry.clear();
+			line = eol + 1;
+		}
+		for (;;)
+		{
+			const char* eol = static_cast<const char*>(memchr(line, '\n', end - line));
+			if (!eol)
+				break;
+
+			ParseLine(line, eol);
+			line = eol + 1;
+		}
+		m_carry.assign(line, end);
+
+		if (!m_values.empty())
+		{
+			consumer(&m_values[0], m_values.size());
+			total += m_values.size();
+		}
+	}
+
+	// the last line without an end of line
+	if (!m_carry.empty())
+	{
+		m_values.clear();
+		ParseLine(&m_carry[0], &m_carry[0] + m_carry.size());
+		m_carry.clear();
+		if (!m_values.empty())
+		{
+			consumer(&m_values[0], m_values.size());
+			total += m_values.size();
+		}
+	}
+	return total;
+}
+
+template <class T>
+void statisticCsvReader<T>::ParseLine(const char* first, const char* last)
+{
+	if (first != last && last[-1] == '\r')
+		--last;
+	if (first == last)
+		return;
+
+	// the field of the column
+	for (size_t column = 0; column < m_column; ++column)
+	{
+		const char* delimiter = static_cast<const char*>(memchr(first, m_delimiter, last - first));
+		if (!delimiter)
+		{
+			++m_skippedLines;
+			return;
+		}
+		first = delimiter + 1;
+	}
+	const char* delimiter = static_cast<const char*>(memchr(first, m_delimiter, last - first));
+	if (delimiter)
+		last = delimiter;
+
+	while (first != last && (*first == ' ' || *first == '\t'))
+		++first;
+	while (first != last && (last[-1] == ' ' || last[-1] == '\t'))
+		--last;
+
+	T value;
+	if (first != last && ParseValue(first, last, value) == last)
+		m_values.push_back(value);
+	else
+		++m_skippedLines;
+}
+
+template <class T>
+const char* statisticCsvReader<T>::ParseValue(const char* first, const char* last, T& value)
+{
+	if (std::is_integral<T>::value)
+	{
+		long long integer = 0;
+		const char* end = StatisticParseNumber(first, last, integer);
+		if (end == last)
+		{
+			value = static_cast<T>(integer);
+			return end;
+		}
+	}
+
+	double real = 0;
+	const char* end = StatisticParseNumber(first, last, real);
+	value = static_cast<T>(real);
+	return end;
+}
+
+// binary reader
+template <class T>
+template <class F>
+unsigned long long statisticBinaryReader<T>::Read(F consumer)
+{
+	unsigned long long total = 0;
+	const char* data = 0;
+	size_t size = 0;
+	while (m_chunks.Next(data, size))
+	{
+		// a trailing partial value is ignored
+		const size_t n = size / sizeof(T);
+		if (n)
+		{
+			consumer(reinterpret_cast<const T*>(data), n);
+			total += n;
+		}
+	}
+	return total;
+}
+//
+}
+//
+#endif /* ___StatisticReader_H___ */
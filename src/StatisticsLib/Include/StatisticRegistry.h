@@ -0,0 +1,429 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticRegistry_H___
+#define ___StatisticRegistry_H___
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "StatisticAccumulator.h"
+#include "StatisticSnapshot.h"
+
+//
+namespace NStatisticEvaluations
+{
+//! @brief Хеш целочисленного идентификатора ряда
+inline uint64_t StatisticHashId(uint64_t id)
+{
+	// splitmix64 finalizer
+	id ^= id >> 30;
+	id *= 0xBF58476D1CE4E5B9ULL;
+	id ^= id >> 27;
+	id *= 0x94D049BB133111EBULL;
+	return id ^ (id >> 31);
+}
+//! @brief Хеш имени ряда (64 бит), вычисляется заранее для горячих путей
+inline uint64_t StatisticHash(const char* name, size_t length)
+{
+	// 8 bytes per step, then the finalizer spreads the bits over the index and the tag
+	return StatisticHashId(StatisticChecksum(name, length, length));
+}
+inline uint64_t StatisticHash(const std::string& name) { return StatisticHash(name.data(), name.size()); }
+
+//! @brief Ключ ряда реестра: имя или целочисленный идентификатор
+struct statisticRegistryKey
+{
+	statisticRegistryKey() : name(0), length(0), id(0) {}
+
+	bool IsId() const { return name == 0; }
+	std::string Name() const { return name ? std::string(name, length) : std::string(); }
+
+	const char* name;                   // not null terminated
+	size_t length;
+	uint64_t id;
+};
+
+//!@ingroup amgStatistic
+//! @brief Реестр именованных рядов статистики (в стиле statsd)
+//!
+//! Отображает имена или целочисленные идентификаторы рядов на накопители
+//! statisticAccumulator<T>. Индекс - хеш-таблица с открытой адресацией
+//! (линейное пробирование, 8 байт на ячейку), накопители лежат в блоках по
+//! 1024 ряда и не перемещаются, имена - в общем буфере. Ряд занимает около
+//! 90 байт и его имя, без отдельного выделения памяти на ряд.
+//!
+//! Описатель (handle) - номер ряда, постоянный до Clear(): запись по описателю
+//! не вычисляет хеш и не обращается к индексу. Реестр не синхронизирован;
+//! реестры потоков объединяются методом Merge.
+//!
+//! Пример:
+//! @code
+//!    statisticRegistry<double> registry;
+//!    const statisticRegistry<double>::handle latency = registry.Handle("http.latency");
+//!    registry.Add(latency, 12.5);
+//!    registry.AddId(42, 1.0);
+//!    registry.ForEach([](const statisticRegistryKey& key, const statisticAccumulator<double>& value)
+//!    {
+//!       cout << key.Name() << ": " << value.GetMean() << endl;
+//!    });
+//!    registry.ResetValues();
+//! @endcode
+template <class T> class statisticRegistry
+{
+public:
+	typedef statisticAccumulator<T> accumulator_type;
+	typedef uint32_t handle;
+
+   //! @brief Конструктор, expected - ожидаемое количество рядов
+	explicit statisticRegistry(size_t expected = 0);
+	~statisticRegistry();
+
+   //!@name Описатель ряда (ряд создается при первом обращении)
+   //@{
+	handle Handle(const char* name, size_t length, uint64_t hash);
+	handle Handle(const char* name) { return Handle(name, strlen(name), StatisticHash(name, strlen(name))); }
+	handle Handle(const std::string& name) { return Handle(name.data(), name.size(), StatisticHash(name)); }
+	handle HandleId(uint64_t id, uint64_t hash);
+	handle HandleId(uint64_t id) { return HandleId(id, StatisticHashId(id)); }
+   //@}
+
+   //!@name Добавление значения в ряд
+   //@{
+	void Add(handle series, T value) { Slot(series).accumulator.Add(value); }
+	void Add(const std::string& name, T value) { Add(Handle(name), value); }
+	void AddId(uint64_t id, T value) { Add(HandleId(id), value); }
+   //@}
+
+   //!@name Доступ к накопителям
+   //@{
+	accumulator_type& Get(handle series) { return Slot(series).accumulator; }
+	const accumulator_type& Get(handle series) const { return Slot(series).accumulator; }
+	statisticRegistryKey Key(handle series) const;
+	//! @brief Поиск ряда без создания (0 - ряда нет)
+	const accumulator_type* Find(const char* name, size_t length, uint64_t hash) const;
+	const accumulator_type* Find(const std::string& name) const { return Find(name.data(), name.size(), StatisticHash(name)); }
+	const accumulator_type* FindId(uint64_t id) const;
+   //@}
+
+   //! @brief Количество рядов
+	size_t Size() const { return m_size; }
+   //! @brief Память реестра, байт
+	size_t MemoryUsage() const;
+
+   /*!@brief Обход рядов в порядке создания (для выгрузки)
+   * @param[in] f Функтор f(const statisticRegistryKey&, const accumulator_type&)
+   */
+	template <class F> void ForEach(F f) const;
+   //! @brief Добавление рядов другого реестра (накопители объединяются по ключу)
+	void Merge(const statisticRegistry<T>& other);
+   //! @brief Сброс значений всех рядов; ряды и описатели сохраняются
+	void ResetValues();
+   //! @brief Удаление всех рядов (описатели становятся недействительными)
+	void Clear();
+	void Swap(statisticRegistry<T>& other);
+
+   //!@name Снимок состояния (StatisticSnapshot.h): ключи и накопители всех рядов
+   //@{
+	static uint32_t SnapshotKind() { return NStatisticEvaluations::SnapshotKind(eSnapshotRegistry, SnapshotValueType<T>()); }
+	void SaveState(statisticSnapshotWriter& writer) const;
+	bool LoadState(statisticSnapshotReader& reader);
+   //@}
+
+private:
+	// copy and assignment not allowed
+	statisticRegistry(const statisticRegistry<T>&);
+	statisticRegistry<T>& operator=(const statisticRegistry<T>&);
+
+	// series: accumulator, hash and key (integer id or name offset in m_names)
+	struct slot
+	{
+		accumulator_type accumulator;
+		uint64_t hash;
+		uint64_t key;
+		uint32_t length;                 // name length, c_idKey for the integer ids
+	};
+	// index cell: upper half of the hash and the series number + 1 (0 - empty)
+	struct cell
+	{
+		uint32_t tag;
+		uint32_t series;
+	};
+
+	static const uint32_t c_idKey = 0xFFFFFFFFu;
+	static const size_t c_chunkBits = 10;
+	static const size_t c_chunkSize = size_t(1) << c_chunkBits;
+
+	slot& Slot(handle series) { return m_chunks[series >> c_chunkBits][series & (c_chunkSize - 1)]; }
+	const slot& Slot(handle series) const { return m_chunks[series >> c_chunkBits][series & (c_chunkSize - 1)]; }
+
+	bool SameKey(const slot& s, const char* name, size_t length) const
+	{
+		return s.length == length && !memcmp(m_names.data() + s.key, name, length);
+	}
+	// index cell of the key or the empty cell where it goes
+	template <class Equal> size_t Probe(uint64_t hash, Equal equal) const;
+	handle Insert(size_t cell, uint64_t hash, uint64_t key, uint32_t length);
+	void Rehash(size_t capacity);
+
+	std::vector<cell> m_index;          // power of two size
+	std::vector<slot*> m_chunks;        // slots arena
+	std::vector<char> m_names;          // names arena
+	size_t m_size;
+};
+
+template <class T>
+statisticRegistry<T>::statisticRegistry(size_t expected)
+	: m_size(0)
+{
+	// load factor up to 3/4
+	size_t capacity = 16;
+	while (capacity * 3 < expected * 4)
+		capacity *= 2;
+	m_index.resize(capacity);
+}
+
+template <class T>
+statisticRegistry<T>::~statisticRegistry()
+{
+	for (size_t i = 0; i < m_chunks.size(); ++i)
+		delete[] m_chunks[i];
+}
+
+template <class T>
+template <class Equal>
+size_t statisticRegistry<T>::Probe(uint64_t hash, Equal equal) const
+{
+	const size_t mask = m_index.size() - 1;
+	const uint32_t tag = static_cast<uint32_t>(hash >> 32);
+	for (size_t i = static_cast<size_t>(hash) & mask; ; i = (i + 1) & mask)
+	{
+		const cell& c = m_index[i];
+		if (!c.series || (c.tag == tag && equal(Slot(c.series - 1))))
+			return i;
+	}
+}
+
+template <class T>
+typename statisticRegistry<T>::handle statisticRegistry<T>::Handle(const char* name, size_t length, uint64_t hash)
+{
+	const size_t i = Probe(hash, [this, name, length](const slot& s) { return SameKey(s, name, length); });
+	if (m_index[i].series)
+		return m_index[i].series - 1;
+
+	const uint64_t offset = m_names.size();
+	m_names.insert(m_names.end(), name, name + length);
+	return Insert(i, hash, offset, static_cast<uint32_t>(length));
+}
+
+template <class T>
+typename statisticRegistry<T>::handle statisticRegistry<T>::HandleId(uint64_t id, uint64_t hash)
+{
+	const size_t i = Probe(hash, [id](const slot& s) { return s.length == c_idKey && s.key == id; });
+	if (m_index[i].series)
+		return m_index[i].series - 1;
+
+	return Insert(i, hash, id, c_idKey);
+}
+
+template <class T>
+typename statisticRegistry<T>::handle statisticRegistry<T>::Insert(size_t i, uint64_t hash, uint64_t key, uint32_t length)
+{
+	if ((m_size >> c_chunkBits) == m_chunks.size())
+		m_chunks.push_back(new slot[c_chunkSize]);
+
+	const handle series = static_cast<handle>(m_size++);
+	slot& s = Slot(series);
+	s.accumulator.Reset();
+	s.hash = hash;
+	s.key = key;
+	s.length = length;
+
+	m_index[i].tag = static_cast<uint32_t>(hash >> 32);
+	m_index[i].series = series + 1;
+	if (m_size * 4 > m_index.size() * 3)
+		Rehash(m_index.size() * 2);
+
+	return series;
+}
+
+// the slots keep their hashes, no key is read again
+template <class T>
+void statisticRegistry<T>::Rehash(size_t capacity)
+{
+	std::vector<cell> index(capacity);
+	const size_t mask = capacity - 1;
+	for (size_t series = 0; series < m_size; ++series)
+	{
+		const uint64_t hash = Slot(static_cast<handle>(series)).hash;
+		size_t i = static_cast<size_t>(hash) & mask;
+		while (index[i].series)
+			i = (i + 1) & mask;
+		index[i].tag = static_cast<uint32_t>(hash >> 32);
+		index[i].series = static_cast<uint32_t>(series + 1);
+	}
+	m_index.swap(index);
+}
+
+template <class T>
+statisticRegistryKey statisticRegistry<T>::Key(handle series) const
+{
+	const slot& s = Slot(series);
+	statisticRegistryKey key;
+	if (s.length == c_idKey)
+		key.id = s.key;
+	else
+	{
+		// a null name means an integer id
+		key.name = m_names.empty() ? "" : m_names.data() + s.key;
+		key.length = s.length;
+	}
+	return key;
+}
+
+template <class T>
+const typename statisticRegistry<T>::accumulator_type* statisticRegistry<T>::Find(const char* name, size_t length, uint64_t hash) const
+{
+	const size_t i = Probe(hash, [this, name, length](const slot& s) { return SameKey(s, name, length); });
+	return m_index[i].series ? &Slot(m_index[i].series - 1).accumulator : 0;
+}
+
+template <class T>
+const typename statisticRegistry<T>::accumulator_type* statisticRegistry<T>::FindId(uint64_t id) const
+{
+	const size_t i = Probe(StatisticHashId(id), [id](const slot& s) { return s.length == c_idKey && s.key == id; });
+	return m_index[i].series ? &Slot(m_index[i].series - 1).accumulator : 0;
+}
+
+template <class T>
+size_t statisticRegistry<T>::MemoryUsage() const
+{
+	return sizeof(*this) + m_index.capacity() * sizeof(cell) + m_chunks.capacity() * sizeof(slot*)
+		+ m_chunks.size() * c_chunkSize * sizeof(slot) + m_names.capacity();
+}
+
+template <class T>
+template <class F>
+void statisticRegistry<T>::ForEach(F f) const
+{
+	for (size_t series = 0; series < m_size; ++series)
+		f(Key(static_cast<handle>(series)), Slot(static_cast<handle>(series)).accumulator);
+}
+
+template <class T>
+void statisticRegistry<T>::Merge(const statisticRegistry<T>& other)
+{
+	for (size_t series = 0; series < other.m_size; ++series)
+	{
+		const slot& s = other.Slot(static_cast<handle>(series));
+		const handle target = s.length == c_idKey ? HandleId(s.key, s.hash)
+			: Handle(other.m_names.data() + s.key, s.length, s.hash);
+		Get(target).Merge(s.accumulator);
+	}
+}
+
+template <class T>
+void statisticRegistry<T>::ResetValues()
+{
+	for (size_t series = 0; series < m_size; ++series)
+		Slot(static_cast<handle>(series)).accumulator.Reset();
+}
+
+template <class T>
+void statisticRegistry<T>::Clear()
+{
+	statisticRegistry<T> empty;
+	Swap(empty);
+}
+
+template <class T>
+void statisticRegistry<T>::Swap(statisticRegistry<T>& other)
+{
+	m_index.swap(other.m_index);
+	m_chunks.swap(other.m_chunks);
+	m_names.swap(other.m_names);
+	std::swap(m_size, other.m_size);
+}
+
+// snapshot: series count, then the key and the accumulator of every series
+template <class T>
+void statisticRegistry<T>::SaveState(statisticSnapshotWriter& writer) const
+{
+	writer.Put(static_cast<uint64_t>(m_size));
+	for (size_t series = 0; series < m_size; ++series)
+	{
+		const slot& s = Slot(static_cast<handle>(series));
+		writer.Put(s.length);
+		if (s.length == c_idKey)
+			writer.Put(s.key);
+		else
+			writer.Write(m_names.data() + s.key, s.length);
+		s.accumulator.SaveState(writer);
+	}
+}
+
+template <class T>
+bool statisticRegistry<T>::LoadState(statisticSnapshotReader& reader)
+{
+	uint64_t size = 0;
+	if (!reader.Get(size))
+		return false;
+
+	statisticRegistry<T> registry;
+	std::vector<char> name;
+	for (uint64_t series = 0; series < size; ++series)
+	{
+		uint32_t length = 0;
+		uint64_t id = 0;
+		if (!reader.Get(length))
+			return false;
+		if (length == c_idKey)
+		{
+			if (!reader.Get(id))
+				return false;
+		}
+		else
+		{
+			if (length > reader.Remaining())
+				return reader.Fail();
+			name.resize(length);
+			if (length && !reader.Read(&name[0], length))
+				return false;
+		}
+
+		const size_t before = registry.Size();
+		const handle target = length == c_idKey ? registry.HandleId(id)
+			: registry.Handle(name.data(), length, StatisticHash(name.data(), length));
+		if (registry.Size() == before)
+			return reader.Fail();        // duplicate key
+		if (!registry.Get(target).LoadState(reader))
+			return false;
+	}
+
+	Swap(registry);
+	return true;
+}
+//
+}
+//
+#endif /* ___StatisticRegistry_H___ */
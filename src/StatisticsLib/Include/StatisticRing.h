@@ -0,0 +1,167 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticRing_H___
+#define ___StatisticRing_H___
+
+#include <cstddef>
+#include <vector>
+
+#include "StatisticSpan.h"
+
+//
+namespace NStatisticEvaluations
+{
+//!@ingroup amgStatistic
+//! @brief Окно кольцевого буфера в виде не более чем двух непрерывных участков
+//!
+//! Участок first содержит более ранние значения, second - более поздние
+//! (пустой, если окно не переходит через конец буфера).
+template <class T> struct statisticRingView
+{
+	statisticSpan<const T> first;
+	statisticSpan<const T> second;
+
+	size_t Size() const { return first.Size() + second.Size(); }
+	bool Empty() const { return Size() == 0; }
+};
+
+//!@ingroup amgStatistic
+//! @brief Кольцевой буфер фиксированной емкости
+//!
+//! Шаблонный класс непрерывного буфера, память под который выделяется один раз.
+//! При заполнении новые значения замещают самые старые.
+//!
+//! Пример:
+//! @code
+//!    statisticRingBuffer<double> ring(1000);
+//!    for (int i = 0; i < n; ++i)
+//!       ring.Push(d_data[i]);       // хранятся последние 1000 значений
+//!
+//!    statisticRingView<double> window = ring.View();
+//!    ex_d.GetStatEvaluations()->VectorMaxValue(window.first);
+//! @endcode
+template <class T> class statisticRingBuffer
+{
+public:
+	statisticRingBuffer() : m_head(0), m_size(0) {}
+	explicit statisticRingBuffer(size_t capacity) : m_data(capacity), m_head(0), m_size(0) {}
+
+   //! @brief Установка емкости (выделение памяти, буфер очищается)
+	void SetCapacity(size_t capacity);
+   //! @brief Добавление значения (самое старое значение замещается при заполнении)
+	void Push(T value);
+   //! @brief Очистка буфера (память сохраняется)
+	void Clear() { m_head = m_size = 0; }
+
+	size_t Size() const { return m_size; }
+	size_t Capacity() const { return m_data.size(); }
+	bool Empty() const { return m_size == 0; }
+	bool Full() const { return m_size == m_data.size(); }
+
+   //! @brief Значение по хронологическому индексу (0 - самое старое)
+	const T& operator[](size_t i) const { return m_data[Index(i)]; }
+	const T& Front() const { return m_data[m_head]; }
+	const T& Back() const { return m_data[Index(m_size - 1)]; }
+
+   //! @brief Окно буфера в хронологическом порядке (два непрерывных участка)
+	statisticRingView<T> View() const;
+   //! @brief Все значения окна одним участком в порядке хранения (не хронологическом)
+	statisticSpan<const T> Storage() const;
+   //! @brief Копирование окна в хронологическом порядке
+	void CopyTo(T* out) const;
+
+private:
+	size_t Index(size_t i) const
+	{
+		const size_t index = m_head + i;
+		return index < m_data.size() ? index : index - m_data.size();
+	}
+
+	std::vector<T> m_data;              // storage, sized once
+	size_t m_head;                      // index of the oldest value
+	size_t m_size;
+};
+
+template <class T>
+void statisticRingBuffer<T>::SetCapacity(size_t capacity)
+{
+	std::vector<T>(capacity).swap(m_data);
+	Clear();
+}
+
+template <class T>
+void statisticRingBuffer<T>::Push(T value)
+{
+	if (m_size < m_data.size())
+	{
+		m_data[Index(m_size)] = value;
+		++m_size;
+	}
+	else if (!m_data.empty())
+	{
+		m_data[m_head] = value;
+		if (++m_head == m_data.size())
+			m_head = 0;
+	}
+}
+
+template <class T>
+statisticRingView<T> statisticRingBuffer<T>::View() const
+{
+	statisticRingView<T> view;
+	if (m_size == 0)
+		return view;
+
+	const T* data = &m_data[0];
+	const size_t firstSize = m_data.size() - m_head;
+	if (m_size <= firstSize)
+		view.first = statisticSpan<const T>(data + m_head, m_size);
+	else
+	{
+		view.first = statisticSpan<const T>(data + m_head, firstSize);
+		view.second = statisticSpan<const T>(data, m_size - firstSize);
+	}
+	return view;
+}
+
+template <class T>
+statisticSpan<const T> statisticRingBuffer<T>::Storage() const
+{
+	// the buffer is filled from the beginning, so until it wraps the
+	// values are at [0, size) and after that the whole storage is live
+	if (m_size == 0)
+		return statisticSpan<const T>();
+	return statisticSpan<const T>(&m_data[0], m_size);
+}
+
+template <class T>
+void statisticRingBuffer<T>::CopyTo(T* out) const
+{
+	const statisticRingView<T> view = View();
+	for (size_t i = 0; i < view.first.Size(); ++i)
+		*out++ = view.first[i];
+	for (size_t i = 0; i < view.second.Size(); ++i)
+		*out++ = view.second[i];
+}
+//
+}
+//
+#endif /* ___StatisticRing_H___ */
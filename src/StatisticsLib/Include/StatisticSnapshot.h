@@ -0,0 +1,221 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticSnapshot_H___
+#define ___StatisticSnapshot_H___
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "StatisticEventLog.h"
+
+//
+namespace NStatisticEvaluations
+{
+// Snapshot: 64 byte header (magic "SSNP", version, kind, payload size and
+// checksum) followed by the payload written by SaveState of the object.
+const uint32_t c_snapshotVersion = 1;
+const size_t c_snapshotHeaderSize = 64;
+
+//! @brief Тип объекта снимка (старший байт кода типа снимка)
+enum ESnapshotKind
+{
+	eSnapshotAccumulator = 1,
+	eSnapshotEvaluations,
+	eSnapshotEvents,
+	eSnapshotStatistic,
+	eSnapshotTDigest,
+	eSnapshotHistogram,
+	eSnapshotMovingAverage,
+	eSnapshotRegistry
+};
+
+// snapshot type code: kind of the object and type of its values
+inline uint32_t SnapshotKind(ESnapshotKind kind, uint32_t valueType = 0)
+{
+	return static_cast<uint32_t>(kind) << 24 | valueType;
+}
+template <class T> uint32_t SnapshotValueType()
+{
+	return NStatisticEvents::statisticLogValueType<T>::value;
+}
+
+//! @brief Контрольная сумма (64 бит, по 8 байт за шаг). Для участка длиной,
+//! кратной 8, результат служит начальным значением для следующего участка.
+uint64_t StatisticChecksum(const void* data, size_t size, uint64_t seed);
+
+//!@ingroup amgStatistic
+//! @brief Запись снимка состояния в буфер или файл без выделения памяти
+class statisticSnapshotWriter
+{
+public:
+   //! @brief Запись в буфер (buffer = 0 - только подсчет размера)
+	statisticSnapshotWriter(void* buffer, size_t capacity);
+   //! @brief Запись в файл
+	explicit statisticSnapshotWriter(std::FILE* file);
+
+	void Write(const void* data, size_t size);
+	template <class V> void Put(const V& value) { Write(&value, sizeof(V)); }
+   //! @brief Количество и значения массива
+	template <class V> void PutArray(const V* values, size_t n)
+	{
+		Put<uint64_t>(n);
+		Write(values, n * sizeof(V));
+	}
+
+   //! @brief Завершение записи (false - буфер мал или ошибка записи)
+	bool Finish();
+	bool IsFailed() const { return m_failed; }
+   //! @brief Размер записанных данных, байт
+	uint64_t Size() const { return m_size; }
+	uint64_t Checksum() const { return m_checksum; }
+
+private:
+	// copy and assignment not allowed
+	statisticSnapshotWriter(const statisticSnapshotWriter&);
+	statisticSnapshotWriter& operator=(const statisticSnapshotWriter&);
+
+	bool WriteStage();
+
+	char* m_buffer;
+	size_t m_capacity;
+	std::FILE* m_file;
+	uint64_t m_size;
+	uint64_t m_checksum;
+	bool m_failed;
+
+	char m_stage[4096];                 // file mode block, a multiple of 8 bytes
+	size_t m_staged;
+};
+
+//!@ingroup amgStatistic
+//! @brief Чтение снимка состояния с проверкой границ
+class statisticSnapshotReader
+{
+public:
+	statisticSnapshotReader(const void* data, size_t size)
+		: m_data(static_cast<const char*>(data)), m_size(size), m_failed(false) {}
+
+	bool Read(void* data, size_t size);
+	template <class V> bool Get(V& value) { return Read(&value, sizeof(V)); }
+   //! @brief Массив, записанный PutArray
+	template <class V> bool GetArray(std::vector<V>& values)
+	{
+		uint64_t n = 0;
+		if (!Get(n) || n > m_size / sizeof(V))
+			return Fail();
+
+		values.resize(static_cast<size_t>(n));
+		return !n || Read(&values[0], values.size() * sizeof(V));
+	}
+   //! @brief Отметка о недопустимом значении
+	bool Fail() { m_failed = true; return false; }
+
+	size_t Remaining() const { return m_size; }
+	bool IsFailed() const { return m_failed; }
+
+private:
+	const char* m_data;
+	size_t m_size;
+	bool m_failed;
+};
+
+//!@name Заголовок и файл снимка (внутренние функции)
+//@{
+void WriteSnapshotHeader(void* header, uint32_t kind, uint64_t size, uint64_t checksum);
+bool CheckSnapshot(const void* data, size_t size, uint32_t kind, const void*& payload, size_t& payloadSize);
+std::FILE* BeginSnapshotFile(const std::string& path);
+bool EndSnapshotFile(std::FILE* file, const std::string& path, statisticSnapshotWriter& writer, uint32_t kind);
+//@}
+
+//!@name Снимки состояния
+//! Объект S реализует SaveState(statisticSnapshotWriter&) const,
+//! LoadState(statisticSnapshotReader&) и SnapshotKind(). При ошибке восстановления
+//! (неверный формат, тип, версия, контрольная сумма) объект не изменяется.
+//!
+//! Пример:
+//! @code
+//!    SaveSnapshotFile(*ex_d.GetStatEvents(), "events.snap");
+//!    ...
+//!    if (!LoadSnapshotFile(*ex_d.GetStatEvents(), "events.snap"))
+//!       ...
+//! @endcode
+//@{
+//! @brief Размер снимка, байт
+template <class S> size_t SnapshotSize(const S& state)
+{
+	statisticSnapshotWriter writer(0, 0);
+	state.SaveState(writer);
+	return c_snapshotHeaderSize + static_cast<size_t>(writer.Size());
+}
+
+//! @brief Запись снимка в буфер, возвращает размер снимка (0 - буфер мал)
+template <class S> size_t SaveSnapshot(const S& state, void* buffer, size_t capacity)
+{
+	if (!buffer || capacity < c_snapshotHeaderSize)
+		return 0;
+
+	statisticSnapshotWriter writer(static_cast<char*>(buffer) + c_snapshotHeaderSize, capacity - c_snapshotHeaderSize);
+	state.SaveState(writer);
+	if (!writer.Finish())
+		return 0;
+
+	WriteSnapshotHeader(buffer, S::SnapshotKind(), writer.Size(), writer.Checksum());
+	return c_snapshotHeaderSize + static_cast<size_t>(writer.Size());
+}
+
+//! @brief Восстановление из снимка в памяти
+template <class S> bool LoadSnapshot(S& state, const void* data, size_t size)
+{
+	const void* payload = 0;
+	size_t payloadSize = 0;
+	if (!CheckSnapshot(data, size, S::SnapshotKind(), payload, payloadSize))
+		return false;
+
+	statisticSnapshotReader reader(payload, payloadSize);
+	return state.LoadState(reader);
+}
+
+//! @brief Запись снимка в файл (через временный файл с заменой)
+template <class S> bool SaveSnapshotFile(const S& state, const std::string& path)
+{
+	std::FILE* file = BeginSnapshotFile(path);
+	if (!file)
+		return false;
+
+	statisticSnapshotWriter writer(file);
+	state.SaveState(writer);
+	return EndSnapshotFile(file, path, writer, S::SnapshotKind());
+}
+
+//! @brief Восстановление из файла снимка (отображение в память и проверка)
+template <class S> bool LoadSnapshotFile(S& state, const std::string& path)
+{
+	NStatisticEvents::statisticMappedFile file;
+	return file.Open(path) && LoadSnapshot(state, file.Data(), file.Size());
+}
+//@}
+//
+}
+//
+#endif /* ___StatisticSnapshot_H___ */
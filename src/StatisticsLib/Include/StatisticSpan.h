@@ -0,0 +1,85 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef ___StatisticSpan_H___
+#define ___StatisticSpan_H___
+
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+
+//
+namespace NStatisticEvaluations
+{
+//!@ingroup amgStatistic
+//! @brief Непрерывный диапазон значений без владения данными (span)
+//!
+//! Легковесное представление массива или вектора: указатель и размер.
+//! Позволяет передавать очередь событий в статистические оценки без копирования.
+//!
+//! Пример:
+//! @code
+//!    statistic<double> ex_d;
+//!    ...
+//!    statisticSpan<const double> view = ex_d.GetStatEvents()->GetParamsView();
+//!    ex_d.GetStatEvaluations()->VectorSum(view);
+//! @endcode
+template <class T> class statisticSpan
+{
+public:
+	typedef typename std::remove_const<T>::type value_type;
+	typedef T* iterator;
+
+	statisticSpan() : m_data(0), m_size(0) {}
+	statisticSpan(T* data, size_t size) : m_data(data), m_size(size) {}
+	statisticSpan(T* first, T* last) : m_data(first), m_size(last - first) {}
+	statisticSpan(std::vector<value_type>& data)
+		: m_data(data.empty() ? 0 : &data[0]), m_size(data.size()) {}
+	statisticSpan(const std::vector<value_type>& data)
+		: m_data(data.empty() ? 0 : &data[0]), m_size(data.size()) {}
+
+	// span<T> -> span<const T>
+	template <class U>
+	statisticSpan(const statisticSpan<U>& other) : m_data(other.Data()), m_size(other.Size()) {}
+
+   //! @brief Указатель на первый элемент
+	T* Data() const { return m_data; }
+   //! @brief Количество элементов
+	size_t Size() const { return m_size; }
+   //! @brief Проверка на пустой диапазон
+	bool Empty() const { return m_size == 0; }
+   //! @brief Часть диапазона (count элементов начиная с offset)
+	statisticSpan<T> Subspan(size_t offset, size_t count) const
+	{
+		return statisticSpan<T>(m_data + offset, count);
+	}
+
+	T& operator[](size_t i) const { return m_data[i]; }
+
+	iterator begin() const { return m_data; }
+	iterator end() const { return m_data + m_size; }
+
+private:
+	T* m_data;
+	size_t m_size;
+};
+//
+}
+//
+#endif /* ___StatisticSpan_H___ */
@@ -0,0 +1,122 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticTDigest_H___
+#define ___StatisticTDigest_H___
+
+#include <cstddef>
+#include <vector>
+
+#include "StatisticSnapshot.h"
+
+//
+namespace NStatisticEvaluations
+{
+//!@ingroup amgStatistic
+//! @brief Потоковая оценка квантилей (merging t-digest)
+//!
+//! Распределение значений представляется ограниченным набором центроидов
+//! (среднее и вес), более мелких на хвостах распределения, поэтому высокие
+//! процентили (p99, p99.9) оцениваются точнее медианы. Память ограничена
+//! параметром сжатия и не зависит от количества значений. Оценки, построенные
+//! в разных потоках или процессах, объединяются методом Merge.
+//!
+//! Константные методы не изменяют объект и могут вызываться из нескольких
+//! потоков одновременно (если никто не добавляет значения). Значения буфера,
+//! еще не объединенные с центроидами, объединяются запросом во временной копии;
+//! Flush() объединяет их заранее, чтобы запросы не повторяли эту работу.
+//!
+//! Пример:
+//! @code
+//!    statisticTDigest digest(100);
+//!    for (int i = 0; i < n; ++i)
+//!       digest.Add(latency[i]);
+//!    cout << "p99: " << digest.Quantile(0.99) << endl;
+//! @endcode
+class statisticTDigest
+{
+public:
+	struct centroid
+	{
+		double mean;
+		double weight;
+	};
+
+   /*!@brief Конструктор
+   * @param[in] compression Параметр сжатия: количество центроидов не превышает
+   * примерно compression * pi / 2, погрешность квантиля - порядка 1 / compression
+   */
+	explicit statisticTDigest(double compression = 100.0);
+
+   //! @brief Добавление значения с весом
+	void Add(double value, double weight = 1.0);
+   //! @brief Добавление диапазона значений
+	template <class It> void AddRange(It first, It last)
+	{
+		for (; first != last; ++first)
+			Add((double)*first);
+	}
+   //! @brief Добавление центроида (восстановление сохраненной оценки)
+	void AddCentroid(const centroid& c) { Add(c.mean, c.weight); }
+   //! @brief Объединение с другой оценкой
+	void Merge(const statisticTDigest& other);
+   //! @brief Сброс всех значений
+	void Reset();
+   //! @brief Объединение буфера значений с центроидами
+	void Flush();
+
+   //! @brief Квантиль уровня q из [0, 1]
+	double Quantile(double q) const;
+   //! @brief Доля значений не больше value (функция распределения)
+	double Cdf(double value) const;
+
+	double GetCount() const { return m_count + m_bufferWeight; }
+	double GetMin() const { return m_min; }
+	double GetMax() const { return m_max; }
+	double GetCompression() const { return m_compression; }
+   //! @brief Центроиды в порядке возрастания среднего (копия, включая буфер)
+	std::vector<centroid> GetCentroids() const;
+
+   //!@name Снимок состояния (StatisticSnapshot.h)
+   //@{
+	static uint32_t SnapshotKind() { return NStatisticEvaluations::SnapshotKind(eSnapshotTDigest); }
+	void SaveState(statisticSnapshotWriter& writer) const;
+	bool LoadState(statisticSnapshotReader& reader);
+   //@}
+
+private:
+	// centroids with the buffer merged: m_centroids itself or a merged copy in scratch
+	const std::vector<centroid>& Merged(std::vector<centroid>& scratch) const;
+	// merge sorted values (centroids and buffer) of the total weight into out
+	static void CompressCentroids(const std::vector<centroid>& values, double total, double compression,
+		std::vector<centroid>& out);
+
+	double m_compression;
+	double m_min, m_max;
+	size_t m_bufferCapacity;
+	std::vector<centroid> m_centroids;  // merged centroids
+	std::vector<centroid> m_buffer;     // values not merged yet
+	double m_count;                     // weight of the merged centroids
+	double m_bufferWeight;
+};
+//
+}
+//
+#endif /* ___StatisticTDigest_H___ */
@@ -0,0 +1,102 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticThreadPool_H___
+#define ___StatisticThreadPool_H___
+
+#include <cstddef>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+//
+namespace NStatisticEvaluations
+{
+//!@ingroup amgStatistic
+//! @brief Пул потоков для параллельного расчета статистических оценок
+//!
+//! Выполняет задачу для индексов [0, count) на потоках пула и вызывающем
+//! потоке. Задачи одного пула выполняются по очереди; вложенный вызов
+//! ParallelFor из задачи не допускается.
+//!
+//! Пример:
+//! @code
+//!    statisticThreadPool pool(4);
+//!    ex_d.GetStatEvaluations()->SetParallelEvaluation(1 << 16, &pool);
+//!    ex_d.GetStatEvaluations()->Summarize(d_data, 100000000);
+//! @endcode
+class statisticThreadPool
+{
+public:
+   /*!@brief Конструктор
+   * @param[in] threads Количество рабочих потоков (0 - по числу аппаратных потоков
+   * минус вызывающий поток)
+   */
+	explicit statisticThreadPool(unsigned threads = 0);
+	~statisticThreadPool();
+
+   //! @brief Общий пул потоков процесса
+	static statisticThreadPool& Instance();
+
+   //! @brief Количество потоков, выполняющих задачу (рабочие + вызывающий)
+	unsigned ThreadsCount() const { return static_cast<unsigned>(m_threads.size()) + 1; }
+
+   //! @brief Выполнение task(context, i) для i из [0, count)
+	void ParallelFor(size_t count, void (*task)(void*, size_t), void* context);
+   //! @brief Выполнение f(i) для i из [0, count)
+	template <class F> void ParallelFor(size_t count, const F& f)
+	{
+		ParallelFor(count, &Invoke<F>, const_cast<F*>(&f));
+	}
+
+private:
+	// copy and assignment not allowed
+	statisticThreadPool(const statisticThreadPool&);
+	statisticThreadPool& operator=(const statisticThreadPool&);
+
+	template <class F> static void Invoke(void* context, size_t index)
+	{
+		(*static_cast<const F*>(context))(index);
+	}
+
+	void WorkerLoop();
+	void Work();
+
+	std::vector<std::thread> m_threads;
+	std::mutex m_runMutex;                  // one job at a time
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+
+	void (*m_task)(void*, size_t);          // current job
+	void* m_context;
+	size_t m_count;
+	std::atomic<size_t> m_next;
+
+	unsigned m_generation;                  // incremented for every job
+	unsigned m_busy;                        // workers still running the job
+	bool m_stop;
+};
+//
+}
+//
+#endif /* ___StatisticThreadPool_H___ */
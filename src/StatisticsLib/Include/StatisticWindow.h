@@ -0,0 +1,175 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ___StatisticWindow_H___
+#define ___StatisticWindow_H___
+
+#include <cstddef>
+#include <vector>
+
+#include "StatisticAccumulator.h"
+
+//
+namespace NStatisticEvaluations
+{
+//!@ingroup amgStatistic
+//! @brief Статистические оценки в скользящем окне времени (последние N секунд)
+//!
+//! Окно разбито на интервалы (корзины) равной длительности, каждый из которых
+//! хранит накопитель оценок своих событий. Добавление значения - O(1), запрос
+//! оценок за окно - O(количество корзин) без повторного просмотра событий.
+//! Граница окна определяется с точностью до длительности одной корзины.
+//! Время - монотонное, нс.
+//!
+//! Пример:
+//! @code
+//!    statisticTimeWindow<double> window(300 * c_nsInSecond, 300);    // 5 минут, корзины по 1 с
+//!    window.Add(value, SteadyClockNs());
+//!    ...
+//!    const long long now = SteadyClockNs();
+//!    double mean10 = window.GetStatistics(now, 10 * c_nsInSecond).GetMean();
+//!    double max5m = window.GetStatistics(now).GetMax();
+//! @endcode
+template <class T> class statisticTimeWindow
+{
+public:
+   /*!@brief Конструктор
+   * @param[in] length Длительность окна, нс
+   * @param[in] buckets Количество корзин (длительность корзины - length / buckets)
+   */
+	statisticTimeWindow(long long length, size_t buckets);
+
+   //! @brief Добавление значения в момент времени time, нс
+	void Add(T value, long long time);
+   //! @brief Добавление диапазона значений с одним временем
+	template <class It> void AddRange(It first, It last, long long time);
+
+   //! @brief Оценки за окно, заканчивающееся в момент now
+	statisticAccumulator<T> GetStatistics(long long now) const { return GetStatistics(now, m_length); }
+   //! @brief Оценки за последние span нс (не больше длительности окна)
+	statisticAccumulator<T> GetStatistics(long long now, long long span) const;
+
+   //! @brief Очистка окна
+	void Clear();
+
+	long long GetLength() const { return m_length; }
+	long long GetBucketLength() const { return m_bucketLength; }
+	size_t GetBucketsCount() const { return m_buckets.size(); }
+
+private:
+	struct bucket
+	{
+		bucket() : index(-1) {}
+
+		long long index;                 // time / bucket length, -1 for an empty bucket
+		statisticAccumulator<T> values;
+	};
+
+	// bucket for the time, null if the time is older than the window
+	bucket* Bucket(long long time);
+
+	long long m_length;
+	long long m_bucketLength;
+	std::vector<bucket> m_buckets;      // ring of buckets, indexed by time
+};
+
+//! @brief Количество наносекунд в секунде
+const long long c_nsInSecond = 1000000000LL;
+
+// constructor
+template <class T>
+statisticTimeWindow<T>::statisticTimeWindow(long long length, size_t buckets)
+	: m_buckets(buckets ? buckets : 1)
+{
+	m_bucketLength = length / static_cast<long long>(m_buckets.size());
+	if (m_bucketLength < 1)
+		m_bucketLength = 1;
+	m_length = m_bucketLength * static_cast<long long>(m_buckets.size());
+}
+
+// bucket of the time
+template <class T>
+typename statisticTimeWindow<T>::bucket* statisticTimeWindow<T>::Bucket(long long time)
+{
+	const long long index = time / m_bucketLength;
+	bucket& b = m_buckets[static_cast<size_t>(index % static_cast<long long>(m_buckets.size()))];
+	if (b.index != index)
+	{
+		// a late value for an interval that is already reused
+		if (b.index > index)
+			return 0;
+		b.index = index;
+		b.values.Reset();
+	}
+	return &b;
+}
+
+// add value
+template <class T>
+void statisticTimeWindow<T>::Add(T value, long long time)
+{
+	if (bucket* b = Bucket(time))
+		b->values.Add(value);
+}
+
+// add range of values
+template <class T>
+template <class It>
+void statisticTimeWindow<T>::AddRange(It first, It last, long long time)
+{
+	if (first == last)
+		return;
+	if (bucket* b = Bucket(time))
+		b->values.AddRange(first, last);
+}
+
+// merge the buckets of the last span
+template <class T>
+statisticAccumulator<T> statisticTimeWindow<T>::GetStatistics(long long now, long long span) const
+{
+	const long long last = now / m_bucketLength;
+	long long count = (span + m_bucketLength - 1) / m_bucketLength;
+	if (count > static_cast<long long>(m_buckets.size()))
+		count = static_cast<long long>(m_buckets.size());
+
+	statisticAccumulator<T> result;
+	for (size_t i = 0; i < m_buckets.size(); ++i)
+	{
+		const bucket& b = m_buckets[i];
+		if (b.index > last - count && b.index <= last)
+			result.Merge(b.values);
+	}
+	return result;
+}
+
+// clean all buckets
+template <class T>
+void statisticTimeWindow<T>::Clear()
+{
+	for (size_t i = 0; i < m_buckets.size(); ++i)
+	{
+		m_buckets[i].index = -1;
+		m_buckets[i].values.Reset();
+	}
+}
+//
+}
+//
+#endif /* ___StatisticWindow_H___ */
@@ -0,0 +1,136 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+//
+#include "StatisticClock.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define STATISTIC_CLOCK_TSC
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+#endif
+//
+//
+namespace NStatisticEvents
+{
+namespace
+{
+#if defined(STATISTIC_CLOCK_TSC)
+inline unsigned long long ReadTsc()
+{
+	return __rdtsc();
+}
+
+bool InvariantTsc()
+{
+	unsigned int regs[4] = {0, 0, 0, 0};
+#if defined(_MSC_VER)
+	__cpuid(reinterpret_cast<int*>(regs), 0x80000000);
+	if (regs[0] < 0x80000007)
+		return false;
+	__cpuid(reinterpret_cast<int*>(regs), 0x80000007);
+#else
+	if (__get_cpuid_max(0x80000000, 0) < 0x80000007)
+		return false;
+	__get_cpuid(0x80000007, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+	return (regs[3] & (1 << 8)) != 0;
+}
+#endif
+
+// TSC to nanoseconds: ns = baseNs + delta * multiplier / 2^32
+struct tscCalibration
+{
+	tscCalibration() : available(false), baseTicks(0), baseNs(0), multiplier(0), ticksPerSecond(0.0)
+	{
+#if defined(STATISTIC_CLOCK_TSC)
+		if (!InvariantTsc())
+			return;
+
+		// measure the TSC against steady_clock over ~10 ms
+		const long long startNs = SteadyClockNs();
+		const unsigned long long startTicks = ReadTsc();
+		long long endNs = startNs;
+		while (endNs - startNs < 10000000)
+			endNs = SteadyClockNs();
+		const unsigned long long endTicks = ReadTsc();
+
+		const double ticks = static_cast<double>(endTicks - startTicks);
+		const double ns = static_cast<double>(endNs - startNs);
+		// the fixed point multiplier has 32 fractional bits and must stay
+		// below 2^32, that is the TSC has to run at 1 GHz at least
+		if (ticks <= ns)
+			return;
+
+		ticksPerSecond = ticks * 1e9 / ns;
+		multiplier = static_cast<unsigned long long>(ns / ticks * 4294967296.0);
+		baseTicks = endTicks;
+		baseNs = endNs;
+		available = true;
+#endif
+	}
+
+	bool available;
+	unsigned long long baseTicks;
+	long long baseNs;
+	unsigned long long multiplier;
+	double ticksPerSecond;
+};
+
+const tscCalibration& Calibration()
+{
+	static const tscCalibration calibration;
+	return calibration;
+}
+//
+}
+
+bool statisticTscClock::Available()
+{
+	return Calibration().available;
+}
+
+long long statisticTscClock::NowNs()
+{
+	const tscCalibration& calibration = Calibration();
+#if defined(STATISTIC_CLOCK_TSC)
+	if (calibration.available)
+	{
+		const unsigned long long delta = ReadTsc() - calibration.baseTicks;
+		const unsigned long long high = delta >> 32;
+		const unsigned long long low = delta & 0xFFFFFFFFULL;
+		return calibration.baseNs + static_cast<long long>(
+			high * calibration.multiplier + ((low * calibration.multiplier) >> 32));
+	}
+#endif
+	return SteadyClockNs();
+}
+
+double statisticTscClock::TicksPerSecond()
+{
+	return Calibration().ticksPerSecond;
+}
+//
+}
+//
@@ -0,0 +1,100 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+//
+#include <set>
+
+#include "StatisticConcurrentEvents.h"
+//
+//
+namespace NStatisticEvents
+{
+namespace
+{
+// ids of the live statisticConcurrentEvents, never freed: threads may exit
+// after the static objects are destroyed
+struct shardedInstances
+{
+	shardedInstances() : next(1) {}
+
+	std::mutex lock;
+	std::set<uint64_t> live;
+	uint64_t next;
+};
+
+shardedInstances& Instances()
+{
+	static shardedInstances* instances = new shardedInstances();
+	return *instances;
+}
+//
+}
+
+uint64_t RegisterShardedInstance()
+{
+	shardedInstances& instances = Instances();
+	std::lock_guard<std::mutex> guard(instances.lock);
+	const uint64_t instance = instances.next++;
+	instances.live.insert(instance);
+	return instance;
+}
+
+void UnregisterShardedInstance(uint64_t instance)
+{
+	shardedInstances& instances = Instances();
+	std::lock_guard<std::mutex> guard(instances.lock);
+	instances.live.erase(instance);
+}
+
+// the instance can not be destroyed while its claims are released
+statisticShardClaims::~statisticShardClaims()
+{
+	shardedInstances& instances = Instances();
+	std::lock_guard<std::mutex> guard(instances.lock);
+	for (size_t i = 0; i < claims.size(); ++i)
+	{
+		// release: the next owner sees the complete accumulator
+		if (instances.live.count(claims[i].instance))
+			claims[i].owner->store(0, std::memory_order_release);
+	}
+}
+
+void statisticShardClaims::Add(uint64_t instance, void* shard, std::atomic<unsigned>* owner)
+{
+	if (claims.size() >= pruneAt)
+	{
+		shardedInstances& instances = Instances();
+		std::lock_guard<std::mutex> guard(instances.lock);
+		size_t kept = 0;
+		for (size_t i = 0; i < claims.size(); ++i)
+		{
+			if (instances.live.count(claims[i].instance))
+				claims[kept++] = claims[i];
+		}
+		claims.resize(kept);
+		pruneAt = 2 * kept + 16;
+	}
+
+	claim added = {instance, shard, owner};
+	claims.push_back(added);
+}
+//
+}
+//
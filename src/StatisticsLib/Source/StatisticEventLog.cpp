@@ -0,0 +1,451 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+//
+#include <string.h>
+#include <atomic>
+#include <chrono>
+
+#include "StatisticEventLog.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+//
+//
+namespace NStatisticEvents
+{
+namespace
+{
+const char c_logMagic[4] = {'S', 'L', 'O', 'G'};
+static_assert(sizeof(statisticLogHeader) == 64, "the values have to stay 64 byte aligned");
+
+// positional file access, the file offset is never used
+#if defined(_WIN32)
+intptr_t OpenFile(const std::string& path, bool write)
+{
+	HANDLE file = CreateFileA(path.c_str(), write ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+		FILE_SHARE_READ | (write ? 0 : FILE_SHARE_WRITE), 0, write ? OPEN_ALWAYS : OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, 0);
+	return file == INVALID_HANDLE_VALUE ? -1 : reinterpret_cast<intptr_t>(file);
+}
+
+void CloseFile(intptr_t file)
+{
+	CloseHandle(reinterpret_cast<HANDLE>(file));
+}
+
+bool FileSize(intptr_t file, uint64_t& size)
+{
+	LARGE_INTEGER value;
+	if (!GetFileSizeEx(reinterpret_cast<HANDLE>(file), &value))
+		return false;
+
+	size = static_cast<uint64_t>(value.QuadPart);
+	return true;
+}
+
+bool ReadAt(intptr_t file, uint64_t offset, void* data, size_t size)
+{
+	OVERLAPPED position = OVERLAPPED();
+	position.Offset = static_cast<DWORD>(offset);
+	position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+	DWORD read = 0;
+	return ReadFile(reinterpret_cast<HANDLE>(file), data, static_cast<DWORD>(size), &read, &position)
+		&& read == size;
+}
+
+bool WriteAt(intptr_t file, uint64_t offset, const void* data, size_t size)
+{
+	const char* bytes = static_cast<const char*>(data);
+	while (size)
+	{
+		const DWORD chunk = size > (1u << 30) ? (1u << 30) : static_cast<DWORD>(size);
+		OVERLAPPED position = OVERLAPPED();
+		position.Offset = static_cast<DWORD>(offset);
+		position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		DWORD written = 0;
+		if (!WriteFile(reinterpret_cast<HANDLE>(file), bytes, chunk, &written, &position) || !written)
+			return false;
+
+		bytes += written;
+		offset += written;
+		size -= written;
+	}
+	return true;
+}
+
+bool ResizeFile(intptr_t file, uint64_t size)
+{
+	FILE_END_OF_FILE_INFO info;
+	info.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+	return SetFileInformationByHandle(reinterpret_cast<HANDLE>(file), FileEndOfFileInfo, &info, sizeof(info)) != 0;
+}
+
+bool SyncFile(intptr_t file)
+{
+	return FlushFileBuffers(reinterpret_cast<HANDLE>(file)) != 0;
+}
+
+bool RemoveFile(const std::string& path)
+{
+	return DeleteFileA(path.c_str()) || GetLastError() == ERROR_FILE_NOT_FOUND;
+}
+#else
+intptr_t OpenFile(const std::string& path, bool write)
+{
+	return open(path.c_str(), write ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+}
+
+void CloseFile(intptr_t file)
+{
+	close(static_cast<int>(file));
+}
+
+bool FileSize(intptr_t file, uint64_t& size)
+{
+	struct stat info;
+	if (fstat(static_cast<int>(file), &info))
+		return false;
+
+	size = static_cast<uint64_t>(info.st_size);
+	return true;
+}
+
+bool ReadAt(intptr_t file, uint64_t offset, void* data, size_t size)
+{
+	return pread(static_cast<int>(file), data, size, static_cast<off_t>(offset)) == static_cast<ssize_t>(size);
+}
+
+bool WriteAt(intptr_t file, uint64_t offset, const void* data, size_t size)
+{
+	const char* bytes = static_cast<const char*>(data);
+	while (size)
+	{
+		const ssize_t written = pwrite(static_cast<int>(file), bytes, size, static_cast<off_t>(offset));
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return false;
+
+		bytes += written;
+		offset += written;
+		size -= written;
+	}
+	return true;
+}
+
+bool ResizeFile(intptr_t file, uint64_t size)
+{
+	return ftruncate(static_cast<int>(file), static_cast<off_t>(size)) == 0;
+}
+
+bool SyncFile(intptr_t file)
+{
+	return fsync(static_cast<int>(file)) == 0;
+}
+
+bool RemoveFile(const std::string& path)
+{
+	return unlink(path.c_str()) == 0 || errno == ENOENT;
+}
+#endif
+//
+}
+
+// log file
+statisticLogFile::statisticLogFile()
+	: m_file(-1), m_header(), m_valueSize(0), m_count(0), m_written(0), m_used(0), m_failed(false)
+{
+}
+
+bool statisticLogFile::Open(const std::string& path, uint32_t valueType, uint32_t valueSize, bool append, uint64_t id)
+{
+	Close();
+	m_file = OpenFile(path, true);
+	if (m_file == -1)
+		return false;
+
+	m_valueSize = valueSize;
+	m_header = statisticLogHeader();
+	memcpy(m_header.magic, c_logMagic, sizeof(c_logMagic));
+	m_header.version = c_logVersion;
+	m_header.valueType = valueType;
+	m_header.valueSize = valueSize;
+	m_header.id = id;
+
+	uint64_t size = 0;
+	if (!FileSize(m_file, size))
+	{
+		Close();
+		return false;
+	}
+
+	if (append && size >= c_logHeaderSize)
+	{
+		statisticLogHeader header;
+		if (!ReadAt(m_file, 0, &header, sizeof(header)) || memcmp(header.magic, c_logMagic, sizeof(c_logMagic))
+			|| header.version != c_logVersion || header.valueType != valueType || header.valueSize != valueSize)
+		{
+			Close();
+			return false;
+		}
+
+		// values after the last committed count are dropped
+		const uint64_t stored = (size - c_logHeaderSize) / valueSize;
+		m_count = header.count < stored ? header.count : stored;
+		m_header.id = header.id;
+	}
+	else
+		m_count = 0;
+
+	m_written = m_count;
+	m_buffer.resize(c_bufferSize);
+	m_used = 0;
+	m_failed = false;
+	if (!Truncate(m_count))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void statisticLogFile::Close()
+{
+	if (m_file == -1)
+		return;
+
+	Flush(false);
+	CloseFile(m_file);
+	m_file = -1;
+	m_count = m_written = 0;
+	std::vector<char>().swap(m_buffer);
+	m_used = 0;
+}
+
+bool statisticLogFile::Append(const void* values, size_t count)
+{
+	if (m_file == -1 || m_failed)
+		return false;
+
+	const size_t bytes = count * m_valueSize;
+	if (m_used + bytes > m_buffer.size())
+	{
+		if (!WriteBuffer())
+			return false;
+
+		// large blocks go to the file directly
+		if (bytes >= m_buffer.size())
+		{
+			if (!WriteAt(m_file, c_logHeaderSize + m_written * m_valueSize, values, bytes))
+			{
+				m_failed = true;
+				return false;
+			}
+			m_written += count;
+			m_count += count;
+			return true;
+		}
+	}
+
+	memcpy(&m_buffer[m_used], values, bytes);
+	m_used += bytes;
+	m_count += count;
+	return true;
+}
+
+bool statisticLogFile::WriteBuffer()
+{
+	if (!m_used)
+		return true;
+
+	if (!WriteAt(m_file, c_logHeaderSize + m_written * m_valueSize, &m_buffer[0], m_used))
+	{
+		m_failed = true;
+		return false;
+	}
+	m_written += m_used / m_valueSize;
+	m_used = 0;
+	return true;
+}
+
+bool statisticLogFile::Flush(bool sync)
+{
+	if (m_file == -1 || m_failed || !WriteBuffer())
+		return false;
+
+	// the data has to reach the file before the count that commits it
+	if (sync && !SyncFile(m_file))
+		return false;
+
+	m_header.count = m_written;
+	if (!WriteAt(m_file, 0, &m_header, sizeof(m_header)))
+	{
+		m_failed = true;
+		return false;
+	}
+	return !sync || SyncFile(m_file);
+}
+
+bool statisticLogFile::Truncate(uint64_t count)
+{
+	if (m_file == -1 || m_failed || !WriteBuffer())
+		return false;
+
+	if (count > m_written)
+		count = m_written;
+	m_count = m_written = count;
+	m_header.count = count;
+	if (!WriteAt(m_file, 0, &m_header, sizeof(m_header)) || !ResizeFile(m_file, c_logHeaderSize + count * m_valueSize))
+	{
+		m_failed = true;
+		return false;
+	}
+	return true;
+}
+
+bool statisticLogFile::Extend(uint64_t count)
+{
+	if (m_file == -1 || m_failed)
+		return false;
+	if (m_count >= count)
+		return true;
+
+	const std::vector<char> zeros(c_bufferSize / 4);
+	while (m_count < count)
+	{
+		const uint64_t n = count - m_count < zeros.size() / m_valueSize ? count - m_count : zeros.size() / m_valueSize;
+		if (!Append(&zeros[0], static_cast<size_t>(n)))
+			return false;
+	}
+	return true;
+}
+
+// mapped file
+statisticMappedFile::statisticMappedFile() : m_data(0), m_size(0), m_mapping(-1)
+{
+}
+
+bool statisticMappedFile::Open(const std::string& path)
+{
+	Close();
+	const intptr_t file = OpenFile(path, false);
+	if (file == -1)
+		return false;
+
+	uint64_t size = 0;
+	if (!FileSize(file, size) || !size || size != static_cast<size_t>(size))
+	{
+		CloseFile(file);
+		return false;
+	}
+
+#if defined(_WIN32)
+	HANDLE mapping = CreateFileMappingA(reinterpret_cast<HANDLE>(file), 0, PAGE_READONLY, 0, 0, 0);
+	CloseFile(file);
+	if (!mapping)
+		return false;
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+	m_mapping = reinterpret_cast<intptr_t>(mapping);
+#else
+	void* data = mmap(0, static_cast<size_t>(size), PROT_READ, MAP_SHARED, static_cast<int>(file), 0);
+	CloseFile(file);
+	if (data == MAP_FAILED)
+		return false;
+
+	// the kernels read the values front to back
+	madvise(data, static_cast<size_t>(size), MADV_SEQUENTIAL);
+#endif
+	m_data = static_cast<const unsigned char*>(data);
+	m_size = static_cast<size_t>(size);
+	return true;
+}
+
+void statisticMappedFile::Close()
+{
+	if (!m_data)
+		return;
+
+#if defined(_WIN32)
+	UnmapViewOfFile(m_data);
+	CloseHandle(reinterpret_cast<HANDLE>(m_mapping));
+	m_mapping = -1;
+#else
+	munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+	m_data = 0;
+	m_size = 0;
+}
+
+long long StatisticLogCount(const statisticMappedFile& file, uint32_t valueType, uint32_t valueSize)
+{
+	if (!file.Data() || file.Size() < c_logHeaderSize)
+		return -1;
+
+	statisticLogHeader header;
+	memcpy(&header, file.Data(), sizeof(header));
+	if (memcmp(header.magic, c_logMagic, sizeof(c_logMagic)) || header.version != c_logVersion
+		|| header.valueType != valueType || header.valueSize != valueSize)
+		return -1;
+
+	// a log cut after the last commit is read up to the values present
+	const uint64_t stored = (file.Size() - c_logHeaderSize) / valueSize;
+	return static_cast<long long>(header.count < stored ? header.count : stored);
+}
+
+uint64_t StatisticLogId(const statisticMappedFile& file)
+{
+	statisticLogHeader header;
+	memcpy(&header, file.Data(), sizeof(header));
+	return header.id;
+}
+
+uint64_t NewStatisticLogId()
+{
+	// the time and a process counter, mixed (splitmix64 finalizer)
+	static std::atomic<uint64_t> counter(0);
+	uint64_t id = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count())
+		+ ++counter * 0x9E3779B97F4A7C15ULL;
+	id = (id ^ (id >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	id = (id ^ (id >> 27)) * 0x94D049BB133111EBULL;
+	id ^= id >> 31;
+	return id ? id : 1;
+}
+
+bool RemoveStatisticLog(const std::string& path)
+{
+	return RemoveFile(path);
+}
+//
+}
+//
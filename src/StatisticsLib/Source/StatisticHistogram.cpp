@@ -0,0 +1,289 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+//
+#include <math.h>
+
+#include "StatisticHistogram.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+//
+//
+namespace NStatisticEvaluations
+{
+statisticHistogram::statisticHistogram(long long lowest, long long highest, int digits)
+{
+	Init(lowest, highest, digits);
+}
+
+statisticHistogram::statisticHistogram()
+{
+	Init(1, 2, 1);
+}
+
+void statisticHistogram::Init(long long lowest, long long highest, int digits)
+{
+	lowest = lowest < 1 ? 1 : lowest;
+	if (lowest > c_maxLowest)
+		lowest = c_maxLowest;
+	highest = highest < 2 * lowest ? 2 * lowest : highest;
+	digits = digits < 1 ? 1 : (digits > 5 ? 5 : digits);
+
+	m_lowest = lowest;
+	m_highest = highest;
+	m_digits = digits;
+
+	// values below 2 * 10^digits are resolved with unit precision
+	long long largestSingleUnit = 2;
+	for (int i = 0; i < digits; ++i)
+		largestSingleUnit *= 10;
+
+	int subBucketCountMagnitude = 0;
+	while ((1LL << subBucketCountMagnitude) < largestSingleUnit)
+		++subBucketCountMagnitude;
+	m_subBucketHalfCountMagnitude = subBucketCountMagnitude - 1;
+	m_unitMagnitude = 63 - LeadingZeros(static_cast<unsigned long long>(lowest));
+	m_subBucketCount = 1LL << subBucketCountMagnitude;
+	m_subBucketHalfCount = m_subBucketCount / 2;
+	m_subBucketMask = static_cast<unsigned long long>(m_subBucketCount - 1) << m_unitMagnitude;
+	m_leadingZeroCountBase = 64 - m_unitMagnitude - m_subBucketHalfCountMagnitude - 1;
+
+	// buckets to cover the highest value
+	int bucketsCount = 1;
+	long long smallestUntrackable = m_subBucketCount << m_unitMagnitude;
+	while (smallestUntrackable <= highest)
+	{
+		if (smallestUntrackable > (0x7FFFFFFFFFFFFFFFLL >> 1))
+		{
+			++bucketsCount;
+			break;
+		}
+		smallestUntrackable <<= 1;
+		++bucketsCount;
+	}
+
+	m_counts.assign(static_cast<size_t>((bucketsCount + 1) * m_subBucketHalfCount), 0);
+	m_highestTrackable = HighestEquivalentValue(ValueFromIndex(m_counts.size() - 1));
+	if (m_highestTrackable < 0)
+		m_highestTrackable = 0x7FFFFFFFFFFFFFFFLL;
+	Reset();
+}
+
+int statisticHistogram::LeadingZeros(unsigned long long value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return 63 - static_cast<int>(index);
+#elif defined(__GNUC__)
+	return __builtin_clzll(value);
+#else
+	int zeros = 0;
+	for (unsigned long long bit = 1ULL << 63; bit && !(value & bit); bit >>= 1)
+		++zeros;
+	return zeros;
+#endif
+}
+
+long long statisticHistogram::ValueFromIndex(size_t index) const
+{
+	int bucket = static_cast<int>(static_cast<long long>(index) >> m_subBucketHalfCountMagnitude) - 1;
+	long long subBucket = (static_cast<long long>(index) & (m_subBucketHalfCount - 1)) + m_subBucketHalfCount;
+	if (bucket < 0)
+	{
+		subBucket -= m_subBucketHalfCount;
+		bucket = 0;
+	}
+	return subBucket << (bucket + m_unitMagnitude);
+}
+
+long long statisticHistogram::LowestEquivalentValue(long long value) const
+{
+	const int bucket = m_leadingZeroCountBase - LeadingZeros(value | m_subBucketMask);
+	const long long subBucket = value >> (bucket + m_unitMagnitude);
+	return subBucket << (bucket + m_unitMagnitude);
+}
+
+long long statisticHistogram::HighestEquivalentValue(long long value) const
+{
+	const int bucket = m_leadingZeroCountBase - LeadingZeros(value | m_subBucketMask);
+	const long long subBucket = value >> (bucket + m_unitMagnitude);
+	// sub buckets of the top half of the first bucket have the same width
+	const int shift = bucket + m_unitMagnitude;
+	return LowestEquivalentValue(value) + (1LL << shift) - 1 + (subBucket >= m_subBucketCount ? (1LL << shift) : 0);
+}
+
+void statisticHistogram::Reset()
+{
+	for (size_t i = 0; i < m_counts.size(); ++i)
+		m_counts[i] = 0;
+	m_totalCount = 0;
+	m_sum = 0.0;
+	m_min = 0x7FFFFFFFFFFFFFFFLL;
+	m_max = 0;
+}
+
+void statisticHistogram::Merge(const statisticHistogram& other)
+{
+	if (!other.m_totalCount)
+		return;
+
+	if (other.m_counts.size() == m_counts.size() && other.m_unitMagnitude == m_unitMagnitude
+		&& other.m_subBucketCount == m_subBucketCount)
+	{
+		for (size_t i = 0; i < m_counts.size(); ++i)
+			m_counts[i] += other.m_counts[i];
+		m_totalCount += other.m_totalCount;
+	}
+	else
+	{
+		// different layout: every bucket is recorded by its value; the sum and
+		// the extremes come from the recorded values, not from the buckets
+		const double sum = m_sum;
+		const long long min = m_min, max = m_max;
+		for (size_t i = 0; i < other.m_counts.size(); ++i)
+		{
+			if (other.m_counts[i])
+				Record(other.ValueFromIndex(i), other.m_counts[i]);
+		}
+		m_sum = sum;
+		m_min = min;
+		m_max = max;
+	}
+
+	// the extremes are clamped to the range as Record does
+	const long long otherMin = other.m_min > m_highestTrackable ? m_highestTrackable : other.m_min;
+	const long long otherMax = other.m_max > m_highestTrackable ? m_highestTrackable : other.m_max;
+	m_sum += other.m_sum;
+	m_min = otherMin < m_min ? otherMin : m_min;
+	m_max = otherMax > m_max ? otherMax : m_max;
+}
+
+long long statisticHistogram::GetValueAtPercentile(double percentile) const
+{
+	if (!m_totalCount)
+		return 0;
+	if (percentile <= 0.0)
+		return m_min;
+
+	const double requested = percentile < 100.0 ? percentile : 100.0;
+	long long target = static_cast<long long>(requested / 100.0 * m_totalCount + 0.5);
+	target = target < 1 ? 1 : target;
+
+	long long total = 0;
+	for (size_t i = 0; i < m_counts.size(); ++i)
+	{
+		total += m_counts[i];
+		if (total >= target)
+		{
+			const long long value = HighestEquivalentValue(ValueFromIndex(i));
+			return value < m_max ? value : m_max;
+		}
+	}
+	return m_max;
+}
+
+double statisticHistogram::GetStdDeviation() const
+{
+	if (!m_totalCount)
+		return 0.0;
+
+	// deviation of the sub bucket middles from the mean
+	const double mean = GetMean();
+	double m2 = 0.0;
+	for (size_t i = 0; i < m_counts.size(); ++i)
+	{
+		if (!m_counts[i])
+			continue;
+		const long long value = ValueFromIndex(i);
+		const double middle = (value + HighestEquivalentValue(value)) / 2.0;
+		m2 += (middle - mean) * (middle - mean) * m_counts[i];
+	}
+	return sqrt(m2 / m_totalCount);
+}
+
+long long statisticHistogram::GetCountAtValue(long long value) const
+{
+	value = value < 0 ? 0 : value;
+	value = value > m_highestTrackable ? m_highestTrackable : value;
+	return m_counts[CountsIndex(value)];
+}
+
+// snapshot: the layout parameters and the non-zero counters only
+void statisticHistogram::SaveState(statisticSnapshotWriter& writer) const
+{
+	writer.Put(m_lowest);
+	writer.Put(m_highest);
+	writer.Put(m_digits);
+	writer.Put(m_totalCount);
+	writer.Put(m_sum);
+	writer.Put(m_min);
+	writer.Put(m_max);
+
+	uint64_t used = 0;
+	for (size_t i = 0; i < m_counts.size(); ++i)
+		used += m_counts[i] != 0;
+	writer.Put(used);
+	for (size_t i = 0; i < m_counts.size(); ++i)
+	{
+		if (m_counts[i])
+		{
+			writer.Put(static_cast<uint64_t>(i));
+			writer.Put(m_counts[i]);
+		}
+	}
+}
+
+bool statisticHistogram::LoadState(statisticSnapshotReader& reader)
+{
+	long long lowest = 0, highest = 0;
+	int digits = 0;
+	if (!reader.Get(lowest) || !reader.Get(highest) || !reader.Get(digits))
+		return false;
+	if (lowest < 1 || lowest > c_maxLowest || highest < 2 * lowest || digits < 1 || digits > 5)
+		return reader.Fail();
+
+	statisticHistogram state(lowest, highest, digits);
+	uint64_t used = 0;
+	if (!reader.Get(state.m_totalCount) || !reader.Get(state.m_sum) || !reader.Get(state.m_min)
+		|| !reader.Get(state.m_max) || !reader.Get(used))
+		return false;
+	if (used > state.m_counts.size())
+		return reader.Fail();
+
+	for (uint64_t i = 0; i < used; ++i)
+	{
+		uint64_t index = 0;
+		long long count = 0;
+		if (!reader.Get(index) || !reader.Get(count))
+			return false;
+		if (index >= state.m_counts.size())
+			return reader.Fail();
+		state.m_counts[static_cast<size_t>(index)] = count;
+	}
+
+	*this = state;
+	return true;
+}
+//
+}
+//
@@ -0,0 +1,152 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+//
+#include <mutex>
+#include <vector>
+
+#include "StatisticInstrumentation.h"
+//
+//
+namespace NStatisticEvaluations
+{
+namespace
+{
+// counters blocks of all threads, never freed: a finished thread moves its
+// counts since the last reset to the retired totals and the block goes to the
+// next new thread
+struct instrumentationRegistry
+{
+	instrumentationRegistry() : retired() {}
+
+	std::mutex lock;
+	std::vector<instrumentationCounters*> blocks;
+	std::vector<instrumentationCounters*> free;
+	unsigned long long retired[eCounterCount];
+};
+
+instrumentationRegistry& Registry()
+{
+	static instrumentationRegistry* registry = new instrumentationRegistry();
+	return *registry;
+}
+
+// returns the block to the registry when the thread exits
+struct threadCountersOwner
+{
+	threadCountersOwner() : counters(0) {}
+	~threadCountersOwner()
+	{
+		instrumentationRegistry& registry = Registry();
+		std::lock_guard<std::mutex> guard(registry.lock);
+		for (size_t i = 0; i < eCounterCount; ++i)
+		{
+			registry.retired[i] += counters->values[i].load(std::memory_order_relaxed) -
+				counters->baseline[i].load(std::memory_order_relaxed);
+			counters->values[i].store(0, std::memory_order_relaxed);
+			counters->baseline[i].store(0, std::memory_order_relaxed);
+		}
+		registry.free.push_back(counters);
+	}
+
+	instrumentationCounters* counters;
+};
+
+void Collect(const unsigned long long (&values)[eCounterCount], statisticInstrumentationSnapshot& snapshot)
+{
+	snapshot.eventsIngested += values[eCounterEventsIngested];
+	snapshot.evaluations += values[eCounterEvaluations];
+	snapshot.elementsScanned += values[eCounterElementsScanned];
+	snapshot.bytesCopied += values[eCounterBytesCopied];
+	snapshot.historyReallocations += values[eCounterHistoryReallocations];
+	snapshot.evaluationTimeNs += values[eCounterEvaluationTimeNs];
+}
+
+void Collect(const instrumentationCounters& counters, statisticInstrumentationSnapshot& snapshot)
+{
+	// the values only grow, so they are not below the baseline taken from them
+	unsigned long long values[eCounterCount];
+	for (size_t i = 0; i < eCounterCount; ++i)
+		values[i] = counters.values[i].load(std::memory_order_relaxed) -
+			counters.baseline[i].load(std::memory_order_relaxed);
+	Collect(values, snapshot);
+}
+//
+}
+
+instrumentationCounters* RegisterThreadCounters()
+{
+	static thread_local threadCountersOwner owner;
+
+	instrumentationRegistry& registry = Registry();
+	std::lock_guard<std::mutex> guard(registry.lock);
+	if (!registry.free.empty())
+	{
+		owner.counters = registry.free.back();
+		registry.free.pop_back();
+		return owner.counters;
+	}
+
+	owner.counters = new instrumentationCounters();
+	for (size_t i = 0; i < eCounterCount; ++i)
+	{
+		owner.counters->values[i].store(0, std::memory_order_relaxed);
+		owner.counters->baseline[i].store(0, std::memory_order_relaxed);
+	}
+	registry.blocks.push_back(owner.counters);
+	return owner.counters;
+}
+
+statisticInstrumentationSnapshot InstrumentationSnapshot()
+{
+	statisticInstrumentationSnapshot snapshot;
+	instrumentationRegistry& registry = Registry();
+	std::lock_guard<std::mutex> guard(registry.lock);
+	Collect(registry.retired, snapshot);
+	for (size_t i = 0; i < registry.blocks.size(); ++i)
+		Collect(*registry.blocks[i], snapshot);
+
+	return snapshot;
+}
+
+statisticInstrumentationSnapshot ThreadInstrumentationSnapshot()
+{
+	statisticInstrumentationSnapshot snapshot;
+	Collect(ThreadCounters(), snapshot);
+
+	return snapshot;
+}
+
+void ResetInstrumentation()
+{
+	instrumentationRegistry& registry = Registry();
+	std::lock_guard<std::mutex> guard(registry.lock);
+	for (size_t k = 0; k < eCounterCount; ++k)
+		registry.retired[k] = 0;
+	for (size_t i = 0; i < registry.blocks.size(); ++i)
+	{
+		instrumentationCounters& counters = *registry.blocks[i];
+		for (size_t k = 0; k < eCounterCount; ++k)
+			counters.baseline[k].store(counters.values[k].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+}
+//
+}
+//
@@ -0,0 +1,302 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+//
+#include <atomic>
+
+#include "StatisticKernelsImpl.h"
+
+#if defined(STATISTIC_KERNELS_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+//
+//
+namespace NStatisticKernels
+{
+namespace
+{
+// scalar kernels, independent accumulators on long arrays
+template <class S>
+S ScalarSum(const S* data, size_t n)
+{
+	S s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	size_t i = 0;
+	for (; n >= c_minVectorLength && i + 4 <= n; i += 4)
+	{
+		s0 += data[i];
+		s1 += data[i + 1];
+		s2 += data[i + 2];
+		s3 += data[i + 3];
+	}
+	for (; i < n; ++i)
+		s0 += data[i];
+
+	return (s0 + s1) + (s2 + s3);
+}
+template <class S>
+S ScalarMin(const S* data, size_t n)
+{
+	S min = data[0];
+	for (size_t i = 1; i < n; ++i)
+		min = data[i] < min ? data[i] : min;
+
+	return min;
+}
+template <class S>
+S ScalarMax(const S* data, size_t n)
+{
+	S max = data[0];
+	for (size_t i = 1; i < n; ++i)
+		max = data[i] > max ? data[i] : max;
+
+	return max;
+}
+template <class S>
+S ScalarSquaredDeviation(const S* data, size_t n, S mean)
+{
+	S s0 = 0, s1 = 0;
+	size_t i = 0;
+	for (; n >= c_minVectorLength && i + 2 <= n; i += 2)
+	{
+		const S d0 = data[i] - mean;
+		const S d1 = data[i + 1] - mean;
+		s0 += d0 * d0;
+		s1 += d1 * d1;
+	}
+	for (; i < n; ++i)
+	{
+		const S d = data[i] - mean;
+		s0 += d * d;
+	}
+
+	return s0 + s1;
+}
+
+void GetScalarKernels(kernelTable& table)
+{
+	table.sumFloat = &ScalarSum<float>;
+	table.sumDouble = &ScalarSum<double>;
+	table.sumInt32 = &ScalarSum<int32_t>;
+	table.sumInt64 = &ScalarSum<int64_t>;
+	table.minFloat = &ScalarMin<float>;
+	table.minDouble = &ScalarMin<double>;
+	table.minInt32 = &ScalarMin<int32_t>;
+	table.minInt64 = &ScalarMin<int64_t>;
+	table.maxFloat = &ScalarMax<float>;
+	table.maxDouble = &ScalarMax<double>;
+	table.maxInt32 = &ScalarMax<int32_t>;
+	table.maxInt64 = &ScalarMax<int64_t>;
+	table.sqDevFloat = &ScalarSquaredDeviation<float>;
+	table.sqDevDouble = &ScalarSquaredDeviation<double>;
+	table.sqDevInt32 = &ScalarSquaredDeviation<int32_t>;
+	table.sqDevInt64 = &ScalarSquaredDeviation<int64_t>;
+	table.pairwiseFloat = &PairwiseSum<float, &ScalarSum<float> >;
+	table.pairwiseDouble = &PairwiseSum<double, &ScalarSum<double> >;
+	table.compensatedFloat = &CompensatedSumLoop<scalarOps<float> >;
+	table.compensatedDouble = &CompensatedSumLoop<scalarOps<double> >;
+	table.pairwiseSqDevFloat = &PairwiseSquaredDeviation<float, &ScalarSquaredDeviation<float> >;
+	table.pairwiseSqDevDouble = &PairwiseSquaredDeviation<double, &ScalarSquaredDeviation<double> >;
+}
+
+// copy the non-null kernels of src over dst
+void OverlayKernels(kernelTable& dst, const kernelTable& src)
+{
+#define STATISTIC_OVERLAY_KERNEL(field) if (src.field) dst.field = src.field
+	STATISTIC_OVERLAY_KERNEL(sumFloat);
+	STATISTIC_OVERLAY_KERNEL(sumDouble);
+	STATISTIC_OVERLAY_KERNEL(sumInt32);
+	STATISTIC_OVERLAY_KERNEL(sumInt64);
+	STATISTIC_OVERLAY_KERNEL(minFloat);
+	STATISTIC_OVERLAY_KERNEL(minDouble);
+	STATISTIC_OVERLAY_KERNEL(minInt32);
+	STATISTIC_OVERLAY_KERNEL(minInt64);
+	STATISTIC_OVERLAY_KERNEL(maxFloat);
+	STATISTIC_OVERLAY_KERNEL(maxDouble);
+	STATISTIC_OVERLAY_KERNEL(maxInt32);
+	STATISTIC_OVERLAY_KERNEL(maxInt64);
+	STATISTIC_OVERLAY_KERNEL(sqDevFloat);
+	STATISTIC_OVERLAY_KERNEL(sqDevDouble);
+	STATISTIC_OVERLAY_KERNEL(sqDevInt32);
+	STATISTIC_OVERLAY_KERNEL(sqDevInt64);
+	STATISTIC_OVERLAY_KERNEL(pairwiseFloat);
+	STATISTIC_OVERLAY_KERNEL(pairwiseDouble);
+	STATISTIC_OVERLAY_KERNEL(compensatedFloat);
+	STATISTIC_OVERLAY_KERNEL(compensatedDouble);
+	STATISTIC_OVERLAY_KERNEL(pairwiseSqDevFloat);
+	STATISTIC_OVERLAY_KERNEL(pairwiseSqDevDouble);
+#undef STATISTIC_OVERLAY_KERNEL
+}
+
+EInstructionSet DetectInstructionSet()
+{
+#if defined(STATISTIC_KERNELS_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+	__cpuid(info, 1);
+	const bool sse2 = (info[3] & (1 << 26)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	if (!sse2)
+		return eInstructionSetScalar;
+	if (!osxsave || !avx || maxLeaf < 7)
+		return eInstructionSetSSE2;
+
+	// the OS has to save the YMM (and ZMM) state
+	const unsigned long long xcr0 = _xgetbv(0);
+	if ((xcr0 & 0x6) != 0x6)
+		return eInstructionSetSSE2;
+	__cpuidex(info, 7, 0);
+	const bool avx2 = (info[1] & (1 << 5)) != 0;
+	const bool avx512f = (info[1] & (1 << 16)) != 0;
+	if (avx512f && (xcr0 & 0xE6) == 0xE6)
+		return eInstructionSetAVX512;
+	return avx2 ? eInstructionSetAVX2 : eInstructionSetSSE2;
+#elif defined(STATISTIC_KERNELS_X86) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return eInstructionSetAVX512;
+	if (__builtin_cpu_supports("avx2"))
+		return eInstructionSetAVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return eInstructionSetSSE2;
+	return eInstructionSetScalar;
+#else
+	return eInstructionSetScalar;
+#endif
+}
+
+// kernel tables for every instruction set, built once
+struct kernelDispatch
+{
+	kernelDispatch()
+	{
+		supported = DetectInstructionSet();
+
+		GetScalarKernels(tables[eInstructionSetScalar]);
+		tables[eInstructionSetSSE2] = tables[eInstructionSetScalar];
+		if (supported >= eInstructionSetSSE2)
+			AddKernels(tables[eInstructionSetSSE2], &GetSSE2Kernels);
+		tables[eInstructionSetAVX2] = tables[eInstructionSetSSE2];
+		if (supported >= eInstructionSetAVX2)
+			AddKernels(tables[eInstructionSetAVX2], &GetAVX2Kernels);
+		tables[eInstructionSetAVX512] = tables[eInstructionSetAVX2];
+		if (supported >= eInstructionSetAVX512)
+			AddKernels(tables[eInstructionSetAVX512], &GetAVX512Kernels);
+
+		active.store(&tables[supported]);
+	}
+
+	static void AddKernels(kernelTable& table, void (*getKernels)(kernelTable&))
+	{
+		kernelTable isa = kernelTable();
+		getKernels(isa);
+		OverlayKernels(table, isa);
+	}
+
+	EInstructionSet supported;
+	kernelTable tables[eInstructionSetAVX512 + 1];
+	std::atomic<const kernelTable*> active;
+};
+
+kernelDispatch& Dispatch()
+{
+	static kernelDispatch dispatch;
+	return dispatch;
+}
+
+inline const kernelTable& Kernels()
+{
+	return *Dispatch().active.load(std::memory_order_relaxed);
+}
+//
+}
+
+EInstructionSet SupportedInstructionSet()
+{
+	return Dispatch().supported;
+}
+
+EInstructionSet ActiveInstructionSet()
+{
+	const kernelDispatch& dispatch = Dispatch();
+	return static_cast<EInstructionSet>(dispatch.active.load() - dispatch.tables);
+}
+
+void SetInstructionSet(EInstructionSet set)
+{
+	kernelDispatch& dispatch = Dispatch();
+	if (set > dispatch.supported)
+		set = dispatch.supported;
+	dispatch.active.store(&dispatch.tables[set]);
+}
+
+// sum
+float SumKernel(const float* data, size_t n) { return Kernels().sumFloat(data, n); }
+double SumKernel(const double* data, size_t n) { return Kernels().sumDouble(data, n); }
+int32_t SumKernel(const int32_t* data, size_t n) { return Kernels().sumInt32(data, n); }
+int64_t SumKernel(const int64_t* data, size_t n) { return Kernels().sumInt64(data, n); }
+
+// min
+float MinKernel(const float* data, size_t n) { return Kernels().minFloat(data, n); }
+double MinKernel(const double* data, size_t n) { return Kernels().minDouble(data, n); }
+int32_t MinKernel(const int32_t* data, size_t n) { return Kernels().minInt32(data, n); }
+int64_t MinKernel(const int64_t* data, size_t n) { return Kernels().minInt64(data, n); }
+
+// max
+float MaxKernel(const float* data, size_t n) { return Kernels().maxFloat(data, n); }
+double MaxKernel(const double* data, size_t n) { return Kernels().maxDouble(data, n); }
+int32_t MaxKernel(const int32_t* data, size_t n) { return Kernels().maxInt32(data, n); }
+int64_t MaxKernel(const int64_t* data, size_t n) { return Kernels().maxInt64(data, n); }
+
+// squared deviation
+float SquaredDeviationKernel(const float* data, size_t n, float mean)
+{
+	return Kernels().sqDevFloat(data, n, mean);
+}
+double SquaredDeviationKernel(const double* data, size_t n, double mean)
+{
+	return Kernels().sqDevDouble(data, n, mean);
+}
+int32_t SquaredDeviationKernel(const int32_t* data, size_t n, int32_t mean)
+{
+	return Kernels().sqDevInt32(data, n, mean);
+}
+int64_t SquaredDeviationKernel(const int64_t* data, size_t n, int64_t mean)
+{
+	return Kernels().sqDevInt64(data, n, mean);
+}
+
+// accurate summation
+float PairwiseSumKernel(const float* data, size_t n) { return Kernels().pairwiseFloat(data, n); }
+double PairwiseSumKernel(const double* data, size_t n) { return Kernels().pairwiseDouble(data, n); }
+float CompensatedSumKernel(const float* data, size_t n) { return Kernels().compensatedFloat(data, n); }
+double CompensatedSumKernel(const double* data, size_t n) { return Kernels().compensatedDouble(data, n); }
+float PairwiseSquaredDeviationKernel(const float* data, size_t n, float mean)
+{
+	return Kernels().pairwiseSqDevFloat(data, n, mean);
+}
+double PairwiseSquaredDeviationKernel(const double* data, size_t n, double mean)
+{
+	return Kernels().pairwiseSqDevDouble(data, n, mean);
+}
+//
+}
+//
@@ -0,0 +1,135 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+// AVX2 kernels, this unit is compiled with -mavx2 on gcc and is only called
+// after CPUID reported AVX2 support. int64 products are left to the scalar
+// kernels (no 64 bit multiply in AVX2).
+
+//
+#include "StatisticKernelsImpl.h"
+
+#if defined(STATISTIC_KERNELS_X86)
+#include <immintrin.h>
+#endif
+//
+//
+namespace NStatisticKernels
+{
+#if defined(STATISTIC_KERNELS_X86)
+namespace
+{
+struct avx2Float
+{
+	typedef __m256 V;
+	typedef float S;
+	static const size_t W = 8;
+
+	static V Zero() { return _mm256_setzero_ps(); }
+	static V Set1(S x) { return _mm256_set1_ps(x); }
+	static V Load(const S* p) { return _mm256_loadu_ps(p); }
+	static void Store(S* p, V v) { _mm256_storeu_ps(p, v); }
+	static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+	static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+	static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+	static V Min(V a, V b) { return _mm256_min_ps(a, b); }
+	static V Max(V a, V b) { return _mm256_max_ps(a, b); }
+};
+
+struct avx2Double
+{
+	typedef __m256d V;
+	typedef double S;
+	static const size_t W = 4;
+
+	static V Zero() { return _mm256_setzero_pd(); }
+	static V Set1(S x) { return _mm256_set1_pd(x); }
+	static V Load(const S* p) { return _mm256_loadu_pd(p); }
+	static void Store(S* p, V v) { _mm256_storeu_pd(p, v); }
+	static V Add(V a, V b) { return _mm256_add_pd(a, b); }
+	static V Sub(V a, V b) { return _mm256_sub_pd(a, b); }
+	static V Mul(V a, V b) { return _mm256_mul_pd(a, b); }
+	static V Min(V a, V b) { return _mm256_min_pd(a, b); }
+	static V Max(V a, V b) { return _mm256_max_pd(a, b); }
+};
+
+struct avx2Int32
+{
+	typedef __m256i V;
+	typedef int32_t S;
+	static const size_t W = 8;
+
+	static V Zero() { return _mm256_setzero_si256(); }
+	static V Set1(S x) { return _mm256_set1_epi32(x); }
+	static V Load(const S* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+	static void Store(S* p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+	static V Add(V a, V b) { return _mm256_add_epi32(a, b); }
+	static V Sub(V a, V b) { return _mm256_sub_epi32(a, b); }
+	static V Mul(V a, V b) { return _mm256_mullo_epi32(a, b); }
+	static V Min(V a, V b) { return _mm256_min_epi32(a, b); }
+	static V Max(V a, V b) { return _mm256_max_epi32(a, b); }
+};
+
+struct avx2Int64
+{
+	typedef __m256i V;
+	typedef int64_t S;
+	static const size_t W = 4;
+
+	static V Zero() { return _mm256_setzero_si256(); }
+	static V Load(const S* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+	static void Store(S* p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+	static V Add(V a, V b) { return _mm256_add_epi64(a, b); }
+	static V Min(V a, V b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+	static V Max(V a, V b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+};
+//
+}
+
+void GetAVX2Kernels(kernelTable& table)
+{
+	table.sumFloat = &SumLoop<avx2Float>;
+	table.sumDouble = &SumLoop<avx2Double>;
+	table.sumInt32 = &SumLoop<avx2Int32>;
+	table.sumInt64 = &SumLoop<avx2Int64>;
+	table.minFloat = &MinLoop<avx2Float>;
+	table.minDouble = &MinLoop<avx2Double>;
+	table.minInt32 = &MinLoop<avx2Int32>;
+	table.minInt64 = &MinLoop<avx2Int64>;
+	table.maxFloat = &MaxLoop<avx2Float>;
+	table.maxDouble = &MaxLoop<avx2Double>;
+	table.maxInt32 = &MaxLoop<avx2Int32>;
+	table.maxInt64 = &MaxLoop<avx2Int64>;
+	table.sqDevFloat = &SquaredDeviationLoop<avx2Float>;
+	table.sqDevDouble = &SquaredDeviationLoop<avx2Double>;
+	table.pairwiseFloat = &PairwiseSum<float, &SumLoop<avx2Float> >;
+	table.pairwiseDouble = &PairwiseSum<double, &SumLoop<avx2Double> >;
+	table.compensatedFloat = &CompensatedSumLoop<avx2Float>;
+	table.compensatedDouble = &CompensatedSumLoop<avx2Double>;
+	table.pairwiseSqDevFloat = &PairwiseSquaredDeviation<float, &SquaredDeviationLoop<avx2Float> >;
+	table.pairwiseSqDevDouble = &PairwiseSquaredDeviation<double, &SquaredDeviationLoop<avx2Double> >;
+	table.sqDevInt32 = &SquaredDeviationLoop<avx2Int32>;
+}
+#else
+void GetAVX2Kernels(kernelTable& /*table*/)
+{
+}
+#endif
+//
+}
+//
@@ -0,0 +1,135 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+// AVX-512 kernels, this unit is compiled with -mavx512f on gcc and is only
+// called after CPUID reported AVX-512F support. int64 products are left to
+// the lower instruction sets (64 bit multiply needs AVX-512DQ).
+
+//
+#include "StatisticKernelsImpl.h"
+
+#if defined(STATISTIC_KERNELS_X86)
+#include <immintrin.h>
+#endif
+//
+//
+namespace NStatisticKernels
+{
+#if defined(STATISTIC_KERNELS_X86)
+namespace
+{
+struct avx512Float
+{
+	typedef __m512 V;
+	typedef float S;
+	static const size_t W = 16;
+
+	static V Zero() { return _mm512_setzero_ps(); }
+	static V Set1(S x) { return _mm512_set1_ps(x); }
+	static V Load(const S* p) { return _mm512_loadu_ps(p); }
+	static void Store(S* p, V v) { _mm512_storeu_ps(p, v); }
+	static V Add(V a, V b) { return _mm512_add_ps(a, b); }
+	static V Sub(V a, V b) { return _mm512_sub_ps(a, b); }
+	static V Mul(V a, V b) { return _mm512_mul_ps(a, b); }
+	static V Min(V a, V b) { return _mm512_min_ps(a, b); }
+	static V Max(V a, V b) { return _mm512_max_ps(a, b); }
+};
+
+struct avx512Double
+{
+	typedef __m512d V;
+	typedef double S;
+	static const size_t W = 8;
+
+	static V Zero() { return _mm512_setzero_pd(); }
+	static V Set1(S x) { return _mm512_set1_pd(x); }
+	static V Load(const S* p) { return _mm512_loadu_pd(p); }
+	static void Store(S* p, V v) { _mm512_storeu_pd(p, v); }
+	static V Add(V a, V b) { return _mm512_add_pd(a, b); }
+	static V Sub(V a, V b) { return _mm512_sub_pd(a, b); }
+	static V Mul(V a, V b) { return _mm512_mul_pd(a, b); }
+	static V Min(V a, V b) { return _mm512_min_pd(a, b); }
+	static V Max(V a, V b) { return _mm512_max_pd(a, b); }
+};
+
+struct avx512Int32
+{
+	typedef __m512i V;
+	typedef int32_t S;
+	static const size_t W = 16;
+
+	static V Zero() { return _mm512_setzero_si512(); }
+	static V Set1(S x) { return _mm512_set1_epi32(x); }
+	static V Load(const S* p) { return _mm512_loadu_si512(p); }
+	static void Store(S* p, V v) { _mm512_storeu_si512(p, v); }
+	static V Add(V a, V b) { return _mm512_add_epi32(a, b); }
+	static V Sub(V a, V b) { return _mm512_sub_epi32(a, b); }
+	static V Mul(V a, V b) { return _mm512_mullo_epi32(a, b); }
+	static V Min(V a, V b) { return _mm512_min_epi32(a, b); }
+	static V Max(V a, V b) { return _mm512_max_epi32(a, b); }
+};
+
+struct avx512Int64
+{
+	typedef __m512i V;
+	typedef int64_t S;
+	static const size_t W = 8;
+
+	static V Zero() { return _mm512_setzero_si512(); }
+	static V Load(const S* p) { return _mm512_loadu_si512(p); }
+	static void Store(S* p, V v) { _mm512_storeu_si512(p, v); }
+	static V Add(V a, V b) { return _mm512_add_epi64(a, b); }
+	static V Min(V a, V b) { return _mm512_min_epi64(a, b); }
+	static V Max(V a, V b) { return _mm512_max_epi64(a, b); }
+};
+//
+}
+
+void GetAVX512Kernels(kernelTable& table)
+{
+	table.sumFloat = &SumLoop<avx512Float>;
+	table.sumDouble = &SumLoop<avx512Double>;
+	table.sumInt32 = &SumLoop<avx512Int32>;
+	table.sumInt64 = &SumLoop<avx512Int64>;
+	table.minFloat = &MinLoop<avx512Float>;
+	table.minDouble = &MinLoop<avx512Double>;
+	table.minInt32 = &MinLoop<avx512Int32>;
+	table.minInt64 = &MinLoop<avx512Int64>;
+	table.maxFloat = &MaxLoop<avx512Float>;
+	table.maxDouble = &MaxLoop<avx512Double>;
+	table.maxInt32 = &MaxLoop<avx512Int32>;
+	table.maxInt64 = &MaxLoop<avx512Int64>;
+	table.sqDevFloat = &SquaredDeviationLoop<avx512Float>;
+	table.sqDevDouble = &SquaredDeviationLoop<avx512Double>;
+	table.pairwiseFloat = &PairwiseSum<float, &SumLoop<avx512Float> >;
+	table.pairwiseDouble = &PairwiseSum<double, &SumLoop<avx512Double> >;
+	table.compensatedFloat = &CompensatedSumLoop<avx512Float>;
+	table.compensatedDouble = &CompensatedSumLoop<avx512Double>;
+	table.pairwiseSqDevFloat = &PairwiseSquaredDeviation<float, &SquaredDeviationLoop<avx512Float> >;
+	table.pairwiseSqDevDouble = &PairwiseSquaredDeviation<double, &SquaredDeviationLoop<avx512Double> >;
+	table.sqDevInt32 = &SquaredDeviationLoop<avx512Int32>;
+}
+#else
+void GetAVX512Kernels(kernelTable& /*table*/)
+{
+}
+#endif
+//
+}
+//
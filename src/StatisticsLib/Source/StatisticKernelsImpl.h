@@ -0,0 +1,310 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+// Internal header of the evaluation kernels: dispatch table and the loop
+// templates shared by the SSE2/AVX2/AVX-512 translation units. Every unit is
+// compiled with its own instruction set flags, so the templates live in an
+// anonymous namespace and are never shared between units by the linker.
+
+#ifndef ___StatisticKernelsImpl_H___
+#define ___StatisticKernelsImpl_H___
+
+#include <cstddef>
+#include <stdint.h>
+
+#include "StatisticKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define STATISTIC_KERNELS_X86
+#endif
+
+//
+namespace NStatisticKernels
+{
+// kernel dispatch table, null entries are taken from the lower instruction set
+struct kernelTable
+{
+	float (*sumFloat)(const float*, size_t);
+	double (*sumDouble)(const double*, size_t);
+	int32_t (*sumInt32)(const int32_t*, size_t);
+	int64_t (*sumInt64)(const int64_t*, size_t);
+
+	float (*minFloat)(const float*, size_t);
+	double (*minDouble)(const double*, size_t);
+	int32_t (*minInt32)(const int32_t*, size_t);
+	int64_t (*minInt64)(const int64_t*, size_t);
+
+	float (*maxFloat)(const float*, size_t);
+	double (*maxDouble)(const double*, size_t);
+	int32_t (*maxInt32)(const int32_t*, size_t);
+	int64_t (*maxInt64)(const int64_t*, size_t);
+
+	float (*sqDevFloat)(const float*, size_t, float);
+	double (*sqDevDouble)(const double*, size_t, double);
+	int32_t (*sqDevInt32)(const int32_t*, size_t, int32_t);
+	int64_t (*sqDevInt64)(const int64_t*, size_t, int64_t);
+
+	float (*pairwiseFloat)(const float*, size_t);
+	double (*pairwiseDouble)(const double*, size_t);
+	float (*compensatedFloat)(const float*, size_t);
+	double (*compensatedDouble)(const double*, size_t);
+	float (*pairwiseSqDevFloat)(const float*, size_t, float);
+	double (*pairwiseSqDevDouble)(const double*, size_t, double);
+};
+
+// fill the table with the kernels of one instruction set
+void GetSSE2Kernels(kernelTable& table);
+void GetAVX2Kernels(kernelTable& table);
+void GetAVX512Kernels(kernelTable& table);
+
+namespace
+{
+// arrays shorter than this are summed sequentially
+const size_t c_minVectorLength = 64;
+
+// one lane operations type for the scalar kernels
+template <class T> struct scalarOps
+{
+	typedef T V;
+	typedef T S;
+	static const size_t W = 1;
+
+	static V Zero() { return 0; }
+	static V Load(const S* p) { return *p; }
+	static void Store(S* p, V v) { *p = v; }
+	static V Add(V a, V b) { return a + b; }
+	static V Sub(V a, V b) { return a - b; }
+};
+
+// Loops over a vector operations type:
+//   V, S, W           - register type, scalar type, lanes count
+//   Zero/Set1/Load    - register construction (unaligned load)
+//   Add/Sub/Mul/Min/Max
+//   Store             - store W lanes into an array (unaligned store)
+template <class Ops>
+typename Ops::S SumLoop(const typename Ops::S* data, size_t n)
+{
+	typedef typename Ops::S S;
+	typedef typename Ops::V V;
+	const size_t W = Ops::W;
+
+	S sum = 0;
+	size_t i = 0;
+	if (n >= c_minVectorLength)
+	{
+		V a0 = Ops::Zero(), a1 = Ops::Zero(), a2 = Ops::Zero(), a3 = Ops::Zero();
+		for (; i + 4 * W <= n; i += 4 * W)
+		{
+			a0 = Ops::Add(a0, Ops::Load(data + i));
+			a1 = Ops::Add(a1, Ops::Load(data + i + W));
+			a2 = Ops::Add(a2, Ops::Load(data + i + 2 * W));
+			a3 = Ops::Add(a3, Ops::Load(data + i + 3 * W));
+		}
+		a0 = Ops::Add(Ops::Add(a0, a1), Ops::Add(a2, a3));
+
+		S lanes[W];
+		Ops::Store(lanes, a0);
+		for (size_t k = 0; k < W; ++k)
+			sum += lanes[k];
+	}
+	for (; i < n; ++i)
+		sum += data[i];
+
+	return sum;
+}
+
+template <class Ops>
+typename Ops::S MinLoop(const typename Ops::S* data, size_t n)
+{
+	typedef typename Ops::S S;
+	typedef typename Ops::V V;
+	const size_t W = Ops::W;
+
+	S min = data[0];
+	size_t i = 0;
+	if (n >= c_minVectorLength)
+	{
+		V a0 = Ops::Load(data), a1 = a0, a2 = a0, a3 = a0;
+		for (; i + 4 * W <= n; i += 4 * W)
+		{
+			a0 = Ops::Min(a0, Ops::Load(data + i));
+			a1 = Ops::Min(a1, Ops::Load(data + i + W));
+			a2 = Ops::Min(a2, Ops::Load(data + i + 2 * W));
+			a3 = Ops::Min(a3, Ops::Load(data + i + 3 * W));
+		}
+		a0 = Ops::Min(Ops::Min(a0, a1), Ops::Min(a2, a3));
+
+		S lanes[W];
+		Ops::Store(lanes, a0);
+		for (size_t k = 0; k < W; ++k)
+			min = lanes[k] < min ? lanes[k] : min;
+	}
+	for (; i < n; ++i)
+		min = data[i] < min ? data[i] : min;
+
+	return min;
+}
+
+template <class Ops>
+typename Ops::S MaxLoop(const typename Ops::S* data, size_t n)
+{
+	typedef typename Ops::S S;
+	typedef typename Ops::V V;
+	const size_t W = Ops::W;
+
+	S max = data[0];
+	size_t i = 0;
+	if (n >= c_minVectorLength)
+	{
+		V a0 = Ops::Load(data), a1 = a0, a2 = a0, a3 = a0;
+		for (; i + 4 * W <= n; i += 4 * W)
+		{
+			a0 = Ops::Max(a0, Ops::Load(data + i));
+			a1 = Ops::Max(a1, Ops::Load(data + i + W));
+			a2 = Ops::Max(a2, Ops::Load(data + i + 2 * W));
+			a3 = Ops::Max(a3, Ops::Load(data + i + 3 * W));
+		}
+		a0 = Ops::Max(Ops::Max(a0, a1), Ops::Max(a2, a3));
+
+		S lanes[W];
+		Ops::Store(lanes, a0);
+		for (size_t k = 0; k < W; ++k)
+			max = lanes[k] > max ? lanes[k] : max;
+	}
+	for (; i < n; ++i)
+		max = data[i] > max ? data[i] : max;
+
+	return max;
+}
+
+template <class Ops>
+typename Ops::S SquaredDeviationLoop(const typename Ops::S* data, size_t n, typename Ops::S mean)
+{
+	typedef typename Ops::S S;
+	typedef typename Ops::V V;
+	const size_t W = Ops::W;
+
+	S sum = 0;
+	size_t i = 0;
+	if (n >= c_minVectorLength)
+	{
+		const V m = Ops::Set1(mean);
+		V a0 = Ops::Zero(), a1 = Ops::Zero();
+		for (; i + 2 * W <= n; i += 2 * W)
+		{
+			const V d0 = Ops::Sub(Ops::Load(data + i), m);
+			const V d1 = Ops::Sub(Ops::Load(data + i + W), m);
+			a0 = Ops::Add(a0, Ops::Mul(d0, d0));
+			a1 = Ops::Add(a1, Ops::Mul(d1, d1));
+		}
+		a0 = Ops::Add(a0, a1);
+
+		S lanes[W];
+		Ops::Store(lanes, a0);
+		for (size_t k = 0; k < W; ++k)
+			sum += lanes[k];
+	}
+	for (; i < n; ++i)
+	{
+		const S k = data[i] - mean;
+		sum += k * k;
+	}
+
+	return sum;
+}
+
+// Blocked pairwise summation: blocks of c_pairwiseBlock values are summed by
+// the vector loops, the block sums are added pairwise, so the error grows
+// as O(log n) instead of O(n) at the speed of the plain loop.
+const size_t c_pairwiseBlock = 256;
+
+template <class S, S (*Block)(const S*, size_t)>
+S PairwiseSum(const S* data, size_t n)
+{
+	if (n <= c_pairwiseBlock)
+		return Block(data, n);
+
+	const size_t half = (n / c_pairwiseBlock + 1) / 2 * c_pairwiseBlock;
+	return PairwiseSum<S, Block>(data, half) + PairwiseSum<S, Block>(data + half, n - half);
+}
+
+template <class S, S (*Block)(const S*, size_t, S)>
+S PairwiseSquaredDeviation(const S* data, size_t n, S mean)
+{
+	if (n <= c_pairwiseBlock)
+		return Block(data, n, mean);
+
+	const size_t half = (n / c_pairwiseBlock + 1) / 2 * c_pairwiseBlock;
+	return PairwiseSquaredDeviation<S, Block>(data, half, mean)
+		+ PairwiseSquaredDeviation<S, Block>(data + half, n - half, mean);
+}
+
+// Compensated summation: every lane keeps the rounding error of its sum
+// (TwoSum, branch free form of Neumaier's algorithm). The error terms rely
+// on IEEE evaluation order, the units are not built with fast-math options.
+template <class Ops>
+inline void TwoSum(typename Ops::V& sum, typename Ops::V& error, typename Ops::V x)
+{
+	typedef typename Ops::V V;
+	const V t = Ops::Add(sum, x);
+	const V bp = Ops::Sub(t, sum);
+	const V e = Ops::Add(Ops::Sub(sum, Ops::Sub(t, bp)), Ops::Sub(x, bp));
+	error = Ops::Add(error, e);
+	sum = t;
+}
+
+template <class Ops>
+typename Ops::S CompensatedSumLoop(const typename Ops::S* data, size_t n)
+{
+	typedef typename Ops::S S;
+	typedef typename Ops::V V;
+	const size_t W = Ops::W;
+
+	V s0 = Ops::Zero(), s1 = Ops::Zero(), e0 = Ops::Zero(), e1 = Ops::Zero();
+	size_t i = 0;
+	for (; i + 2 * W <= n; i += 2 * W)
+	{
+		TwoSum<Ops>(s0, e0, Ops::Load(data + i));
+		TwoSum<Ops>(s1, e1, Ops::Load(data + i + W));
+	}
+	TwoSum<Ops>(s0, e0, s1);
+	e0 = Ops::Add(e0, e1);
+
+	S sums[W], errors[W];
+	Ops::Store(sums, s0);
+	Ops::Store(errors, e0);
+
+	// lanes and the tail in scalar form
+	S sum = 0, error = 0;
+	for (size_t k = 0; k < W; ++k)
+	{
+		TwoSum<scalarOps<S> >(sum, error, sums[k]);
+		error += errors[k];
+	}
+	for (; i < n; ++i)
+		TwoSum<scalarOps<S> >(sum, error, data[i]);
+
+	return sum + error;
+}
+//
+}
+//
+}
+//
+#endif /* ___StatisticKernelsImpl_H___ */
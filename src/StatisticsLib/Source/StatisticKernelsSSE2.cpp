@@ -0,0 +1,128 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+// SSE2 kernels, this unit is compiled with -msse2 on gcc.
+// int32 min/max are emulated with compare and select, int64 min/max and
+// integer products are left to the scalar kernels (SSE4 instructions).
+
+//
+#include "StatisticKernelsImpl.h"
+
+#if defined(STATISTIC_KERNELS_X86)
+#include <emmintrin.h>
+#endif
+//
+//
+namespace NStatisticKernels
+{
+#if defined(STATISTIC_KERNELS_X86)
+namespace
+{
+struct sse2Float
+{
+	typedef __m128 V;
+	typedef float S;
+	static const size_t W = 4;
+
+	static V Zero() { return _mm_setzero_ps(); }
+	static V Set1(S x) { return _mm_set1_ps(x); }
+	static V Load(const S* p) { return _mm_loadu_ps(p); }
+	static void Store(S* p, V v) { _mm_storeu_ps(p, v); }
+	static V Add(V a, V b) { return _mm_add_ps(a, b); }
+	static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+	static V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+	static V Min(V a, V b) { return _mm_min_ps(a, b); }
+	static V Max(V a, V b) { return _mm_max_ps(a, b); }
+};
+
+struct sse2Double
+{
+	typedef __m128d V;
+	typedef double S;
+	static const size_t W = 2;
+
+	static V Zero() { return _mm_setzero_pd(); }
+	static V Set1(S x) { return _mm_set1_pd(x); }
+	static V Load(const S* p) { return _mm_loadu_pd(p); }
+	static void Store(S* p, V v) { _mm_storeu_pd(p, v); }
+	static V Add(V a, V b) { return _mm_add_pd(a, b); }
+	static V Sub(V a, V b) { return _mm_sub_pd(a, b); }
+	static V Mul(V a, V b) { return _mm_mul_pd(a, b); }
+	static V Min(V a, V b) { return _mm_min_pd(a, b); }
+	static V Max(V a, V b) { return _mm_max_pd(a, b); }
+};
+
+struct sse2Int32
+{
+	typedef __m128i V;
+	typedef int32_t S;
+	static const size_t W = 4;
+
+	static V Zero() { return _mm_setzero_si128(); }
+	static V Load(const S* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+	static void Store(S* p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+	static V Add(V a, V b) { return _mm_add_epi32(a, b); }
+	static V Select(V mask, V a, V b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+	static V Min(V a, V b) { return Select(_mm_cmplt_epi32(a, b), a, b); }
+	static V Max(V a, V b) { return Select(_mm_cmpgt_epi32(a, b), a, b); }
+};
+
+struct sse2Int64
+{
+	typedef __m128i V;
+	typedef int64_t S;
+	static const size_t W = 2;
+
+	static V Zero() { return _mm_setzero_si128(); }
+	static V Load(const S* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+	static void Store(S* p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+	static V Add(V a, V b) { return _mm_add_epi64(a, b); }
+};
+//
+}
+
+void GetSSE2Kernels(kernelTable& table)
+{
+	table.sumFloat = &SumLoop<sse2Float>;
+	table.sumDouble = &SumLoop<sse2Double>;
+	table.sumInt32 = &SumLoop<sse2Int32>;
+	table.sumInt64 = &SumLoop<sse2Int64>;
+	table.minFloat = &MinLoop<sse2Float>;
+	table.minDouble = &MinLoop<sse2Double>;
+	table.minInt32 = &MinLoop<sse2Int32>;
+	table.maxFloat = &MaxLoop<sse2Float>;
+	table.maxDouble = &MaxLoop<sse2Double>;
+	table.maxInt32 = &MaxLoop<sse2Int32>;
+	table.sqDevFloat = &SquaredDeviationLoop<sse2Float>;
+	table.sqDevDouble = &SquaredDeviationLoop<sse2Double>;
+	table.pairwiseFloat = &PairwiseSum<float, &SumLoop<sse2Float> >;
+	table.pairwiseDouble = &PairwiseSum<double, &SumLoop<sse2Double> >;
+	table.compensatedFloat = &CompensatedSumLoop<sse2Float>;
+	table.compensatedDouble = &CompensatedSumLoop<sse2Double>;
+	table.pairwiseSqDevFloat = &PairwiseSquaredDeviation<float, &SquaredDeviationLoop<sse2Float> >;
+	table.pairwiseSqDevDouble = &PairwiseSquaredDeviation<double, &SquaredDeviationLoop<sse2Double> >;
+}
+#else
+void GetSSE2Kernels(kernelTable& /*table*/)
+{
+}
+#endif
+//
+}
+//
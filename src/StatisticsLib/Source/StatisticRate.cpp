@@ -0,0 +1,165 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+//
+#include <math.h>
+
+#include "StatisticRate.h"
+//
+//
+namespace NStatisticEvents
+{
+namespace
+{
+const long long c_second = 1000000000LL;
+
+// smoothing factors of the 1, 5 and 15 minute rates for one tick
+const double c_alpha[3] =
+{
+	1.0 - exp(-5.0 / 60.0 / 1.0),
+	1.0 - exp(-5.0 / 60.0 / 5.0),
+	1.0 - exp(-5.0 / 60.0 / 15.0)
+};
+//
+}
+
+const long long statisticRateMeter::c_tickInterval;
+
+statisticRateMeter::statisticRateMeter()
+{
+	Reset(SteadyClockNs());
+}
+
+statisticRateMeter::statisticRateMeter(long long startTime)
+{
+	Reset(startTime);
+}
+
+statisticRateMeter::statisticRateMeter(const statisticRateMeter& other)
+{
+	CopyFrom(other);
+}
+
+statisticRateMeter& statisticRateMeter::operator=(const statisticRateMeter& other)
+{
+	if (this != &other)
+		CopyFrom(other);
+	return *this;
+}
+
+void statisticRateMeter::CopyFrom(const statisticRateMeter& other)
+{
+	m_count.store(other.m_count.load());
+	m_uncounted.store(other.m_uncounted.load());
+	m_lastTick.store(other.m_lastTick.load());
+	for (int i = 0; i < eRatesCount; ++i)
+		m_rates[i].store(other.m_rates[i].load());
+	for (int i = 0; i < c_bucketsCount; ++i)
+		m_buckets[i].store(other.m_buckets[i].load());
+	m_startTime.store(other.m_startTime.load());
+}
+
+void statisticRateMeter::Reset(long long startTime)
+{
+	m_count.store(0);
+	m_uncounted.store(0);
+	m_lastTick.store(startTime);
+	for (int i = 0; i < eRatesCount; ++i)
+		m_rates[i].store(-1.0);
+	for (int i = 0; i < c_bucketsCount; ++i)
+		m_buckets[i].store(0);
+	m_startTime.store(startTime);
+}
+
+void statisticRateMeter::Mark(unsigned long long n, long long now)
+{
+	m_count.fetch_add(n, std::memory_order_relaxed);
+	m_uncounted.fetch_add(n, std::memory_order_relaxed);
+	Tick(now);
+
+	// count the events in the bucket of the current second,
+	// a bucket left from an earlier second is restarted
+	const unsigned long long second = static_cast<unsigned long long>(now / c_second);
+	const unsigned long long tag = second << c_countBits;
+	std::atomic<unsigned long long>& bucket = m_buckets[second % c_bucketsCount];
+	unsigned long long old = bucket.load(std::memory_order_relaxed);
+	unsigned long long value;
+	do
+	{
+		value = (old >> c_countBits) == (second & ((1ULL << (64 - c_countBits)) - 1))
+			? old + n : tag | n;
+	}
+	while (!bucket.compare_exchange_weak(old, value, std::memory_order_relaxed));
+}
+
+double statisticRateMeter::MeanRate(long long now) const
+{
+	const long long elapsed = now - m_startTime.load(std::memory_order_relaxed);
+	if (elapsed <= 0)
+		return 0;
+	return Count() * 1e9 / elapsed;
+}
+
+double statisticRateMeter::InstantRate(long long now) const
+{
+	const unsigned long long second = static_cast<unsigned long long>(now / c_second) - 1;
+	const unsigned long long value = m_buckets[second % c_bucketsCount].load(std::memory_order_relaxed);
+	if ((value >> c_countBits) != (second & ((1ULL << (64 - c_countBits)) - 1)))
+		return 0;
+	return static_cast<double>(value & ((1ULL << c_countBits) - 1));
+}
+
+double statisticRateMeter::Rate(ERate rate, long long now) const
+{
+	Tick(now);
+
+	const double value = m_rates[rate].load(std::memory_order_relaxed);
+	return value < 0 ? 0 : value;
+}
+
+// lazy update of the smoothed rates, the thread that moves the tick time updates them
+void statisticRateMeter::Tick(long long now) const
+{
+	long long last = m_lastTick.load(std::memory_order_relaxed);
+	if (now - last < c_tickInterval)
+		return;
+
+	const long long ticks = (now - last) / c_tickInterval;
+	if (!m_lastTick.compare_exchange_strong(last, last + ticks * c_tickInterval))
+		return;
+
+	// events of the first elapsed interval, the other intervals were idle
+	const double instant = m_uncounted.exchange(0) * 1e9 / c_tickInterval;
+	for (int i = 0; i < eRatesCount; ++i)
+	{
+		const double idle = ticks > 1 ? pow(1.0 - c_alpha[i], static_cast<double>(ticks - 1)) : 1.0;
+		double old = m_rates[i].load(std::memory_order_relaxed);
+		double value;
+		do
+		{
+			value = old < 0 ? instant : old + c_alpha[i] * (instant - old);
+			value *= idle;
+		}
+		while (!m_rates[i].compare_exchange_weak(old, value, std::memory_order_relaxed));
+	}
+}
+//
+}
+//
@@ -0,0 +1,277 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+//
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "StatisticReader.h"
+//
+//
+namespace NStatisticEvents
+{
+namespace
+{
+// powers of ten exactly representable in double
+const double c_exactPowers[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline bool IsDigit(char c)
+{
+	return static_cast<unsigned>(c - '0') < 10;
+}
+
+// slow path: strtod over a null terminated copy of the number
+const char* ParseSlow(const char* first, const char* last, double& value)
+{
+	char buffer[128];
+	const size_t length = last - first;
+	std::string large;
+	char* text = buffer;
+	if (length >= sizeof(buffer))
+	{
+		large.assign(first, last);
+		text = &large[0];
+	}
+	else
+	{
+		memcpy(buffer, first, length);
+		buffer[length] = 0;
+	}
+
+	char* end = 0;
+	value = strtod(text, &end);
+	return first + (end - text);
+}
+//
+}
+
+const char* StatisticParseNumber(const char* first, const char* last, double& value)
+{
+	const char* p = first;
+	const bool negative = p != last && *p == '-';
+	if (p != last && (*p == '-' || *p == '+'))
+		++p;
+
+	// up to 19 significant digits fit the mantissa
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool inexact = false;
+	const char* start = p;
+	for (; p != last && IsDigit(*p); ++p)
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			digits += mantissa != 0;
+		}
+		else
+		{
+			++exponent;
+			inexact = inexact || *p != '0';
+		}
+	}
+	bool any = p != start;
+	if (p != last && *p == '.')
+	{
+		++p;
+		start = p;
+		for (; p != last && IsDigit(*p); ++p)
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				digits += mantissa != 0;
+				--exponent;
+			}
+			else
+				inexact = inexact || *p != '0';
+		}
+		any = any || p != start;
+	}
+	if (!any)
+	{
+		// inf, nan
+		while (p != last && ((*p | 0x20) >= 'a' && (*p | 0x20) <= 'z'))
+			++p;
+		return p == start ? first : ParseSlow(first, p, value);
+	}
+
+	if (p != last && (*p == 'e' || *p == 'E'))
+	{
+		const char* e = p + 1;
+		const bool negativeExponent = e != last && *e == '-';
+		if (e != last && (*e == '-' || *e == '+'))
+			++e;
+		if (e != last && IsDigit(*e))
+		{
+			int power = 0;
+			for (; e != last && IsDigit(*e); ++e)
+				power = power < 100000 ? power * 10 + (*e - '0') : power;
+			exponent += negativeExponent ? -power : power;
+			p = e;
+		}
+	}
+
+	// Clinger's fast path: both the mantissa and the power of ten are exact,
+	// so one correctly rounded operation gives the correctly rounded result
+	if (!inexact && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+	{
+		double result = static_cast<double>(mantissa);
+		result = exponent < 0 ? result / c_exactPowers[-exponent] : result * c_exactPowers[exponent];
+		value = negative ? -result : result;
+		return p;
+	}
+	return ParseSlow(first, p, value);
+}
+
+const char* StatisticParseNumber(const char* first, const char* last, long long& value)
+{
+	const char* p = first;
+	const bool negative = p != last && *p == '-';
+	if (p != last && (*p == '-' || *p == '+'))
+		++p;
+
+	const char* start = p;
+	uint64_t result = 0;
+	const uint64_t limit = negative ? 9223372036854775808ULL : 9223372036854775807ULL;
+	for (; p != last && IsDigit(*p); ++p)
+	{
+		const unsigned digit = *p - '0';
+		if (result > (limit - digit) / 10)
+			return first;
+		result = result * 10 + digit;
+	}
+	if (p == start)
+		return first;
+
+	value = negative ? static_cast<long long>(0 - result) : static_cast<long long>(result);
+	return p;
+}
+
+// chunk reader
+statisticChunkReader::statisticChunkReader()
+	: m_file(0), m_current(-1), m_done(true), m_failed(false), m_stop(false)
+{
+	m_sizes[0] = m_sizes[1] = 0;
+	m_full[0] = m_full[1] = false;
+}
+
+bool statisticChunkReader::Open(const std::string& path, size_t chunkSize)
+{
+	Close();
+	m_file = std::fopen(path.c_str(), "rb");
+	if (!m_file)
+		return false;
+
+	// the chunks are large, the stdio buffer would only add a copy
+	std::setvbuf(m_file, 0, _IONBF, 0);
+	for (int i = 0; i < 2; ++i)
+	{
+		m_buffers[i].resize(chunkSize ? chunkSize : 1);
+		m_sizes[i] = 0;
+		m_full[i] = false;
+	}
+	m_current = -1;
+	m_done = m_failed = m_stop = false;
+	m_thread = std::thread(&statisticChunkReader::ReadLoop, this);
+	return true;
+}
+
+void statisticChunkReader::Close()
+{
+	if (m_thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_changed.notify_all();
+		m_thread.join();
+	}
+	if (m_file)
+	{
+		std::fclose(m_file);
+		m_file = 0;
+	}
+	m_done = true;
+	m_current = -1;
+}
+
+void statisticChunkReader::ReadLoop()
+{
+	for (int index = 0; ; index ^= 1)
+	{
+		{
+			// wait until the consumer releases the buffer
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (m_full[index] && !m_stop)
+				m_changed.wait(lock);
+			if (m_stop)
+				return;
+		}
+
+		std::vector<char>& buffer = m_buffers[index];
+		const size_t size = std::fread(&buffer[0], 1, buffer.size(), m_file);
+		const bool failed = std::ferror(m_file) != 0;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_sizes[index] = size;
+			m_full[index] = size != 0;
+			m_failed = failed;
+			m_done = size < buffer.size();
+		}
+		m_changed.notify_all();
+		if (size < buffer.size())
+			return;
+	}
+}
+
+bool statisticChunkReader::Next(const char*& data, size_t& size)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	int index = 0;
+	if (m_current >= 0)
+	{
+		m_full[m_current] = false;
+		index = m_current ^ 1;
+		m_current = -1;
+		m_changed.notify_all();
+	}
+	if (!m_thread.joinable())
+		return false;
+
+	while (!m_full[index] && !m_done)
+		m_changed.wait(lock);
+	if (!m_full[index])
+		return false;
+
+	m_current = index;
+	data = &m_buffers[index][0];
+	size = m_sizes[index];
+	return true;
+}
+//
+}
+//
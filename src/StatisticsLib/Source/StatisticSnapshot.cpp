@@ -0,0 +1,227 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+//
+#include <string.h>
+
+#include "StatisticSnapshot.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+//
+//
+namespace NStatisticEvaluations
+{
+namespace
+{
+const char c_snapshotMagic[4] = {'S', 'S', 'N', 'P'};
+const uint64_t c_checksumSeed = 0x736e617073686f74ULL;
+
+struct snapshotHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t kind;
+	uint32_t reserved;
+	uint64_t size;                      // payload size
+	uint64_t checksum;                  // payload checksum
+	uint8_t padding[32];
+};
+
+static_assert(sizeof(snapshotHeader) == c_snapshotHeaderSize, "the payload has to stay 8 byte aligned");
+//
+}
+
+uint64_t StatisticChecksum(const void* data, size_t size, uint64_t seed)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64_t hash = seed;
+	for (; size >= 8; bytes += 8, size -= 8)
+	{
+		uint64_t word;
+		memcpy(&word, bytes, 8);
+		hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+		hash ^= hash >> 32;
+	}
+	if (size)
+	{
+		uint64_t word = 0;
+		memcpy(&word, bytes, size);
+		hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+		hash ^= hash >> 32;
+	}
+	return hash;
+}
+
+// writer
+statisticSnapshotWriter::statisticSnapshotWriter(void* buffer, size_t capacity)
+	: m_buffer(static_cast<char*>(buffer)), m_capacity(capacity), m_file(0),
+	m_size(0), m_checksum(c_checksumSeed), m_failed(false), m_staged(0)
+{
+}
+
+statisticSnapshotWriter::statisticSnapshotWriter(std::FILE* file)
+	: m_buffer(0), m_capacity(0), m_file(file), m_size(0), m_checksum(c_checksumSeed), m_failed(false), m_staged(0)
+{
+}
+
+void statisticSnapshotWriter::Write(const void* data, size_t size)
+{
+	if (m_failed || !size)
+		return;
+
+	if (m_file)
+	{
+		const char* bytes = static_cast<const char*>(data);
+		while (size)
+		{
+			size_t chunk = sizeof(m_stage) - m_staged;
+			chunk = chunk < size ? chunk : size;
+			memcpy(m_stage + m_staged, bytes, chunk);
+			m_staged += chunk;
+			bytes += chunk;
+			size -= chunk;
+			m_size += chunk;
+			if (m_staged == sizeof(m_stage) && !WriteStage())
+				return;
+		}
+		return;
+	}
+
+	if (m_buffer)
+	{
+		if (size > m_capacity - m_size)
+		{
+			m_failed = true;
+			return;
+		}
+		memcpy(m_buffer + m_size, data, size);
+	}
+	m_size += size;
+}
+
+bool statisticSnapshotWriter::WriteStage()
+{
+	m_checksum = StatisticChecksum(m_stage, m_staged, m_checksum);
+	if (std::fwrite(m_stage, 1, m_staged, m_file) != m_staged)
+		m_failed = true;
+	m_staged = 0;
+	return !m_failed;
+}
+
+bool statisticSnapshotWriter::Finish()
+{
+	if (m_failed)
+		return false;
+
+	if (m_file)
+		return WriteStage() && std::fflush(m_file) == 0;
+
+	if (m_buffer)
+		m_checksum = StatisticChecksum(m_buffer, static_cast<size_t>(m_size), c_checksumSeed);
+	return true;
+}
+
+// reader
+bool statisticSnapshotReader::Read(void* data, size_t size)
+{
+	if (m_failed || size > m_size)
+		return Fail();
+
+	memcpy(data, m_data, size);
+	m_data += size;
+	m_size -= size;
+	return true;
+}
+
+// header
+void WriteSnapshotHeader(void* header, uint32_t kind, uint64_t size, uint64_t checksum)
+{
+	snapshotHeader value = snapshotHeader();
+	memcpy(value.magic, c_snapshotMagic, sizeof(c_snapshotMagic));
+	value.version = c_snapshotVersion;
+	value.kind = kind;
+	value.size = size;
+	value.checksum = checksum;
+	memcpy(header, &value, sizeof(value));
+}
+
+bool CheckSnapshot(const void* data, size_t size, uint32_t kind, const void*& payload, size_t& payloadSize)
+{
+	if (!data || size < sizeof(snapshotHeader))
+		return false;
+
+	snapshotHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, c_snapshotMagic, sizeof(c_snapshotMagic)) || header.version != c_snapshotVersion
+		|| header.kind != kind || header.size != size - sizeof(header))
+		return false;
+
+	payload = static_cast<const char*>(data) + sizeof(header);
+	payloadSize = size - sizeof(header);
+	return StatisticChecksum(payload, payloadSize, c_checksumSeed) == header.checksum;
+}
+
+// file
+std::FILE* BeginSnapshotFile(const std::string& path)
+{
+	std::FILE* file = std::fopen((path + ".tmp").c_str(), "wb");
+	if (!file)
+		return 0;
+
+	// the header is written when the payload is complete
+	const char header[c_snapshotHeaderSize] = {0};
+	if (std::fwrite(header, 1, sizeof(header), file) != sizeof(header))
+	{
+		std::fclose(file);
+		return 0;
+	}
+	return file;
+}
+
+bool EndSnapshotFile(std::FILE* file, const std::string& path, statisticSnapshotWriter& writer, uint32_t kind)
+{
+	char header[c_snapshotHeaderSize];
+	bool result = writer.Finish();
+	if (result)
+	{
+		WriteSnapshotHeader(header, kind, writer.Size(), writer.Checksum());
+		result = std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+	}
+	result = std::fclose(file) == 0 && result;
+
+	// the previous snapshot is replaced only by a complete one
+	const std::string temporary = path + ".tmp";
+	if (result)
+	{
+#if defined(_WIN32)
+		result = MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		result = std::rename(temporary.c_str(), path.c_str()) == 0;
+#endif
+	}
+	if (!result)
+		std::remove(temporary.c_str());
+	return result;
+}
+//
+}
+//
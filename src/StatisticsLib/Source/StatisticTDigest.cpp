@@ -0,0 +1,300 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+//
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+#include "StatisticTDigest.h"
+//
+//
+namespace NStatisticEvaluations
+{
+namespace
+{
+const double c_pi = 3.14159265358979323846;
+
+bool CentroidLess(const statisticTDigest::centroid& a, const statisticTDigest::centroid& b)
+{
+	return a.mean < b.mean;
+}
+
+// scale function k1: k(q) = compression / (2 pi) * asin(2q - 1)
+inline double ScaleK(double q, double compression)
+{
+	return compression / (2.0 * c_pi) * asin(2.0 * q - 1.0);
+}
+inline double ScaleQ(double k, double compression)
+{
+	if (k >= compression / 4.0)
+		return 1.0;
+	return (sin(k * 2.0 * c_pi / compression) + 1.0) / 2.0;
+}
+//
+}
+
+statisticTDigest::statisticTDigest(double compression)
+	: m_compression(compression > 10.0 ? compression : 10.0)
+{
+	m_bufferCapacity = static_cast<size_t>(m_compression * 5.0);
+	m_buffer.reserve(m_bufferCapacity);
+	m_centroids.reserve(static_cast<size_t>(m_compression * 2.0));
+	Reset();
+}
+
+void statisticTDigest::Reset()
+{
+	m_centroids.clear();
+	m_buffer.clear();
+	m_count = m_bufferWeight = 0.0;
+	m_min = std::numeric_limits<double>::infinity();
+	m_max = -std::numeric_limits<double>::infinity();
+}
+
+void statisticTDigest::Add(double value, double weight)
+{
+	if (weight <= 0.0 || value != value)
+		return;
+
+	m_min = value < m_min ? value : m_min;
+	m_max = value > m_max ? value : m_max;
+
+	const centroid c = {value, weight};
+	m_buffer.push_back(c);
+	m_bufferWeight += weight;
+	if (m_buffer.size() >= m_bufferCapacity)
+		Flush();
+}
+
+void statisticTDigest::Merge(const statisticTDigest& other)
+{
+	// a copy: Add changes the centroids when other is this digest
+	const std::vector<centroid> centroids = other.GetCentroids();
+	for (size_t i = 0; i < centroids.size(); ++i)
+		Add(centroids[i].mean, centroids[i].weight);
+
+	// the extremes of the other digest may be inside its centroids
+	if (other.GetCount() > 0)
+	{
+		m_min = other.m_min < m_min ? other.m_min : m_min;
+		m_max = other.m_max > m_max ? other.m_max : m_max;
+	}
+}
+
+std::vector<statisticTDigest::centroid> statisticTDigest::GetCentroids() const
+{
+	std::vector<centroid> scratch;
+	const std::vector<centroid>& centroids = Merged(scratch);
+	return &centroids == &scratch ? scratch : centroids;
+}
+
+// merge the buffer into the centroids
+void statisticTDigest::Flush()
+{
+	if (m_buffer.empty())
+		return;
+
+	m_buffer.insert(m_buffer.end(), m_centroids.begin(), m_centroids.end());
+	std::sort(m_buffer.begin(), m_buffer.end(), CentroidLess);
+	CompressCentroids(m_buffer, m_count + m_bufferWeight, m_compression, m_centroids);
+
+	m_buffer.clear();
+	m_count += m_bufferWeight;
+	m_bufferWeight = 0.0;
+}
+
+const std::vector<statisticTDigest::centroid>& statisticTDigest::Merged(std::vector<centroid>& scratch) const
+{
+	if (m_buffer.empty())
+		return m_centroids;
+
+	std::vector<centroid> values(m_buffer);
+	values.insert(values.end(), m_centroids.begin(), m_centroids.end());
+	std::sort(values.begin(), values.end(), CentroidLess);
+	CompressCentroids(values, m_count + m_bufferWeight, m_compression, scratch);
+	return scratch;
+}
+
+// one pass over the sorted values
+void statisticTDigest::CompressCentroids(const std::vector<centroid>& values, double total, double compression,
+	std::vector<centroid>& out)
+{
+	out.clear();
+
+	centroid current = values[0];
+	double weightSoFar = 0.0;
+	double limit = total * ScaleQ(ScaleK(0.0, compression) + 1.0, compression);
+	for (size_t i = 1; i < values.size(); ++i)
+	{
+		const centroid& next = values[i];
+		if (weightSoFar + current.weight + next.weight <= limit)
+		{
+			current.weight += next.weight;
+			current.mean += (next.mean - current.mean) * next.weight / current.weight;
+		}
+		else
+		{
+			weightSoFar += current.weight;
+			out.push_back(current);
+			limit = total * ScaleQ(ScaleK(weightSoFar / total, compression) + 1.0, compression);
+			current = next;
+		}
+	}
+	out.push_back(current);
+}
+
+// interpolation between the centroid centers, the extremes bound the tails
+double statisticTDigest::Quantile(double q) const
+{
+	std::vector<centroid> scratch;
+	const std::vector<centroid>& centroids = Merged(scratch);
+	const double count = GetCount();
+	if (centroids.empty())
+		return 0.0;
+	if (q <= 0.0)
+		return m_min;
+	if (q >= 1.0)
+		return m_max;
+
+	const double target = q * count;
+	const centroid& first = centroids.front();
+	const centroid& last = centroids.back();
+
+	if (target < first.weight / 2.0)
+	{
+		if (first.weight == 1.0)
+			return m_min;
+		return m_min + (first.mean - m_min) * target / (first.weight / 2.0);
+	}
+	if (target > count - last.weight / 2.0)
+	{
+		if (last.weight == 1.0)
+			return m_max;
+		return m_max - (m_max - last.mean) * (count - target) / (last.weight / 2.0);
+	}
+
+	double center = first.weight / 2.0;
+	for (size_t i = 0; i + 1 < centroids.size(); ++i)
+	{
+		const centroid& a = centroids[i];
+		const centroid& b = centroids[i + 1];
+		const double step = (a.weight + b.weight) / 2.0;
+		if (target <= center + step)
+		{
+			// singletons are exact values
+			if (a.weight == 1.0 && target - center < 0.5)
+				return a.mean;
+			if (b.weight == 1.0 && center + step - target <= 0.5)
+				return b.mean;
+			return a.mean + (b.mean - a.mean) * (target - center) / step;
+		}
+		center += step;
+	}
+	return last.mean;
+}
+
+double statisticTDigest::Cdf(double value) const
+{
+	std::vector<centroid> scratch;
+	const std::vector<centroid>& centroids = Merged(scratch);
+	const double count = GetCount();
+	if (centroids.empty())
+		return 0.0;
+	if (value < m_min)
+		return 0.0;
+	if (value >= m_max)
+		return 1.0;
+
+	const centroid& first = centroids.front();
+	const centroid& last = centroids.back();
+	if (value < first.mean)
+	{
+		if (first.mean - m_min <= 0.0)
+			return 0.0;
+		return (value - m_min) / (first.mean - m_min) * first.weight / 2.0 / count;
+	}
+	if (value >= last.mean)
+	{
+		if (m_max - last.mean <= 0.0)
+			return 1.0;
+		return 1.0 - (m_max - value) / (m_max - last.mean) * last.weight / 2.0 / count;
+	}
+
+	double center = first.weight / 2.0;
+	for (size_t i = 0; i + 1 < centroids.size(); ++i)
+	{
+		const centroid& a = centroids[i];
+		const centroid& b = centroids[i + 1];
+		const double step = (a.weight + b.weight) / 2.0;
+		if (value < b.mean)
+		{
+			if (b.mean - a.mean <= 0.0)
+				return (center + step) / count;
+			return (center + step * (value - a.mean) / (b.mean - a.mean)) / count;
+		}
+		center += step;
+	}
+	return 1.0;
+}
+
+// snapshot: the buffer is merged first, only the centroids are saved
+void statisticTDigest::SaveState(statisticSnapshotWriter& writer) const
+{
+	std::vector<centroid> scratch;
+	const std::vector<centroid>& centroids = Merged(scratch);
+	writer.Put(m_compression);
+	writer.Put(m_min);
+	writer.Put(m_max);
+	writer.Put(GetCount());
+	writer.PutArray(centroids.empty() ? 0 : &centroids[0], centroids.size());
+}
+
+bool statisticTDigest::LoadState(statisticSnapshotReader& reader)
+{
+	double compression = 0, min = 0, max = 0, count = 0;
+	if (!reader.Get(compression) || !reader.Get(min) || !reader.Get(max) || !reader.Get(count))
+		return false;
+	if (!(compression >= 10.0 && compression <= 1e6) || !(count >= 0.0))
+		return reader.Fail();
+
+	statisticTDigest state(compression);
+	if (!reader.GetArray(state.m_centroids))
+		return false;
+	double weight = 0.0;
+	for (size_t i = 0; i < state.m_centroids.size(); ++i)
+	{
+		if (!(state.m_centroids[i].weight > 0.0) || (i && state.m_centroids[i].mean < state.m_centroids[i - 1].mean))
+			return reader.Fail();
+		weight += state.m_centroids[i].weight;
+	}
+	// the count is the weight of the centroids (up to the rounding of the sum)
+	if (fabs(weight - count) > 1e-9 * (count > 1.0 ? count : 1.0))
+		return reader.Fail();
+	state.m_min = min;
+	state.m_max = max;
+	state.m_count = count;
+
+	*this = state;
+	return true;
+}
+//
+}
+//
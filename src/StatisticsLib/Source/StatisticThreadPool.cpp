@@ -0,0 +1,119 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+//
+#include "StatisticThreadPool.h"
+//
+//
+namespace NStatisticEvaluations
+{
+statisticThreadPool::statisticThreadPool(unsigned threads)
+	: m_task(0), m_context(0), m_count(0), m_next(0), m_generation(0), m_busy(0), m_stop(false)
+{
+	if (threads == 0)
+	{
+		const unsigned hardware = std::thread::hardware_concurrency();
+		threads = hardware > 1 ? hardware - 1 : 0;
+	}
+
+	m_threads.reserve(threads);
+	for (unsigned i = 0; i < threads; ++i)
+		m_threads.push_back(std::thread(&statisticThreadPool::WorkerLoop, this));
+}
+
+statisticThreadPool::~statisticThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+
+	for (size_t i = 0; i < m_threads.size(); ++i)
+		m_threads[i].join();
+}
+
+statisticThreadPool& statisticThreadPool::Instance()
+{
+	static statisticThreadPool pool;
+	return pool;
+}
+
+void statisticThreadPool::ParallelFor(size_t count, void (*task)(void*, size_t), void* context)
+{
+	if (count == 0)
+		return;
+	if (m_threads.empty() || count == 1)
+	{
+		for (size_t i = 0; i < count; ++i)
+			task(context, i);
+		return;
+	}
+
+	std::lock_guard<std::mutex> run(m_runMutex);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = task;
+		m_context = context;
+		m_count = count;
+		m_next.store(0);
+		m_busy = static_cast<unsigned>(m_threads.size());
+		++m_generation;
+	}
+	m_wake.notify_all();
+
+	// the calling thread takes part in the job
+	Work();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (m_busy != 0)
+		m_done.wait(lock);
+}
+
+void statisticThreadPool::WorkerLoop()
+{
+	unsigned seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (!m_stop && m_generation == seen)
+				m_wake.wait(lock);
+			if (m_stop)
+				return;
+			seen = m_generation;
+		}
+
+		Work();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_busy == 0)
+			m_done.notify_all();
+	}
+}
+
+void statisticThreadPool::Work()
+{
+	for (size_t i = m_next.fetch_add(1); i < m_count; i = m_next.fetch_add(1))
+		m_task(m_context, i);
+}
+//
+}
+//
@@ -0,0 +1,283 @@
+/*
+ *
+ * Copyright (C) 2013 Kirill Yudenok, Ph.D. student <kirill.yudenok@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+/**
+*
+*   StatisticBenchmark.cpp
+*
+*   Micro and macro benchmarks of the evaluations, events ingestion and moving
+*   averages for int, float and double over sizes from L1 resident arrays to
+*   arrays larger than the last level cache. The results are printed as JSON:
+*
+*      StatisticBenchmark [--quick] [--filter <name part>] [--out <file.json>]
+*
+*/
+#include "Statistic.h"
+#include "MovingAverage.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace NStatistic;
+using namespace NStatisticAlg;
+
+using namespace std;
+
+namespace
+{
+struct benchmarkResult
+{
+   string name;
+   const char* type;
+   size_t elements;
+   size_t elementSize;
+   unsigned long long iterations;
+   double nsPerIteration;              // best iteration
+};
+
+struct benchmarkOptions
+{
+   benchmarkOptions() : minTimeNs(200000000LL), filter(), out() {}
+
+   long long minTimeNs;                // measuring time of one benchmark
+   string filter;
+   string out;
+};
+
+// results of the measured code go here, so the code is not optimized away
+volatile double g_sink;
+
+template <class T> const char* TypeName();
+template <> const char* TypeName<int>() { return "int"; }
+template <> const char* TypeName<float>() { return "float"; }
+template <> const char* TypeName<double>() { return "double"; }
+
+long long NowNs()
+{
+   return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// runs f() in batches until minTimeNs is spent, keeps the fastest batch
+template <class F>
+void Measure(const benchmarkOptions& options, vector<benchmarkResult>& results, const string& name,
+   const char* type, size_t elements, size_t elementSize, F f)
+{
+   if (!options.filter.empty() && name.find(options.filter) == string::npos)
+      return;
+
+   // warm up: page faults, caches, kernel dispatch
+   f();
+
+   unsigned long long batch = 1;
+   unsigned long long iterations = 0;
+   double best = 1e300;
+   const long long start = NowNs();
+   for (;;)
+   {
+      const long long batchStart = NowNs();
+      for (unsigned long long i = 0; i < batch; ++i)
+         f();
+      const long long batchTime = NowNs() - batchStart;
+      iterations += batch;
+
+      const double perIteration = (double)batchTime / batch;
+      best = perIteration < best ? perIteration : best;
+      if (NowNs() - start >= options.minTimeNs)
+         break;
+      // batches of about a millisecond hide the clock overhead
+      if (batchTime < 1000000)
+         batch *= 2;
+   }
+
+   benchmarkResult result = {name, type, elements, elementSize, iterations, best};
+   results.push_back(result);
+   fprintf(stderr, "%-28s %-7s %10u  %9.3f ns/element\n", name.c_str(), type, (unsigned)elements, best / elements);
+}
+
+template <class T>
+vector<T> MakeData(size_t size)
+{
+   vector<T> data(size);
+   unsigned state = 12345;
+   for (size_t i = 0; i < size; ++i)
+   {
+      state = state * 1103515245 + 12345;
+      data[i] = static_cast<T>((state >> 16) % 2000) - static_cast<T>(1000);
+   }
+   return data;
+}
+
+template <class T>
+void RunType(const benchmarkOptions& options, const vector<size_t>& sizes, vector<benchmarkResult>& results)
+{
+   const char* type = TypeName<T>();
+   for (size_t s = 0; s < sizes.size(); ++s)
+   {
+      const size_t size = sizes[s];
+      const vector<T> data = MakeData<T>(size);
+      const T* values = &data[0];
+      const int count = static_cast<int>(size);
+
+      statistic<T> pack;
+      statisticEvaluations<T>* evaluations = pack.GetStatEvaluations();
+      evaluations->SetMean(static_cast<T>(1));
+
+      // array evaluations
+      Measure(options, results, "Sum", type, size, sizeof(T), [&]() { g_sink = (double)evaluations->Sum(values, count); });
+      Measure(options, results, "Min", type, size, sizeof(T), [&]() { g_sink = (double)evaluations->Min(values, count); });
+      Measure(options, results, "Max", type, size, sizeof(T), [&]() { g_sink = (double)evaluations->Max(values, count); });
+      Measure(options, results, "MeanValue", type, size, sizeof(T),
+         [&]() { g_sink = (double)evaluations->MeanValue(values, count); });
+      Measure(options, results, "Dispersion", type, size, sizeof(T),
+         [&]() { g_sink = (double)evaluations->Dispersion(values, count); });
+      Measure(options, results, "StdDeviation", type, size, sizeof(T),
+         [&]() { g_sink = evaluations->StdDeviation(values, count); });
+      Measure(options, results, "MathExpectation", type, size, sizeof(T),
+         [&]() { g_sink = (double)evaluations->MathExpectation(values, count); });
+      Measure(options, results, "Summarize", type, size, sizeof(T),
+         [&]() { g_sink = evaluations->Summarize(values, count).std_deviation; });
+
+      // vector evaluations
+      Measure(options, results, "VectorSum", type, size, sizeof(T), [&]() { g_sink = (double)evaluations->VectorSum(data); });
+      Measure(options, results, "VectorMinValue", type, size, sizeof(T),
+         [&]() { g_sink = (double)evaluations->VectorMinValue(data); });
+      Measure(options, results, "VectorMaxValue", type, size, sizeof(T),
+         [&]() { g_sink = (double)evaluations->VectorMaxValue(data); });
+      Measure(options, results, "VectorMeanValue", type, size, sizeof(T),
+         [&]() { g_sink = (double)evaluations->VectorMeanValue(data); });
+      Measure(options, results, "VectorDispersion", type, size, sizeof(T),
+         [&]() { g_sink = (double)evaluations->VectorDispersion(data); });
+      Measure(options, results, "VectorStdDeviation", type, size, sizeof(T),
+         [&]() { g_sink = evaluations->VectorStdDeviation(data); });
+      Measure(options, results, "VectorMathExpectation", type, size, sizeof(T),
+         [&]() { g_sink = (double)evaluations->VectorMathExpectation(data); });
+      Measure(options, results, "VectorSummarize", type, size, sizeof(T),
+         [&]() { g_sink = evaluations->VectorSummarize(data).std_deviation; });
+      Measure(options, results, "VectorMedian", type, size, sizeof(T),
+         [&]() { g_sink = evaluations->VectorMedian(data); });
+
+      // events ingestion, the history is cleared between the iterations
+      statisticEvents<T>* events = pack.GetStatEvents();
+      events->SetTimestampMode(eTimestampNone);
+      Measure(options, results, "StatisticEvent", type, size, sizeof(T), [&]()
+      {
+         events->ResetAllEventsData();
+         for (size_t i = 0; i < size; ++i)
+            events->StatisticEvent(values[i]);
+         g_sink = (double)events->GetCurrStatParameter();
+      });
+      Measure(options, results, "StatisticEvents", type, size, sizeof(T), [&]()
+      {
+         events->ResetAllEventsData();
+         events->StatisticEvents(values, size);
+         g_sink = (double)events->GetCurrStatParameter();
+      });
+      events->SetOnlineMode(true, false);
+      Measure(options, results, "StatisticEventOnline", type, size, sizeof(T), [&]()
+      {
+         for (size_t i = 0; i < size; ++i)
+            events->StatisticEvent(values[i]);
+         g_sink = events->GetOnlineStatistics().GetMean();
+      });
+      events->ResetAllEventsData();
+
+      // moving averages
+      CBasicMovingAverage<T> average(32);
+      vector<typename CBasicMovingAverage<T>::result_type> smoothed(size);
+      Measure(options, results, "MovingAverageNext", type, size, sizeof(T), [&]()
+      {
+         typename CBasicMovingAverage<T>::result_type last = 0;
+         for (size_t i = 0; i < size; ++i)
+            last = average.Next(values[i]);
+         g_sink = (double)last;
+      });
+      Measure(options, results, "MovingAverageApply", type, size, sizeof(T), [&]()
+      {
+         average.Apply(statisticSpan<const T>(data), statisticSpan<typename CBasicMovingAverage<T>::result_type>(smoothed));
+         g_sink = (double)smoothed[size - 1];
+      });
+   }
+}
+
+void WriteJson(FILE* out, const vector<benchmarkResult>& results)
+{
+   fprintf(out, "{\n  \"context\": {\"instruction_set\": %d, \"supported_instruction_set\": %d},\n",
+      (int)NStatisticKernels::ActiveInstructionSet(), (int)NStatisticKernels::SupportedInstructionSet());
+   fprintf(out, "  \"benchmarks\": [\n");
+   for (size_t i = 0; i < results.size(); ++i)
+   {
+      const benchmarkResult& r = results[i];
+      const double bytes = (double)r.elements * r.elementSize;
+      fprintf(out, "    {\"name\": \"%s\", \"type\": \"%s\", \"elements\": %u, \"bytes\": %.0f, \"iterations\": %llu, "
+         "\"ns_per_iteration\": %.1f, \"ns_per_element\": %.4f, \"gb_per_s\": %.3f}%s\n",
+         r.name.c_str(), r.type, (unsigned)r.elements, bytes, r.iterations,
+         r.nsPerIteration, r.nsPerIteration / r.elements, bytes / r.nsPerIteration, i + 1 < results.size() ? "," : "");
+   }
+   fprintf(out, "  ]\n}\n");
+}
+//
+}
+
+int main(int argc, char** argv)
+{
+   benchmarkOptions options;
+   // 4 KB (L1) to 256 MB of doubles (beyond the last level cache)
+   size_t sizes[] = {1 << 10, 1 << 14, 1 << 17, 1 << 20, 1 << 25};
+   size_t sizesCount = sizeof(sizes) / sizeof(sizes[0]);
+
+   for (int i = 1; i < argc; ++i)
+   {
+      if (!strcmp(argv[i], "--quick"))
+      {
+         options.minTimeNs = 20000000LL;
+         sizesCount = 4;
+      }
+      else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+         options.filter = argv[++i];
+      else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+         options.out = argv[++i];
+      else
+      {
+         fprintf(stderr, "usage: %s [--quick] [--filter <name part>] [--out <file.json>]\n", argv[0]);
+         return 1;
+      }
+   }
+
+   const vector<size_t> sizesUsed(sizes, sizes + sizesCount);
+   vector<benchmarkResult> results;
+   RunType<int>(options, sizesUsed, results);
+   RunType<float>(options, sizesUsed, results);
+   RunType<double>(options, sizesUsed, results);
+
+   FILE* out = options.out.empty() ? stdout : fopen(options.out.c_str(), "w");
+   if (!out)
+   {
+      fprintf(stderr, "cannot open %s\n", options.out.c_str());
+      return 1;
+   }
+   WriteJson(out, results);
+   if (out != stdout)
+      fclose(out);
+
+   return 0;
+}
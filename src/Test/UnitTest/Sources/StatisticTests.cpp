@@ -24,8 +24,22 @@
 */
 #include <UnitTest/UnitTest++.h>
 #include "Statistic.h"
+#include "StatisticConcurrentEvents.h"
+#include "StatisticTDigest.h"
+#include "StatisticHistogram.h"
+#include "MovingAverage.h"
+#include "MovingMinMax.h"
+#include "StatisticReader.h"
+#include "StatisticRegistry.h"
+
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <limits>
 
 using namespace NStatistic;
+using namespace NStatisticAlg;
 
 using namespace std;
 
@@ -98,7 +112,7 @@ SUITE(UAmgStatistics)
    {
       statistic<int> pack_int;
       int i_data[n] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
-      const int i_mean = 5;	//  int'a = 5.5
+      const int i_mean = 5;	// округление int'a = 5.5
 
       int mean_value = pack_int.GetStatEvaluations()->MeanValue(i_data, n);
       CHECK(mean_value == i_mean);
@@ -301,7 +315,7 @@ SUITE(UAmgStatistics)
    {
       statistic<int> pack_int;
       int i_data[n] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
-      const int i_mathExpectation = 5;	//  int'a = 5.5
+      const int i_mathExpectation = 5;	// округление int'a = 5.5
 
       int mathExpectation = pack_int.GetStatEvaluations()->MeanValue(i_data, n);
 
@@ -405,4 +419,1657 @@ SUITE(UAmgStatistics)
 
       CHECK_CLOSE(f_stdDeviation, stdDeviation_value, 0.01f);
    }
+
+   // Summarize TESTS
+   TEST(StatisticSummarizeIntTest)
+   {
+      statistic<int> pack_int;
+      int i_data[n] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+      statisticSummary<int> summary = pack_int.GetStatEvaluations()->Summarize(i_data, n);
+
+      CHECK(summary.count == n);
+      CHECK(summary.sum == 55);
+      CHECK(summary.min == 1);
+      CHECK(summary.max == 10);
+      CHECK_CLOSE(5.5, summary.mean, 1e-9);
+      CHECK_CLOSE(8.25, summary.dispersion, 1e-9);
+      CHECK_CLOSE(2.87228, summary.std_deviation, 1e-5);
+      CHECK(pack_int.GetStatEvaluations()->GetSum() == 55);
+   }
+   TEST(StatisticVectorSummarizeFloatTest)
+   {
+      statistic<float> pack_float;
+      float f_data[n] = {1.1f, 2.2f, 3.3f, 4.4f, 5.5f, 6.6f, 7.7f, 8.8f, 9.9f, 10.10f};
+
+      for (int i = 0; i < n; ++i)
+         pack_float.GetStatEvents()->StatisticEvent(f_data[i]);
+
+      statisticSummary<float> summary = pack_float.GetStatEvaluations()->VectorSummarize(pack_float.GetStatEvents()->GetParamsQueue());
+
+      CHECK_CLOSE(59.6f, summary.sum, 0.001f);
+      CHECK_CLOSE(1.1f, summary.min, 0.001f);
+      CHECK_CLOSE(10.1f, summary.max, 0.001f);
+      CHECK_CLOSE(5.96, summary.mean, 0.001);
+      CHECK_CLOSE(9.1644, summary.dispersion, 0.001);
+   }
+   TEST(StatisticSummarizeEmptyTest)
+   {
+      statistic<double> pack_double;
+      std::vector<double> empty;
+
+      statisticSummary<double> summary = pack_double.GetStatEvaluations()->VectorSummarize(empty);
+
+      CHECK(summary.count == 0);
+      CHECK(summary.sum == 0.0);
+   }
+
+   // Span/iterator TESTS
+   TEST(StatisticParamsViewTest)
+   {
+      statistic<int> pack_int;
+      int i_data[n] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+      for (int i = 0; i < 5; ++i)
+         pack_int.GetStatEvents()->StatisticEvent(i_data[i]);
+
+      statisticSpan<const int> view = pack_int.GetStatEvents()->GetParamsView();
+
+      CHECK(view.Size() == 5);
+      CHECK(view[4] == 5);
+      CHECK(pack_int.GetStatEvaluations()->VectorSum(view) == 15);
+      CHECK(pack_int.GetStatEvaluations()->VectorMinValue(view) == 1);
+      CHECK(pack_int.GetStatEvaluations()->VectorMaxValue(view) == 5);
+   }
+   TEST(StatisticIteratorRangeTest)
+   {
+      statistic<double> pack_double;
+      std::vector<double> d_data;
+      for (int i = 1; i <= n; ++i)
+         d_data.push_back(i);
+
+      double mean_value = pack_double.GetStatEvaluations()->VectorMeanValue(d_data.begin(), d_data.end());
+      double dispersion_value = pack_double.GetStatEvaluations()->VectorDispersion(d_data.begin(), d_data.end());
+
+      CHECK_CLOSE(5.5, mean_value, 1e-9);
+      CHECK_CLOSE(8.25, dispersion_value, 1e-9);
+   }
+   TEST(StatisticEmptyViewTest)
+   {
+      statistic<int> pack_int;
+      pack_int.GetStatEvaluations()->SetMin(7);
+
+      int min_value = pack_int.GetStatEvaluations()->VectorMinValue(pack_int.GetStatEvents()->GetParamsView());
+
+      CHECK(min_value == 7);
+   }
+
+   // Kernel TESTS
+   TEST(StatisticKernelsInstructionSetsTest)
+   {
+      const int size = 1003;
+      std::vector<int> i_data(size);
+      std::vector<long long> l_data(size);
+      std::vector<double> d_data(size);
+      for (int i = 0; i < size; ++i)
+      {
+         i_data[i] = (i * 7919) % 1000 - 500;
+         l_data[i] = (long long)i_data[i] * 100000;
+         d_data[i] = i_data[i] * 0.25;
+      }
+      i_data[777] = -9999;
+      d_data[12] = 9999.5;
+
+      int i_sum = 0;
+      for (int i = 0; i < size; ++i)
+         i_sum += i_data[i];
+
+      const NStatisticKernels::EInstructionSet supported = NStatisticKernels::SupportedInstructionSet();
+      for (int set = NStatisticKernels::eInstructionSetScalar; set <= supported; ++set)
+      {
+         NStatisticKernels::SetInstructionSet(static_cast<NStatisticKernels::EInstructionSet>(set));
+         CHECK(NStatisticKernels::ActiveInstructionSet() == set);
+
+         statistic<int> pack_int;
+         statistic<long long> pack_long;
+         statistic<double> pack_double;
+
+         CHECK(pack_int.GetStatEvaluations()->VectorSum(i_data) == i_sum);
+         CHECK(pack_int.GetStatEvaluations()->VectorMinValue(i_data) == -9999);
+         CHECK(pack_int.GetStatEvaluations()->VectorMaxValue(i_data) == 499);
+         CHECK(pack_long.GetStatEvaluations()->VectorMinValue(l_data) == -50000000);
+         CHECK(pack_long.GetStatEvaluations()->VectorMaxValue(l_data) == 49900000);
+         CHECK(pack_double.GetStatEvaluations()->VectorMaxValue(d_data) == 9999.5);
+
+         pack_double.GetStatEvaluations()->SetMean(1.0);
+         double expected = 0;
+         for (int i = 0; i < size; ++i)
+            expected += (d_data[i] - 1.0) * (d_data[i] - 1.0);
+         CHECK_CLOSE(expected / size, pack_double.GetStatEvaluations()->VectorDispersion(d_data), 1e-6);
+      }
+      NStatisticKernels::SetInstructionSet(supported);
+   }
+
+   // Online mode TESTS
+   TEST(StatisticOnlineModeTest)
+   {
+      statistic<float> pack_float;
+      float f_data[n] = {1.1f, 2.2f, 3.3f, 4.4f, 5.5f, 6.6f, 7.7f, 8.8f, 9.9f, 10.10f};
+
+      pack_float.GetStatEvents()->SetOnlineMode(true, false);
+      for (int i = 0; i < n; ++i)
+         pack_float.GetStatEvents()->StatisticEvent(f_data[i]);
+
+      const statisticAccumulator<float>& online = pack_float.GetStatEvents()->GetOnlineStatistics();
+
+      CHECK(pack_float.GetStatEvents()->GetParamsView().Empty());
+      CHECK(online.GetCount() == n);
+      CHECK_CLOSE(59.6f, online.GetSum(), 0.001f);
+      CHECK_CLOSE(1.1f, online.GetMin(), 0.001f);
+      CHECK_CLOSE(10.1f, online.GetMax(), 0.001f);
+      CHECK_CLOSE(5.96, online.GetMean(), 0.0001);
+      CHECK_CLOSE(9.1644, online.GetDispersion(), 0.0001);
+      CHECK_CLOSE(3.02727, online.GetStdDeviation(), 0.0001);
+
+      pack_float.GetStatEvents()->ResetAllEventsData();
+      CHECK(pack_float.GetStatEvents()->GetOnlineStatistics().GetCount() == 0);
+   }
+
+   // Bounded history TESTS
+   TEST(StatisticHistoryCapacityTest)
+   {
+      statistic<int> pack_int;
+      int i_data[n] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+      pack_int.GetStatEvents()->SetHistoryCapacity(4);
+      for (int i = 0; i < 7; ++i)
+         pack_int.GetStatEvents()->StatisticEvent(i_data[i]);
+
+      // last 4 events: 4, 5, 6, 7
+      std::vector<int> queue = pack_int.GetStatEvents()->GetParamsQueue();
+      CHECK(queue.size() == 4);
+      CHECK(queue[0] == 4 && queue[3] == 7);
+
+      statisticRingView<int> history = pack_int.GetStatEvents()->GetHistoryView();
+      CHECK(history.Size() == 4);
+      CHECK(history.first[0] == 4);
+      CHECK(history.second.Size() == 3);
+
+      CHECK(pack_int.GetStatEvaluations()->VectorSum(pack_int.GetStatEvents()->GetParamsView()) == 22);
+      CHECK(pack_int.GetStatEvaluations()->VectorMinValue(pack_int.GetStatEvents()->GetParamsView()) == 4);
+      CHECK(pack_int.GetStatEvents()->EventsCount() == 7);
+
+      pack_int.GetStatEvents()->ResetAllEventsData();
+      CHECK(pack_int.GetStatEvents()->GetParamsView().Empty());
+      CHECK(pack_int.GetStatEvents()->GetHistoryCapacity() == 4);
+   }
+   TEST(StatisticRingBufferTest)
+   {
+      statisticRingBuffer<double> ring(3);
+      ring.Push(1.0);
+      ring.Push(2.0);
+
+      CHECK(ring.View().first.Size() == 2);
+      CHECK(ring.View().second.Empty());
+
+      ring.Push(3.0);
+      ring.Push(4.0);
+
+      CHECK(ring.Full());
+      CHECK(ring.Front() == 2.0);
+      CHECK(ring.Back() == 4.0);
+      CHECK(ring[1] == 3.0);
+   }
+
+   // Concurrent events TESTS
+   static void RecordEvents(statisticConcurrentEvents<long long>* events, int count)
+   {
+      for (int i = 1; i <= count; ++i)
+         events->StatisticEvent(i);
+   }
+   TEST(StatisticConcurrentEventsTest)
+   {
+      // 2 shards for 4 threads: two threads write through the overflow path
+      statisticConcurrentEvents<long long> events(2);
+      const int count = 20000;
+      std::vector<std::thread> threads;
+      for (int t = 0; t < 4; ++t)
+         threads.push_back(std::thread(RecordEvents, &events, count));
+
+      // concurrent reader
+      for (int i = 0; i < 100; ++i)
+         CHECK(events.GetStatistics().GetCount() <= 4 * count);
+
+      for (size_t t = 0; t < threads.size(); ++t)
+         threads[t].join();
+
+      statisticAccumulator<long long> total = events.GetStatistics();
+      CHECK(total.GetCount() == 4 * count);
+      CHECK(total.GetSum() == 4LL * count * (count + 1) / 2);
+      CHECK(total.GetMin() == 1);
+      CHECK(total.GetMax() == count);
+      CHECK_CLOSE((count + 1) / 2.0, total.GetMean(), 1e-6);
+      CHECK_CLOSE((double(count) * count - 1) / 12.0, total.GetDispersion(), 1e-3);
+   }
+   TEST(StatisticConcurrentEventsShardReleaseTest)
+   {
+      // 2 shards, 12 threads in waves of 2: the shards of finished threads are reused
+      statisticConcurrentEvents<long long> events(2);
+      const int count = 1000;
+      for (int wave = 0; wave < 6; ++wave)
+      {
+         std::thread first(RecordEvents, &events, count);
+         std::thread second(RecordEvents, &events, count);
+         first.join();
+         second.join();
+         CHECK_EQUAL(0, (int)events.ClaimedShardsCount());
+      }
+      CHECK_EQUAL(0LL, events.OverflowEventsCount());
+      CHECK(events.EventsCount() == 12LL * count);
+      CHECK(events.GetStatistics().GetSum() == 12LL * count * (count + 1) / 2);
+
+      // the claims of a destroyed instance are not released through it
+      std::thread worker([]()
+      {
+         statisticConcurrentEvents<long long>* scoped = new statisticConcurrentEvents<long long>(1);
+         RecordEvents(scoped, 10);
+         delete scoped;
+         statisticConcurrentEvents<long long> next(1);
+         RecordEvents(&next, 10);
+      });
+      worker.join();
+
+      // the calling thread keeps its shard
+      RecordEvents(&events, count);
+      CHECK_EQUAL(1, (int)events.ClaimedShardsCount());
+      CHECK_EQUAL(0LL, events.OverflowEventsCount());
+   }
+   TEST(StatisticAccumulatorMergeTest)
+   {
+      statisticAccumulator<double> left, right, all;
+      for (int i = 1; i <= n; ++i)
+      {
+         (i <= 3 ? left : right).Add(i * 1.5);
+         all.Add(i * 1.5);
+      }
+      left.Merge(right);
+
+      CHECK(left.GetCount() == all.GetCount());
+      CHECK_CLOSE(all.GetMean(), left.GetMean(), 1e-12);
+      CHECK_CLOSE(all.GetM2(), left.GetM2(), 1e-9);
+      CHECK(left.GetMin() == 1.5 && left.GetMax() == 15.0);
+   }
+
+   // Parallel evaluation TESTS
+   TEST(StatisticParallelEvaluationTest)
+   {
+      const int size = 1000003;
+      std::vector<int> i_data(size);
+      std::vector<double> d_data(size);
+      for (int i = 0; i < size; ++i)
+      {
+         i_data[i] = (i % 10007) * 7919 % 10007 - 5000;
+         d_data[i] = i_data[i] * 0.001 + 1000.0;
+      }
+      i_data[123456] = 99999;
+
+      statisticThreadPool pool(3);
+      statistic<int> serial_int, parallel_int;
+      statistic<double> serial_double, parallel_double;
+      parallel_int.GetStatEvaluations()->SetParallelEvaluation(1000, &pool);
+      parallel_double.GetStatEvaluations()->SetParallelEvaluation(1000, &pool);
+
+      CHECK(parallel_int.GetStatEvaluations()->VectorSum(i_data) == serial_int.GetStatEvaluations()->VectorSum(i_data));
+      CHECK(parallel_int.GetStatEvaluations()->VectorMaxValue(i_data) == 99999);
+      CHECK(parallel_int.GetStatEvaluations()->VectorMinValue(i_data) == serial_int.GetStatEvaluations()->VectorMinValue(i_data));
+
+      statisticSummary<double> serial = serial_double.GetStatEvaluations()->VectorSummarize(d_data);
+      statisticSummary<double> parallel = parallel_double.GetStatEvaluations()->VectorSummarize(d_data);
+
+      CHECK(parallel.count == size);
+      CHECK(parallel.min == serial.min && parallel.max == serial.max);
+      CHECK_CLOSE(serial.sum, parallel.sum, 1e-3);
+      CHECK_CLOSE(serial.mean, parallel.mean, 1e-9);
+      CHECK_CLOSE(serial.dispersion, parallel.dispersion, 1e-9);
+
+      parallel_double.GetStatEvaluations()->SetMean(1000.0);
+      serial_double.GetStatEvaluations()->SetMean(1000.0);
+      serial_double.GetStatEvaluations()->SetDispersion(0.0);
+      parallel_double.GetStatEvaluations()->SetDispersion(0.0);
+      CHECK_CLOSE(serial_double.GetStatEvaluations()->VectorDispersion(d_data),
+                  parallel_double.GetStatEvaluations()->VectorDispersion(d_data), 1e-9);
+   }
+
+   TEST(StatisticEventTimesTest)
+   {
+      statisticEvents<int> events;
+      events.SetTimestampMode(eTimestampEvents);
+      CHECK_EQUAL(0, (int)events.EventTime());
+
+      int batch[] = {1, 2, 3, 4};
+      events.StatisticEvent(7);
+      events.StatisticEvents(batch, 4);
+
+      std::vector<long long> times = events.GetTimesQueue();
+      CHECK_EQUAL(5, (int)times.size());
+      CHECK_EQUAL(5, (int)events.GetTimesView().Size());
+      CHECK(times[0] > 0 && times[0] <= times[1]);
+      // one clock read per batch
+      CHECK(times[1] == times[4]);
+      CHECK(events.EventTime() == times[4]);
+      CHECK(events.FirstEventTime() == times[0]);
+      CHECK(events.EventsSpeed() > 0);
+      CHECK_EQUAL(4, events.GetCurrStatParameter());
+
+      events.SetHistoryCapacity(3);
+      times = events.GetTimesQueue();
+      CHECK_EQUAL(3, (int)times.size());
+      CHECK(times[2] == events.EventTime());
+
+      events.ResetAllEventsData();
+      CHECK_EQUAL(0, (int)events.GetTimesView().Size());
+      CHECK_EQUAL(0, (int)events.EventTime());
+      CHECK_EQUAL(0.0, events.EventsSpeed());
+
+      // the times are switched on over a wrapped history and stay parallel to it
+      statisticEvents<int> bounded;
+      bounded.SetHistoryCapacity(4);
+      for (int i = 1; i <= 6; ++i)
+         bounded.StatisticEvent(i);
+      bounded.SetTimestampMode(eTimestampEvents);
+      bounded.StatisticEvent(7);
+      CHECK_EQUAL(4, (int)bounded.GetTimesView().Size());
+      for (size_t i = 0; i < bounded.GetParamsView().Size(); ++i)
+         CHECK_EQUAL(bounded.GetParamsView()[i] == 7, bounded.GetTimesView()[i] != 0);
+      const vector<int> values = bounded.GetParamsQueue();
+      times = bounded.GetTimesQueue();
+      CHECK_EQUAL(4, values.front());
+      CHECK_EQUAL(7, values.back());
+      CHECK_EQUAL(0LL, times[2]);
+      CHECK(times[3] == bounded.EventTime());
+   }
+
+   TEST(StatisticClockTest)
+   {
+      const long long steady0 = SteadyClockNs();
+      const long long tsc0 = statisticTscClock::NowNs();
+      const long long tsc1 = statisticTscClock::NowNs();
+      const long long steady1 = SteadyClockNs();
+      CHECK(tsc1 >= tsc0);
+      // both clocks share the steady_clock scale
+      CHECK(tsc0 > steady0 - 1000000 && tsc1 < steady1 + 1000000);
+
+      statisticEvents<double> events;
+      events.SetTimestampMode(eTimestampLast, eClockTsc);
+      events.StatisticEvent(1.0);
+      CHECK(events.EventTime() > 0);
+      CHECK_EQUAL(0, (int)events.GetTimesView().Size());
+   }
+
+   // Events rate TESTS
+   TEST(StatisticRateMeterTest)
+   {
+      const long long second = 1000000000LL;
+      const long long start = 1000 * second;
+      statisticRateMeter meter(start);
+
+      // 100 events/s during the first tick interval
+      for (int s = 0; s < 5; ++s)
+         for (int i = 0; i < 100; ++i)
+            meter.Mark(1, start + s * second + i * (second / 100));
+      CHECK_EQUAL(500, (int)meter.Count());
+      CHECK_EQUAL(100.0, meter.InstantRate(start + 4 * second + second / 2));
+      CHECK_EQUAL(0.0, meter.InstantRate(start + 10 * second));
+      CHECK_CLOSE(100.0, meter.MeanRate(start + 5 * second), 1e-9);
+
+      // the first tick initializes all rates
+      CHECK_CLOSE(100.0, meter.OneMinuteRate(start + statisticRateMeter::c_tickInterval), 1e-9);
+      CHECK_CLOSE(100.0, meter.FifteenMinuteRate(start + statisticRateMeter::c_tickInterval), 1e-9);
+
+      // one minute without events
+      const long long idle = start + statisticRateMeter::c_tickInterval + 60 * second;
+      const double one = meter.OneMinuteRate(idle);
+      const double five = meter.FiveMinuteRate(idle);
+      const double fifteen = meter.FifteenMinuteRate(idle);
+      CHECK_CLOSE(100.0 * exp(-1.0), one, 1e-6);
+      CHECK(one < five && five < fifteen && fifteen < 100.0);
+   }
+
+   TEST(StatisticRateMeterConcurrentTest)
+   {
+      statisticEvents<int> events;
+      events.SetRateMeter(true);
+      const statisticRateMeter& meter = events.GetRateMeter();
+
+      std::atomic<bool> done(false);
+      double rates = 0;
+      std::thread monitor([&]()
+      {
+         while (!done.load())
+            rates += meter.OneMinuteRate() + meter.InstantRate();
+      });
+      for (int i = 0; i < 100000; ++i)
+         events.StatisticEvent(i);
+      done.store(true);
+      monitor.join();
+
+      CHECK_EQUAL(100000, (int)meter.Count());
+      CHECK(rates >= 0);
+      CHECK(events.EventsSpeed() >= 0);
+
+      events.ResetAllEventsData();
+      CHECK_EQUAL(0, (int)meter.Count());
+   }
+
+   // Time window TESTS
+   TEST(StatisticTimeWindowTest)
+   {
+      // 60 s window of 1 s buckets
+      statisticTimeWindow<int> window(60 * c_nsInSecond, 60);
+      CHECK_EQUAL(c_nsInSecond, window.GetBucketLength());
+
+      const long long start = 5000 * c_nsInSecond;
+      for (int s = 0; s < 120; ++s)
+         window.Add(s, start + s * c_nsInSecond + c_nsInSecond / 2);
+
+      const long long now = start + 119 * c_nsInSecond + c_nsInSecond / 2;
+      statisticAccumulator<int> all = window.GetStatistics(now);
+      CHECK_EQUAL(60, (int)all.GetCount());
+      CHECK_EQUAL(60, all.GetMin());
+      CHECK_EQUAL(119, all.GetMax());
+      CHECK_CLOSE(89.5, all.GetMean(), 1e-9);
+
+      statisticAccumulator<int> last10 = window.GetStatistics(now, 10 * c_nsInSecond);
+      CHECK_EQUAL(10, (int)last10.GetCount());
+      CHECK_EQUAL(110, last10.GetMin());
+      CHECK_CLOSE(sqrt(99.0 / 12.0), last10.GetStdDeviation(), 1e-9);
+
+      // values older than the window are ignored, idle time empties the window
+      window.Add(1000, start);
+      CHECK_EQUAL(119, window.GetStatistics(now).GetMax());
+      CHECK_EQUAL(0, (int)window.GetStatistics(now + 100 * c_nsInSecond).GetCount());
+   }
+
+   TEST(StatisticEventsTimeWindowTest)
+   {
+      statisticEvents<double> events;
+      events.SetTimestampMode(eTimestampNone);
+      const size_t window = events.AddTimeWindow(60 * c_nsInSecond, 60);
+
+      double batch[] = {1.0, 2.0, 3.0};
+      events.StatisticEvents(batch, 3);
+      events.StatisticEvent(6.0);
+
+      statisticAccumulator<double> stat = events.GetWindowStatistics(window);
+      CHECK_EQUAL(4, (int)stat.GetCount());
+      CHECK_EQUAL(3.0, stat.GetMean());
+      CHECK_EQUAL(6.0, stat.GetMax());
+
+      events.ResetAllEventsData();
+      CHECK_EQUAL(0, (int)events.GetWindowStatistics(window).GetCount());
+      CHECK_EQUAL(1, (int)events.TimeWindowsCount());
+   }
+
+   // Moving average TESTS
+   TEST(StatisticMovingAverageTest)
+   {
+      double d_data[10] = {1.234, 2.298, 4.355, 8.41, 10.54, 6.645, 11.36, 15.898, 12.999, 10.111};
+
+      // legacy functor
+      vector<double> smoothed;
+      for_each(d_data, d_data + 10, CMovingAverage(smoothed, 5));
+      CHECK_EQUAL(10, (int)smoothed.size());
+      CHECK_CLOSE(1.234, smoothed[0], 1e-12);
+      CHECK_CLOSE((1.234 + 2.298) / 2, smoothed[1], 1e-12);
+      CHECK_CLOSE((6.645 + 11.36 + 15.898 + 12.999 + 10.111) / 5, smoothed[9], 1e-12);
+
+      // batch apply into a preallocated output, continued in two parts
+      vector<double> applied(10);
+      CMovingAverage average(5);
+      average.Apply(statisticSpan<const double>(d_data, 3), statisticSpan<double>(&applied[0], 3));
+      average.Apply(statisticSpan<const double>(d_data + 3, 7), statisticSpan<double>(&applied[3], 7));
+      for (int i = 0; i < 10; ++i)
+         CHECK_CLOSE(smoothed[i], applied[i], 1e-12);
+      CHECK_CLOSE(smoothed[9], average.GetAverage(), 1e-12);
+
+      // compile time period
+      CBasicMovingAverage<float, 5> average5;
+      double last = 0;
+      for (int i = 0; i < 10; ++i)
+         last = average5.Next((float)d_data[i]);
+      CHECK_EQUAL(5, (int)average5.GetPeriod());
+      CHECK_CLOSE(smoothed[9], last, 1e-5);
+   }
+
+   TEST(StatisticMovingAverageLongSeriesTest)
+   {
+      const int size = 100000;
+      vector<int> i_data(size);
+      for (int i = 0; i < size; ++i)
+         i_data[i] = (i % 997) * 31 % 1000;
+
+      CBasicMovingAverage<int> batch(64), single(64);
+      vector<double> out(size);
+      batch.Apply(statisticSpan<const int>(i_data), statisticSpan<double>(out));
+
+      double window = 0;
+      for (int i = 0; i < size; ++i)
+      {
+         window += i_data[i] - (i >= 64 ? i_data[i - 64] : 0);
+         CHECK_CLOSE(single.Next(i_data[i]), out[i], 1e-9);
+         CHECK_CLOSE(window / (i < 64 ? i + 1 : 64), out[i], 1e-9);
+      }
+   }
+
+   TEST(StatisticWeightedMovingAverageTest)
+   {
+      const int size = 1000, period = 10;
+      vector<double> d_data(size);
+      for (int i = 0; i < size; ++i)
+         d_data[i] = sin(i * 0.1) * 100.0 + i * 0.01;
+
+      CWeightedMovingAverage<double> wma(period);
+      vector<double> out(size);
+      wma.Apply(statisticSpan<const double>(d_data), statisticSpan<double>(out));
+      for (int i = 0; i < size; ++i)
+      {
+         // direct evaluation over the window
+         const int count = i + 1 < period ? i + 1 : period;
+         double weighted = 0;
+         for (int k = 0; k < count; ++k)
+            weighted += (count - k) * d_data[i - k];
+         CHECK_CLOSE(weighted / (count * (count + 1) / 2), out[i], 1e-9);
+      }
+   }
+
+   TEST(StatisticMovingAveragesTest)
+   {
+      int i_data[8] = {2, 4, 6, 8, 10, 12, 14, 16};
+
+      CExponentialMovingAverage<int> ema(3);
+      CHECK_CLOSE(0.5, ema.GetAlpha(), 1e-12);
+      CHECK_CLOSE(2.0, ema.Next(2), 1e-12);
+      CHECK_CLOSE(3.0, ema.Next(4), 1e-12);
+      CHECK_CLOSE(4.5, ema.Next(6), 1e-12);
+
+      CCumulativeMovingAverage<int> cma;
+      vector<double> out(8);
+      cma.Apply(statisticSpan<const int>(i_data, 8), statisticSpan<double>(out));
+      CHECK_CLOSE(2.0, out[0], 1e-12);
+      CHECK_CLOSE(5.0, out[3], 1e-12);
+      CHECK_CLOSE(9.0, cma.GetAverage(), 1e-12);
+
+      // Hull moving average follows a linear trend without lag
+      CHullMovingAverage<int> hma(4);
+      CWeightedMovingAverage<int> half(2), full(4);
+      CWeightedMovingAverage<double> smooth(2);
+      for (int i = 0; i < 8; ++i)
+      {
+         const double expected = smooth.Next(2 * half.Next(i_data[i]) - full.Next(i_data[i]));
+         CHECK_CLOSE(expected, hma.Next(i_data[i]), 1e-12);
+      }
+      CHECK_CLOSE(16.0, hma.GetAverage(), 1e-12);
+   }
+
+   // Moving min/max TESTS
+   TEST(StatisticMovingMinMaxTest)
+   {
+      const int size = 5000, period = 37;
+      vector<int> i_data(size);
+      for (int i = 0; i < size; ++i)
+         i_data[i] = (i % 101) * 67 % 101 - (i / 500) * 3;
+
+      CMovingMinMax<int> window(period);
+      vector<int> out_min(size), out_max(size);
+      window.Apply(statisticSpan<const int>(&i_data[0], 100), statisticSpan<int>(&out_min[0], 100),
+         statisticSpan<int>(&out_max[0], 100));
+      for (int i = 100; i < size; ++i)
+      {
+         window.Next(i_data[i]);
+         out_min[i] = window.GetMin();
+         out_max[i] = window.GetMax();
+      }
+      CHECK_EQUAL(period, (int)window.Size());
+
+      for (int i = 0; i < size; ++i)
+      {
+         const int first = i + 1 < period ? 0 : i + 1 - period;
+         CHECK_EQUAL(*min_element(&i_data[first], &i_data[i] + 1), out_min[i]);
+         CHECK_EQUAL(*max_element(&i_data[first], &i_data[i] + 1), out_max[i]);
+      }
+   }
+
+   TEST(StatisticMovingMinMaxFixedPeriodTest)
+   {
+      // monotonic input keeps one candidate for one side and the whole window for the other
+      CMovingMinMax<double, 4> window;
+      for (int i = 0; i < 10; ++i)
+         window.Next(i * 1.5);
+      CHECK_EQUAL(9.0, window.GetMin());
+      CHECK_EQUAL(13.5, window.GetMax());
+
+      window.Reset();
+      CHECK_EQUAL(0, (int)window.Size());
+      window.Next(-2.0);
+      CHECK_EQUAL(-2.0, window.GetMin());
+      CHECK_EQUAL(-2.0, window.GetMax());
+   }
+
+   // Quantile sketch TESTS
+   TEST(StatisticTDigestTest)
+   {
+      const int size = 100000;
+      vector<double> d_data(size);
+      for (int i = 0; i < size; ++i)
+         d_data[i] = (double)((i * 7919LL) % size);
+
+      statisticTDigest digest(100);
+      digest.AddRange(d_data.begin(), d_data.end());
+      CHECK_EQUAL((double)size, digest.GetCount());
+      CHECK(digest.GetCentroids().size() < 200);
+      CHECK_EQUAL(0.0, digest.Quantile(0.0));
+      CHECK_EQUAL(size - 1.0, digest.Quantile(1.0));
+
+      // uniform data: quantile q is q * size, the tails are the most accurate
+      CHECK_CLOSE(0.5 * size, digest.Quantile(0.5), 0.01 * size);
+      CHECK_CLOSE(0.99 * size, digest.Quantile(0.99), 0.001 * size);
+      CHECK_CLOSE(0.999 * size, digest.Quantile(0.999), 0.0002 * size);
+      CHECK_CLOSE(0.25, digest.Cdf(0.25 * size), 0.01);
+
+      // digests of the halves merge into the digest of the whole
+      statisticTDigest left, right;
+      left.AddRange(d_data.begin(), d_data.begin() + size / 2);
+      right.AddRange(d_data.begin() + size / 2, d_data.end());
+      left.Merge(right);
+      CHECK_EQUAL((double)size, left.GetCount());
+      CHECK_CLOSE(0.99 * size, left.Quantile(0.99), 0.001 * size);
+      CHECK_CLOSE(0.5 * size, left.Quantile(0.5), 0.01 * size);
+   }
+
+   TEST(StatisticTDigestMergeStateTest)
+   {
+      statisticTDigest digest(50);
+      for (int i = 0; i < 1000; ++i)
+         digest.Add(i);
+
+      // merging with itself doubles the weights
+      const double median = digest.Quantile(0.5);
+      digest.Merge(digest);
+      CHECK_EQUAL(2000.0, digest.GetCount());
+      CHECK_CLOSE(median, digest.Quantile(0.5), 10.0);
+
+      // const queries do not change the digest and run in parallel
+      digest.Add(5000.0);
+      const statisticTDigest& view = digest;
+      double quantiles[4] = {};
+      vector<thread> readers;
+      for (int t = 0; t < 4; ++t)
+         readers.push_back(thread([&view, &quantiles, t]() { quantiles[t] = view.Quantile(0.999) + view.Cdf(500.0); }));
+      for (size_t t = 0; t < readers.size(); ++t)
+         readers[t].join();
+      for (int t = 1; t < 4; ++t)
+         CHECK_EQUAL(quantiles[0], quantiles[t]);
+      const double cdf = digest.Cdf(500.0);
+      digest.Flush();
+      CHECK_EQUAL(cdf, digest.Cdf(500.0));
+      CHECK_EQUAL(2001.0, digest.GetCount());
+
+      // the count must be the weight of the centroids
+      const vector<statisticTDigest::centroid> centroids = digest.GetCentroids();
+      vector<char> buffer(1024 + centroids.size() * sizeof(statisticTDigest::centroid));
+      for (int tampered = 0; tampered < 2; ++tampered)
+      {
+         statisticSnapshotWriter writer(&buffer[0], buffer.size());
+         writer.Put(50.0);
+         writer.Put(0.0);
+         writer.Put(5000.0);
+         writer.Put(tampered ? 3000.0 : 2001.0);
+         writer.PutArray(&centroids[0], centroids.size());
+         CHECK(writer.Finish());
+
+         statisticTDigest restored;
+         statisticSnapshotReader reader(&buffer[0], static_cast<size_t>(writer.Size()));
+         CHECK_EQUAL(!tampered, restored.LoadState(reader));
+         CHECK_EQUAL(!tampered, !reader.IsFailed());
+      }
+   }
+
+   TEST(StatisticEventsQuantileSketchTest)
+   {
+      statisticEvents<int> events;
+      events.SetOnlineMode(true, false);
+      events.SetQuantileSketch(true, 200);
+      for (int i = 1; i <= 1000; ++i)
+         events.StatisticEvent(i);
+      int batch[] = {2000, 3000};
+      events.StatisticEvents(batch, 2);
+
+      CHECK_EQUAL(0, (int)events.GetParamsView().Size());
+      CHECK_EQUAL(1002.0, events.GetQuantileSketch().GetCount());
+      CHECK_CLOSE(500.0, events.GetQuantileSketch().Quantile(0.5), 5.0);
+      CHECK_EQUAL(3000.0, events.GetQuantileSketch().Quantile(1.0));
+
+      events.ResetAllEventsData();
+      CHECK_EQUAL(0.0, events.GetQuantileSketch().GetCount());
+   }
+
+   // Histogram TESTS
+   TEST(StatisticHistogramTest)
+   {
+      statisticHistogram histogram(1, 3600000000LL, 3);
+      CHECK(histogram.GetMemorySize() < 256 * 1024);
+
+      // unit precision below 2000, 3 significant digits above
+      histogram.Record(1000);
+      CHECK_EQUAL(1, (int)histogram.GetCountAtValue(1000));
+      CHECK_EQUAL(1000, histogram.LowestEquivalentValue(1000));
+      CHECK_EQUAL(1000, histogram.HighestEquivalentValue(1000));
+      CHECK(histogram.HighestEquivalentValue(1000000) - histogram.LowestEquivalentValue(1000000) < 1000);
+      histogram.Reset();
+
+      for (long long i = 1; i <= 100000; ++i)
+         histogram.Record(i * 10);
+      CHECK_EQUAL(100000, (int)histogram.GetTotalCount());
+      CHECK_EQUAL(10, (int)histogram.GetMin());
+      CHECK_EQUAL(1000000, (int)histogram.GetMax());
+      CHECK_CLOSE(500005.0, histogram.GetMean(), 1e-6);
+      CHECK_CLOSE(500000.0, (double)histogram.GetValueAtPercentile(50.0), 500.0);
+      CHECK_CLOSE(990000.0, (double)histogram.GetValueAtPercentile(99.0), 990.0);
+      CHECK_CLOSE(999000.0, (double)histogram.GetValueAtPercentile(99.9), 999.0);
+      CHECK_EQUAL(1000000, (int)histogram.GetValueAtPercentile(100.0));
+      CHECK_CLOSE(288675.0, histogram.GetStdDeviation(), 300.0);
+
+      // out of range values are clamped
+      histogram.Record(-5);
+      histogram.Record(1LL << 50);
+      CHECK_EQUAL(0, (int)histogram.GetMin());
+      CHECK(histogram.GetMax() >= 3600000000LL);
+
+      // the lowest value is limited, 2 * lowest does not overflow
+      statisticHistogram huge(0x7FFFFFFFFFFFFFFFLL, 0, 2);
+      CHECK_EQUAL(1LL << 40, huge.GetLowest());
+      CHECK_EQUAL(1LL << 41, huge.GetHighest());
+      huge.Record(1LL << 40);
+      CHECK_EQUAL(1, (int)huge.GetTotalCount());
+   }
+
+   TEST(StatisticHistogramMergeTest)
+   {
+      statisticHistogram a(1, 1000000, 2), b(1, 1000000, 2), c(1, 100000000, 3);
+      for (int i = 1; i <= 1000; ++i)
+      {
+         a.Record(i);
+         b.Record(i + 1000);
+         c.Record(i + 2000);
+      }
+      a.Merge(b);
+      CHECK_EQUAL(2000, (int)a.GetTotalCount());
+      CHECK_CLOSE(1000.5, a.GetMean(), 1e-9);
+      CHECK_CLOSE(1000.0, (double)a.GetValueAtPercentile(50.0), 10.0);
+
+      // different layout
+      a.Merge(c);
+      CHECK_EQUAL(3000, (int)a.GetTotalCount());
+      CHECK_EQUAL(3000, (int)a.GetMax());
+      CHECK_CLOSE(1500.5, a.GetMean(), 1e-9);
+
+      // the extremes of a different layout are the recorded values, not the bucket bounds
+      statisticHistogram coarse(1, 1000000, 1);
+      coarse.Merge(c);
+      CHECK_EQUAL(2001, (int)coarse.GetMin());
+      CHECK_EQUAL(2001, (int)coarse.GetValueAtPercentile(0.0));
+      CHECK_EQUAL(3000, (int)coarse.GetMax());
+
+      statisticEvents<double> events;
+      events.SetHistogram(true, 1, 1000000, 3);
+      double batch[] = {10.0, 20.0, 30.0};
+      events.StatisticEvents(batch, 3);
+      events.StatisticEvent(40.0);
+      CHECK_EQUAL(4, (int)events.GetHistogram().GetTotalCount());
+      CHECK_EQUAL(40, (int)events.GetHistogram().GetValueAtPercentile(100.0));
+      CHECK_EQUAL(20, (int)events.GetHistogram().GetValueAtPercentile(50.0));
+   }
+
+   // Order statistics TESTS
+   TEST(StatisticQuantilesTest)
+   {
+      int i_data[n] = {7, 1, 9, 3, 5, 10, 2, 8, 4, 6};
+      statistic<int> ex_i;
+
+      CHECK_EQUAL(5.5, ex_i.GetStatEvaluations()->Median(i_data, n));
+      CHECK_EQUAL(1.0, ex_i.GetStatEvaluations()->Quantile(i_data, n, 0.0));
+      CHECK_EQUAL(10.0, ex_i.GetStatEvaluations()->Quantile(i_data, n, 1.0));
+      CHECK_CLOSE(9.1, ex_i.GetStatEvaluations()->Quantile(i_data, n, 0.9), 1e-12);
+      CHECK_CLOSE(4.5, ex_i.GetStatEvaluations()->VectorInterquartileRange(statisticSpan<const int>(i_data, n)), 1e-12);
+      CHECK_EQUAL(2.5, ex_i.GetStatEvaluations()->VectorMedianAbsoluteDeviation(statisticSpan<const int>(i_data, n)));
+      // the input is not reordered
+      CHECK_EQUAL(7, i_data[0]);
+      CHECK_EQUAL(6, i_data[9]);
+
+      CHECK_EQUAL(0.0, ex_i.GetStatEvaluations()->VectorMedian(vector<int>()));
+   }
+
+   TEST(StatisticMultiQuantilesTest)
+   {
+      const int size = 200001;
+      vector<double> d_data(size);
+      for (int i = 0; i < size; ++i)
+         d_data[i] = (double)((i * 7919LL) % size) * 0.5 - 1000.0;
+      vector<int> i_data(size);
+      for (int i = 0; i < size; ++i)
+         i_data[i] = (int)((i * 104729LL) % size) - 100000;
+
+      const double q[7] = {0.999, 0.0, 0.5, 0.25, 0.99, 0.75, 1.0};
+      double selected[7], sorted[7], selected_int[7], sorted_int[7];
+
+      statistic<double> select_d, radix_d;
+      statistic<int> select_i, radix_i;
+      statisticThreadPool pool(3);
+      radix_d.GetStatEvaluations()->SetParallelEvaluation(1000, &pool);
+      radix_i.GetStatEvaluations()->SetParallelEvaluation(1000, &pool);
+
+      select_d.GetStatEvaluations()->VectorQuantiles(statisticSpan<const double>(d_data), q, selected, 7);
+      radix_d.GetStatEvaluations()->VectorQuantiles(statisticSpan<const double>(d_data), q, sorted, 7);
+      select_i.GetStatEvaluations()->VectorQuantiles(statisticSpan<const int>(i_data), q, selected_int, 7);
+      radix_i.GetStatEvaluations()->VectorQuantiles(statisticSpan<const int>(i_data), q, sorted_int, 7);
+
+      for (int k = 0; k < 7; ++k)
+      {
+         // values are a permutation of 0..size-1, so the quantiles are known
+         const double rank = q[k] * (size - 1);
+         CHECK_CLOSE(rank * 0.5 - 1000.0, selected[k], 1e-9);
+         CHECK_CLOSE(rank * 0.5 - 1000.0, sorted[k], 1e-9);
+         CHECK_CLOSE(rank - 100000.0, selected_int[k], 1e-9);
+         CHECK_CLOSE(rank - 100000.0, sorted_int[k], 1e-9);
+      }
+
+      // out of range levels are clamped, a NaN level gives a NaN quantile
+      const double odd[3] = {numeric_limits<double>::quiet_NaN(), -numeric_limits<double>::infinity(), 2.0};
+      select_d.GetStatEvaluations()->VectorQuantiles(statisticSpan<const double>(d_data), odd, selected, 3);
+      radix_d.GetStatEvaluations()->VectorQuantiles(statisticSpan<const double>(d_data), odd, sorted, 3);
+      CHECK(selected[0] != selected[0] && sorted[0] != sorted[0]);
+      CHECK_EQUAL(-1000.0, selected[1]);
+      CHECK_EQUAL((size - 1) * 0.5 - 1000.0, sorted[2]);
+      const double single = select_d.GetStatEvaluations()->VectorQuantile(statisticSpan<const double>(d_data), odd[0]);
+      CHECK(single != single);
+
+      // radix sort of signed and negative floating point keys
+      vector<double> values(d_data), buffer;
+      for (int i = 0; i < size; i += 3)
+         values[i] = -values[i];
+      vector<double> expected(values);
+      sort(expected.begin(), expected.end());
+      ParallelRadixSort(values, buffer, pool);
+      CHECK(values == expected);
+   }
+
+   // Cached evaluations TESTS
+   TEST(StatisticCachedEvaluationsTest)
+   {
+      statistic<int> ex_i;
+      statisticCachedEvaluations<int>* cached = ex_i.GetCachedEvaluations();
+      CHECK_EQUAL(0, (int)cached->GetCount());
+
+      for (int i = 1; i <= 10; ++i)
+         ex_i.GetStatEvents()->StatisticEvent(i);
+      CHECK(!cached->IsUpToDate());
+      CHECK_EQUAL(55, cached->GetSum());
+      CHECK_EQUAL(5.5, cached->GetMean());
+      CHECK(cached->IsUpToDate());
+
+      // nothing changed: cached values
+      const unsigned long long full = cached->GetFullEvaluationsCount();
+      CHECK_EQUAL(8.25, cached->GetDispersion());
+      CHECK_EQUAL(full, cached->GetFullEvaluationsCount());
+      CHECK_EQUAL(1, (int)cached->GetTailEvaluationsCount());
+
+      // only the new events are processed
+      int batch[] = {11, 12};
+      ex_i.GetStatEvents()->StatisticEvents(batch, 2);
+      ex_i.GetStatEvents()->StatisticEvent(-3);
+      CHECK_EQUAL(13, (int)cached->GetCount());
+      CHECK_EQUAL(75, cached->GetSum());
+      CHECK_EQUAL(-3, cached->GetMin());
+      CHECK_EQUAL(12, cached->GetMax());
+      CHECK_EQUAL(2, (int)cached->GetTailEvaluationsCount());
+      CHECK_EQUAL(full, cached->GetFullEvaluationsCount());
+
+      // reset of the history
+      ex_i.GetStatEvents()->ResetAllEventsData();
+      ex_i.GetStatEvents()->StatisticEvent(4);
+      CHECK_EQUAL(1, (int)cached->GetCount());
+      CHECK_EQUAL(4, cached->GetMax());
+      CHECK_EQUAL(full + 1, cached->GetFullEvaluationsCount());
+
+      // created on the first request, the events added before are included
+      statistic<int> ex_late;
+      ex_late.GetStatEvents()->StatisticEvent(7);
+      ex_late.GetStatEvents()->StatisticEvent(9);
+      CHECK_EQUAL(8.0, ex_late.GetCachedEvaluations()->GetMean());
+      CHECK(ex_late.GetCachedEvaluations() == ex_late.GetCachedEvaluations());
+   }
+
+   TEST(StatisticCachedEvaluationsBoundedTest)
+   {
+      statisticEvents<double> events;
+      events.SetHistoryCapacity(4);
+      statisticCachedEvaluations<double> cached(&events);
+
+      events.StatisticEvent(1.0);
+      events.StatisticEvent(2.0);
+      CHECK_EQUAL(1.5, cached.GetMean());
+      events.StatisticEvent(3.0);
+      CHECK_EQUAL(2.0, cached.GetMean());
+      CHECK_EQUAL(1, (int)cached.GetTailEvaluationsCount());
+
+      // evicted events: the window is evaluated again
+      for (int i = 4; i <= 6; ++i)
+         events.StatisticEvent(i);
+      CHECK_EQUAL(4, (int)cached.GetCount());
+      CHECK_EQUAL(4.5, cached.GetMean());
+      CHECK_EQUAL(3.0, cached.GetMin());
+
+      events.SetHistoryCapacity(2);
+      CHECK_EQUAL(5.5, cached.GetMean());
+   }
+
+   // Policy based statistic TESTS
+   TEST(StatisticPoliciesTest)
+   {
+      statistic<double, Count, Sum, MinMax, Variance> stat;
+      double d_data[n] = {1.234, 2.298, 4.355, 8.41, 10.54, 6.645, 11.36, 15.898, 12.999, 10.111};
+      stat.AddRange(d_data, d_data + n);
+
+      CHECK_EQUAL(10, (int)stat.GetCount());
+      CHECK_CLOSE(83.85, stat.GetSum(), 1e-9);
+      CHECK_EQUAL(1.234, stat.GetMin());
+      CHECK_EQUAL(15.898, stat.GetMax());
+      double squares = 0;
+      for (int i = 0; i < n; ++i)
+         squares += (d_data[i] - 8.385) * (d_data[i] - 8.385);
+      CHECK_CLOSE(squares / n, stat.GetDispersion(), 1e-9);
+      CHECK_CLOSE(sqrt(squares / n), stat.GetStdDeviation(), 1e-9);
+
+      // only the requested fields are laid out
+      CHECK(sizeof(statistic<double, Sum>) == sizeof(double));
+      CHECK(sizeof(statistic<float, MinMax>) == 2 * sizeof(float));
+      // one count and mean for all the parts: count, mean and sum of squared deviations
+      CHECK(sizeof(statistic<double, Count, Mean, Variance>) == sizeof(long long) + 2 * sizeof(double));
+      CHECK(sizeof(statistic<double, Count, Mean>) == sizeof(long long) + sizeof(double));
+      CHECK(sizeof(statistic<double, Count>) == sizeof(long long));
+
+      statistic<double, Count, Mean, Variance> moments;
+      moments.AddRange(d_data, d_data + n);
+      CHECK_EQUAL(10, (int)moments.GetCount());
+      CHECK_CLOSE(8.385, moments.GetMean(), 1e-12);
+      CHECK_CLOSE(stat.GetDispersion(), moments.GetDispersion(), 1e-12);
+
+      stat.Reset();
+      CHECK_EQUAL(0, (int)stat.GetCount());
+      CHECK_EQUAL(0.0, stat.GetSum());
+
+      const int i_data[4] = {3, -1, 7, 5};
+      statistic<int, Mean, MinMax> fixed(i_data);
+      CHECK_EQUAL(3.5, fixed.GetMean());
+      CHECK_EQUAL(-1, fixed.GetMin());
+      CHECK_EQUAL(7, fixed.GetMax());
+
+#if __cplusplus >= 201402L
+      constexpr int c_data[5] = {4, 8, 15, 16, 23};
+      constexpr statistic<int, Count, Sum, MinMax> folded(c_data);
+      static_assert(folded.GetSum() == 66 && folded.GetMax() == 23 && folded.GetCount() == 5, "constexpr statistic");
+#endif
+   }
+   // Summation TESTS
+   TEST(StatisticPairwiseSummationTest)
+   {
+      const int size = 1000003;
+      vector<float> data(size);
+      double exact = 0;
+      for (int i = 0; i < size; ++i)
+      {
+         data[i] = 0.1f + (i % 7) * 0.001f;
+         exact += data[i];
+      }
+
+      const NStatisticKernels::EInstructionSet supported = NStatisticKernels::SupportedInstructionSet();
+      for (int set = NStatisticKernels::eInstructionSetScalar; set <= supported; ++set)
+      {
+         NStatisticKernels::SetInstructionSet(static_cast<NStatisticKernels::EInstructionSet>(set));
+
+         const float pairwise = NStatisticKernels::Sum(&data[0], size, NStatisticKernels::eSummationPairwise);
+         const float compensated = NStatisticKernels::Sum(&data[0], size, NStatisticKernels::eSummationCompensated);
+         CHECK(fabs(pairwise - exact) / exact < 1e-6);
+         CHECK(fabs(compensated - exact) / exact < 1e-7);
+
+         // the default mode of the evaluations is pairwise
+         statistic<float> pack_float;
+         CHECK_CLOSE(exact / size, pack_float.GetStatEvaluations()->VectorMeanValue(data), 1e-6);
+      }
+      NStatisticKernels::SetInstructionSet(supported);
+   }
+
+   TEST(StatisticCompensatedSummationTest)
+   {
+      // every large value is cancelled by the next one, the ones are lost by a plain sum
+      const int size = 4096 * 3;
+      vector<float> data(size);
+      for (int i = 0; i < size; i += 3)
+      {
+         data[i] = 1e8f;
+         data[i + 1] = 1.0f;
+         data[i + 2] = -1e8f;
+      }
+
+      const NStatisticKernels::EInstructionSet supported = NStatisticKernels::SupportedInstructionSet();
+      for (int set = NStatisticKernels::eInstructionSetScalar; set <= supported; ++set)
+      {
+         NStatisticKernels::SetInstructionSet(static_cast<NStatisticKernels::EInstructionSet>(set));
+
+         statistic<float> pack_float;
+         pack_float.GetStatEvaluations()->SetSummationMode(NStatisticKernels::eSummationCompensated);
+         CHECK_EQUAL(4096.0f, pack_float.GetStatEvaluations()->VectorSum(data));
+      }
+      NStatisticKernels::SetInstructionSet(supported);
+
+      long double ld_data[] = {1e20L, 1.0L, -1e20L};
+      CHECK(NStatisticKernels::Sum(ld_data, 3, NStatisticKernels::eSummationCompensated) == 1.0L);
+   }
+
+   // Event log TESTS
+   TEST(StatisticEventLogTest)
+   {
+      const char* path = "StatisticEventLogTest.slog";
+      const int size = 300000;
+      vector<double> d_data(size);
+      double d_sum = -1.0;
+      for (int i = 0; i < size; ++i)
+      {
+         d_data[i] = (i % 1000) * 0.5;
+         d_sum += d_data[i];
+      }
+
+      {
+         statisticEventLogWriter<double> log;
+         CHECK(log.Open(path, true));
+
+         statistic<double> pack_double;
+         pack_double.GetStatEvents()->SetEventLog(&log);
+         pack_double.GetStatEvents()->StatisticEvent(-1.0);
+         pack_double.GetStatEvents()->StatisticEvents(&d_data[0], d_data.size());
+         CHECK_EQUAL(size + 1, (int)log.Size());
+      }
+
+      statisticEventLogReader<double> reader;
+      CHECK(reader.Open(path));
+      CHECK_EQUAL(size + 1, (int)reader.Size());
+      CHECK(reader.HasTimes());
+      CHECK(reader.GetTimes()[0] > 0 && reader.GetTimes()[0] <= reader.GetTimes()[size]);
+
+      // the kernels run over the mapped file
+      statistic<double> pack_double;
+      statisticSummary<double> summary = pack_double.GetStatEvaluations()->VectorSummarize(reader.GetValues());
+      CHECK_EQUAL(-1.0, summary.min);
+      CHECK_EQUAL(499.5, summary.max);
+      CHECK_CLOSE(d_sum, summary.sum, 1e-6);
+
+      // another type is rejected
+      statisticEventLogReader<float> floats;
+      CHECK(!floats.Open(path));
+      CHECK_EQUAL(0, (int)floats.GetValues().Size());
+      CHECK(!floats.GetTimes().Data());
+      reader.Close();
+      CHECK_EQUAL(0, (int)reader.GetValues().Size());
+      CHECK(!reader.GetValues().Data());
+
+      remove(path);
+      remove((string(path) + ".ts").c_str());
+   }
+
+   TEST(StatisticEventLogAppendTest)
+   {
+      const char* path = "StatisticEventLogAppendTest.slog";
+      int i_data[] = {1, 2, 3, 4, 5};
+
+      statisticEventLogWriter<int> log;
+      CHECK(log.Open(path));
+      CHECK(log.Append(i_data, 3));
+      CHECK(log.Flush());
+
+      // not committed values are dropped when the log is reopened
+      {
+         statisticEventLogReader<int> reader;
+         CHECK(reader.Open(path));
+         CHECK_EQUAL(3, (int)reader.Size());
+         CHECK(!reader.HasTimes());
+      }
+      log.Close();
+
+      CHECK(log.Open(path, false, true));
+      CHECK_EQUAL(3, (int)log.Size());
+      CHECK(log.Append(i_data + 3, 2));
+      log.Close();
+
+      statisticEventLogReader<int> reader;
+      CHECK(reader.Open(path));
+      CHECK_EQUAL(5, (int)reader.Size());
+      for (int i = 0; i < 5; ++i)
+         CHECK_EQUAL(i_data[i], reader.GetValues()[i]);
+      reader.Close();
+
+      statisticEventLogWriter<double> doubles;
+      CHECK(!doubles.Open(path, false, true));
+
+      remove(path);
+   }
+
+   TEST(StatisticEventLogTimesSidecarTest)
+   {
+      const char* path = "StatisticEventLogTimesSidecarTest.slog";
+      const string timesPath = string(path) + ".ts";
+      int i_data[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+      // events logged without times keep their values and get the time 0
+      statisticEventLogWriter<int> log;
+      CHECK(log.Open(path));
+      CHECK(log.Append(i_data, 10));
+      log.Close();
+      CHECK(log.Open(path, true, true));
+      CHECK_EQUAL(10, (int)log.Size());
+      CHECK(log.Append(11, 1234LL));
+      log.Close();
+
+      statisticEventLogReader<int> reader;
+      CHECK(reader.Open(path));
+      CHECK_EQUAL(11, (int)reader.Size());
+      CHECK(reader.HasTimes());
+      CHECK_EQUAL(0LL, reader.GetTimes()[9]);
+      CHECK_EQUAL(1234LL, reader.GetTimes()[10]);
+      reader.Close();
+
+      // a rewritten log does not take the times of the old one
+      CHECK(log.Open(path));
+      CHECK(log.Append(i_data, 5));
+      log.Close();
+      CHECK(reader.Open(path));
+      CHECK_EQUAL(5, (int)reader.Size());
+      CHECK(!reader.HasTimes());
+      reader.Close();
+
+      // nor a times file left by another log
+      statisticEventLogWriter<int> other;
+      CHECK(other.Open("StatisticEventLogTimesSidecarTest.other", true));
+      CHECK(other.Append(i_data, 5));
+      other.Close();
+      CHECK(rename("StatisticEventLogTimesSidecarTest.other.ts", timesPath.c_str()) == 0);
+      CHECK(reader.Open(path));
+      CHECK(!reader.HasTimes());
+      reader.Close();
+
+      // appended with times: the foreign times are replaced
+      CHECK(log.Open(path, true, true));
+      CHECK(log.Append(6, 99LL));
+      log.Close();
+      CHECK(reader.Open(path));
+      CHECK_EQUAL(6, (int)reader.Size());
+      CHECK(reader.HasTimes());
+      CHECK_EQUAL(0LL, reader.GetTimes()[0]);
+      CHECK_EQUAL(99LL, reader.GetTimes()[5]);
+      reader.Close();
+
+      remove(path);
+      remove(timesPath.c_str());
+      remove("StatisticEventLogTimesSidecarTest.other");
+   }
+
+   // Reader TESTS
+   TEST(StatisticParseNumberTest)
+   {
+      const char* numbers[] = {"0", "123.456", "-1e-5", "+0.1", "3.14159265358979", "1.7976931348623157e308",
+         "123456789012345678901234", "4.9e-324", "0.000000000000000000000000001234"};
+      for (size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); ++i)
+      {
+         const char* last = numbers[i] + strlen(numbers[i]);
+         double value = -1;
+         CHECK(StatisticParseNumber(numbers[i], last, value) == last);
+         CHECK_EQUAL(strtod(numbers[i], 0), value);
+      }
+
+      const char text[] = "12.5;7";
+      double value = 0;
+      CHECK(StatisticParseNumber(text, text + 6, value) == text + 4);
+      CHECK_EQUAL(12.5, value);
+      CHECK(StatisticParseNumber(text + 4, text + 4, value) == text + 4);
+
+      long long integer = 0;
+      const char* big = "-9223372036854775808";
+      CHECK(StatisticParseNumber(big, big + strlen(big), integer) == big + strlen(big));
+      CHECK(integer == -9223372036854775807LL - 1);
+      const char* overflow = "9223372036854775808";
+      CHECK(StatisticParseNumber(overflow, overflow + strlen(overflow), integer) == overflow);
+   }
+
+   TEST(StatisticCsvReaderTest)
+   {
+      const char* path = "StatisticCsvReaderTest.csv";
+      FILE* file = fopen(path, "wb");
+      CHECK(file != 0);
+      fputs("time,value,comment\r\n", file);
+      double expected = 0;
+      const int size = 5000;
+      for (int i = 0; i < size; ++i)
+      {
+         fprintf(file, "%d, %.3f ,line %d\r\n", i, i * 0.125 - 100, i);
+         expected += i * 0.125 - 100;
+      }
+      fputs("5000,not a number,\n", file);
+      fputs("5001,1e2", file);
+      expected += 100;
+      fclose(file);
+
+      // small chunks split the lines between the buffers
+      statisticCsvReader<double> csv(1);
+      CHECK(csv.Open(path, 61));
+      statistic<double> pack_double;
+      CHECK_EQUAL(size + 1, (int)csv.ReadTo(*pack_double.GetStatEvents()));
+      CHECK_EQUAL(2, (int)csv.GetSkippedLines());
+      CHECK(!csv.IsFailed());
+      CHECK_EQUAL(size + 1, (int)pack_double.GetStatEvents()->GetParamsView().Size());
+      CHECK_CLOSE(expected, pack_double.GetStatEvaluations()->VectorSum(pack_double.GetStatEvents()->GetParamsView()), 1e-6);
+      csv.Close();
+
+      // the first column as integers straight into an accumulator
+      statisticCsvReader<int> ints;
+      CHECK(ints.Open(path));
+      statisticAccumulator<int> accumulator;
+      ints.Read([&accumulator](const int* values, size_t n) { accumulator.AddRange(values, values + n); });
+      CHECK_EQUAL(size + 2, (int)accumulator.GetCount());
+      CHECK_EQUAL(5001, accumulator.GetMax());
+
+      remove(path);
+   }
+
+   TEST(StatisticBinaryReaderTest)
+   {
+      const char* path = "StatisticBinaryReaderTest.bin";
+      const int size = 10001;
+      vector<long long> l_data(size);
+      for (int i = 0; i < size; ++i)
+         l_data[i] = (long long)i * i;
+      FILE* file = fopen(path, "wb");
+      fwrite(&l_data[0], sizeof(long long), size, file);
+      fclose(file);
+
+      statisticBinaryReader<long long> reader;
+      CHECK(reader.Open(path, 1000));
+      vector<long long> read;
+      CHECK_EQUAL(size, (int)reader.Read([&read](const long long* values, size_t n)
+      {
+         read.insert(read.end(), values, values + n);
+      }));
+      CHECK(read == l_data);
+
+      // closing in the middle of the file stops the read-ahead
+      statisticChunkReader chunks;
+      CHECK(chunks.Open(path, 8));
+      const char* data = 0;
+      size_t bytes = 0;
+      CHECK(chunks.Next(data, bytes));
+      CHECK_EQUAL(8, (int)bytes);
+      CHECK(*reinterpret_cast<const long long*>(data) == 0);
+      chunks.Close();
+
+      statisticBinaryReader<long long> missing;
+      CHECK(!missing.Open("StatisticBinaryReaderTest.missing"));
+
+      remove(path);
+   }
+
+   // Snapshot TESTS
+   TEST(StatisticSnapshotTest)
+   {
+      statistic<double> pack_double;
+      statisticEvents<double>* events = pack_double.GetStatEvents();
+      events->SetOnlineMode(true);
+      events->SetQuantileSketch(true);
+      events->SetHistogram(true, 1, 1000000, 2);
+      events->SetHistoryCapacity(1000);
+      for (int i = 0; i < 2500; ++i)
+         events->StatisticEvent((i * 37) % 1001 + 0.5);
+      pack_double.GetStatEvaluations()->VectorMeanValue(events->GetParamsView());
+
+      vector<char> buffer(SnapshotSize(pack_double));
+      CHECK_EQUAL(0, (int)SaveSnapshot(pack_double, &buffer[0], buffer.size() - 1));
+      CHECK_EQUAL(buffer.size(), SaveSnapshot(pack_double, &buffer[0], buffer.size()));
+
+      statistic<double> restored;
+      CHECK(LoadSnapshot(restored, &buffer[0], buffer.size()));
+      statisticEvents<double>* restoredEvents = restored.GetStatEvents();
+      CHECK(restoredEvents->GetParamsQueue() == events->GetParamsQueue());
+      CHECK_EQUAL(1000, (int)restoredEvents->GetHistoryCapacity());
+      CHECK_EQUAL(2500, (int)restoredEvents->GetOnlineStatistics().GetCount());
+      CHECK_EQUAL(events->GetOnlineStatistics().GetStdDeviation(), restoredEvents->GetOnlineStatistics().GetStdDeviation());
+      CHECK_EQUAL(events->GetQuantileSketch().Quantile(0.9), restoredEvents->GetQuantileSketch().Quantile(0.9));
+      CHECK_EQUAL(events->GetHistogram().GetValueAtPercentile(99), restoredEvents->GetHistogram().GetValueAtPercentile(99));
+      CHECK_EQUAL(pack_double.GetStatEvaluations()->GetMean(), restored.GetStatEvaluations()->GetMean());
+
+      // new events continue the restored history
+      events->StatisticEvent(7.0);
+      restoredEvents->StatisticEvent(7.0);
+      CHECK(restoredEvents->GetParamsQueue() == events->GetParamsQueue());
+
+      // damaged or foreign snapshots are rejected and change nothing
+      buffer[buffer.size() / 2] ^= 1;
+      CHECK(!LoadSnapshot(restored, &buffer[0], buffer.size()));
+      CHECK(restoredEvents->GetParamsQueue() == events->GetParamsQueue());
+      statistic<float> pack_float;
+      buffer[buffer.size() / 2] ^= 1;
+      CHECK(!LoadSnapshot(pack_float, &buffer[0], buffer.size()));
+      CHECK(!LoadSnapshot(restored, &buffer[0], buffer.size() - 8));
+   }
+
+   TEST(StatisticSnapshotEventTimesTest)
+   {
+      statisticEvents<double> events;
+      for (int i = 0; i < 10; ++i)
+         events.StatisticEvent(i);
+
+      vector<char> payload(4096);
+      statisticSnapshotWriter writer(&payload[0], payload.size());
+      events.SaveState(writer);
+      CHECK(writer.Finish());
+      const size_t size = static_cast<size_t>(writer.Size());
+
+      // the mode of every event time, but no times are stored
+      const size_t modeOffset = sizeof(double) + sizeof(int) + 4;
+      const uint32_t mode = eTimestampEvents;
+      memcpy(&payload[modeOffset], &mode, sizeof(mode));
+      statisticEvents<double> restored;
+      restored.StatisticEvent(-1.0);
+      statisticSnapshotReader reader(&payload[0], size);
+      CHECK(!restored.LoadState(reader));
+      CHECK(reader.IsFailed());
+      CHECK_EQUAL(1, (int)restored.GetParamsView().Size());
+
+      const uint32_t none = eTimestampNone;
+      memcpy(&payload[modeOffset], &none, sizeof(none));
+      statisticSnapshotReader valid(&payload[0], size);
+      CHECK(restored.LoadState(valid));
+      CHECK_EQUAL(10, (int)restored.GetParamsView().Size());
+
+      // a huge history capacity is rejected before anything is allocated or changed
+      const size_t capacityOffset = modeOffset + 2 * sizeof(uint32_t) + 2 * sizeof(long long);
+      const uint64_t capacity = 1ULL << 40;
+      memcpy(&payload[capacityOffset], &capacity, sizeof(capacity));
+      statisticEvents<double> bounded;
+      bounded.SetHistoryCapacity(3);
+      bounded.StatisticEvent(-1.0);
+      statisticSnapshotReader huge(&payload[0], size);
+      CHECK(!bounded.LoadState(huge));
+      CHECK(huge.IsFailed());
+      CHECK_EQUAL(3, (int)bounded.GetHistoryCapacity());
+      CHECK_EQUAL(-1.0, bounded.GetParamsQueue()[0]);
+
+      const uint64_t fitting = 16;
+      memcpy(&payload[capacityOffset], &fitting, sizeof(fitting));
+      statisticSnapshotReader bigger(&payload[0], size);
+      CHECK(bounded.LoadState(bigger));
+      CHECK_EQUAL(16, (int)bounded.GetHistoryCapacity());
+      CHECK_EQUAL(10, (int)bounded.GetParamsQueue().size());
+      CHECK_EQUAL(9.0, bounded.GetParamsQueue().back());
+   }
+
+   TEST(StatisticSnapshotFileTest)
+   {
+      const char* path = "StatisticSnapshotFileTest.snap";
+      CMovingAverage average(5);
+      for (int i = 0; i < 7; ++i)
+         average.Next(i * 1.5);
+
+      statisticTDigest digest(50);
+      for (int i = 0; i < 10000; ++i)
+         digest.Add(i);
+
+      CHECK(SaveSnapshotFile(average, path));
+      CMovingAverage restoredAverage(2);
+      CHECK(!LoadSnapshotFile(digest, path));
+      CHECK(LoadSnapshotFile(restoredAverage, path));
+      CHECK_EQUAL(5, (int)restoredAverage.GetPeriod());
+      CHECK_EQUAL(average.GetAverage(), restoredAverage.GetAverage());
+      CHECK_EQUAL(average.Next(100.0), restoredAverage.Next(100.0));
+      CHECK_EQUAL(average.Next(-3.0), restoredAverage.Next(-3.0));
+
+      CBasicMovingAverage<int, 3> partial;
+      partial.Next(4);
+      CHECK(SaveSnapshotFile(partial, path));
+      CBasicMovingAverage<int, 3> restoredPartial;
+      CHECK(LoadSnapshotFile(restoredPartial, path));
+      CHECK_EQUAL(partial.Next(8), restoredPartial.Next(8));
+      CHECK_EQUAL(partial.Next(1), restoredPartial.Next(1));
+      CHECK_EQUAL(partial.Next(2), restoredPartial.Next(2));
+
+      CHECK(SaveSnapshotFile(digest, path));
+      statisticTDigest restoredDigest;
+      CHECK(LoadSnapshotFile(restoredDigest, path));
+      CHECK_EQUAL(digest.Quantile(0.99), restoredDigest.Quantile(0.99));
+      CHECK_EQUAL(50.0, restoredDigest.GetCompression());
+
+      CHECK(!LoadSnapshotFile(restoredDigest, "StatisticSnapshotFileTest.missing"));
+      remove(path);
+   }
+
+
+   TEST(StatisticInstrumentationThreadsTest)
+   {
+      ResetInstrumentation();
+      InstrumentationAdd(eCounterEventsIngested, 5);
+      InstrumentationAdd(eCounterBytesCopied, 64);
+
+      // the counts of a finished thread stay in the totals
+      thread worker([]()
+      {
+         InstrumentationAdd(eCounterEventsIngested, 7);
+         InstrumentationAdd(eCounterEvaluations, 1);
+      });
+      worker.join();
+
+      const statisticInstrumentationSnapshot own = ThreadInstrumentationSnapshot();
+      CHECK_EQUAL(5ULL, own.eventsIngested);
+      CHECK_EQUAL(0ULL, own.evaluations);
+
+      const statisticInstrumentationSnapshot total = InstrumentationSnapshot();
+      CHECK_EQUAL(12ULL, total.eventsIngested);
+      CHECK_EQUAL(1ULL, total.evaluations);
+      CHECK_EQUAL(64ULL, total.bytesCopied);
+
+      // a new thread gets a clean block
+      unsigned long long inherited = 1;
+      thread next([&inherited]() { inherited = ThreadInstrumentationSnapshot().eventsIngested; });
+      next.join();
+      CHECK_EQUAL(0ULL, inherited);
+
+      ResetInstrumentation();
+      CHECK_EQUAL(0ULL, InstrumentationSnapshot().eventsIngested);
+
+      // a reset from another thread counts only the later increments of a running thread
+      atomic<int> phase(0);
+      unsigned long long afterReset = 0;
+      thread running([&phase, &afterReset]()
+      {
+         for (int i = 0; i < 1000; ++i)
+            InstrumentationAdd(eCounterEventsIngested, 1);
+         phase = 1;
+         while (phase != 2)
+            this_thread::yield();
+         for (int i = 0; i < 3; ++i)
+            InstrumentationAdd(eCounterEventsIngested, 1);
+         afterReset = ThreadInstrumentationSnapshot().eventsIngested;
+      });
+      while (phase != 1)
+         this_thread::yield();
+      ResetInstrumentation();
+      phase = 2;
+      running.join();
+      CHECK_EQUAL(3ULL, afterReset);
+      CHECK_EQUAL(3ULL, InstrumentationSnapshot().eventsIngested);
+   }
+
+#if defined(STATISTIC_INSTRUMENTATION)
+   TEST(StatisticInstrumentationCountersTest)
+   {
+      statistic<double> pack;
+      statisticEvents<double>* events = pack.GetStatEvents();
+      statisticEvaluations<double>* evaluations = pack.GetStatEvaluations();
+      ResetInstrumentation();
+
+      double data[100];
+      for (int i = 0; i < 100; ++i)
+         data[i] = i;
+      for (int i = 0; i < 10; ++i)
+         events->StatisticEvent(i);
+      events->StatisticEvents(data, 100);
+
+      statisticInstrumentationSnapshot counters = ThreadInstrumentationSnapshot();
+      CHECK_EQUAL(110ULL, counters.eventsIngested);
+      CHECK(counters.historyReallocations >= 2);
+      CHECK(counters.bytesCopied > 0);
+      CHECK_EQUAL(0ULL, counters.evaluations);
+
+      const unsigned long long copied = counters.bytesCopied;
+      vector<double> queue = events->GetParamsQueue();
+      counters = ThreadInstrumentationSnapshot();
+      CHECK_EQUAL(copied + 110 * sizeof(double), counters.bytesCopied);
+
+      // the views are not copied, the standard deviation is one evaluation
+      evaluations->VectorSum(events->GetParamsView());
+      evaluations->VectorStdDeviation(events->GetParamsView());
+      evaluations->VectorMedian(queue);
+      counters = ThreadInstrumentationSnapshot();
+      CHECK_EQUAL(3ULL, counters.evaluations);
+      CHECK_EQUAL(330ULL, counters.elementsScanned);
+      CHECK_EQUAL(copied + 220 * sizeof(double), counters.bytesCopied);
+   }
+#endif
+
+   TEST(StatisticRegistryTest)
+   {
+      statisticRegistry<double> registry;
+      const statisticRegistry<double>::handle latency = registry.Handle("http.latency");
+      CHECK_EQUAL(latency, registry.Handle(string("http.latency")));
+      CHECK(latency != registry.HandleId(7));
+      CHECK_EQUAL(registry.HandleId(7), registry.HandleId(7, StatisticHashId(7)));
+      CHECK(registry.Handle("") != latency);
+      CHECK_EQUAL(3, (int)registry.Size());
+
+      registry.Add(latency, 10.0);
+      registry.Add("http.latency", 20.0);
+      registry.AddId(7, 1.0);
+      CHECK_EQUAL(2, (int)registry.Get(latency).GetCount());
+      CHECK_CLOSE(15.0, registry.Get(latency).GetMean(), 1e-12);
+      CHECK(!registry.Find("http.errors"));
+      CHECK(!registry.FindId(8));
+      CHECK_EQUAL(1.0, registry.FindId(7)->GetSum());
+      CHECK_EQUAL(30.0, registry.Find("http.latency")->GetSum());
+
+      CHECK(!registry.Key(latency).IsId());
+      CHECK(registry.Key(latency).Name() == "http.latency");
+      CHECK(registry.Key(registry.HandleId(7)).IsId());
+      CHECK_EQUAL(7ULL, (unsigned long long)registry.Key(registry.HandleId(7)).id);
+      CHECK(!registry.Key(registry.Handle("")).IsId());
+
+      // growth of the index and the arena keeps the handles
+      vector<statisticRegistry<double>::handle> handles;
+      for (int i = 0; i < 5000; ++i)
+      {
+         char name[32];
+         sprintf(name, "series.%d", i);
+         handles.push_back(registry.Handle(name));
+         registry.Add(handles.back(), i);
+         registry.AddId(1000000 + i, -i);
+      }
+      CHECK_EQUAL(10003, (int)registry.Size());
+      CHECK_EQUAL(30.0, registry.Get(latency).GetSum());
+      bool found = true;
+      for (int i = 0; i < 5000; ++i)
+      {
+         char name[32];
+         sprintf(name, "series.%d", i);
+         found = found && registry.Find(name) == &registry.Get(handles[i]) && registry.Get(handles[i]).GetSum() == i
+            && registry.FindId(1000000 + i)->GetSum() == -i;
+      }
+      CHECK(found);
+      CHECK(registry.MemoryUsage() < 10003 * 200);
+
+      // creation order
+      long long count = 0;
+      string first;
+      registry.ForEach([&](const statisticRegistryKey& key, const statisticAccumulator<double>& value)
+      {
+         if (first.empty())
+            first = key.Name();
+         count += value.GetCount();
+      });
+      CHECK(first == "http.latency");
+      CHECK_EQUAL(2 + 1 + 10000, (int)count);
+
+      registry.ResetValues();
+      CHECK_EQUAL(10003, (int)registry.Size());
+      CHECK_EQUAL(0, (int)registry.Get(latency).GetCount());
+      CHECK_EQUAL(latency, registry.Handle("http.latency"));
+
+      registry.Clear();
+      CHECK_EQUAL(0, (int)registry.Size());
+      CHECK(!registry.Find("http.latency"));
+   }
+
+   TEST(StatisticRegistryMergeSnapshotTest)
+   {
+      statisticRegistry<int> first, second(1000);
+      first.Add("requests", 3);
+      first.Add("requests", 5);
+      first.AddId(1, 10);
+      second.Add("requests", 7);
+      second.Add("errors", 1);
+      second.AddId(2, 20);
+
+      first.Merge(second);
+      CHECK_EQUAL(4, (int)first.Size());
+      CHECK_EQUAL(15, first.Find("requests")->GetSum());
+      CHECK_EQUAL(7, first.Find("requests")->GetMax());
+      CHECK_EQUAL(3, (int)first.Find("requests")->GetCount());
+      CHECK_EQUAL(1, first.Find("errors")->GetSum());
+      CHECK_EQUAL(20, first.FindId(2)->GetSum());
+
+      vector<char> buffer(SnapshotSize(first));
+      CHECK_EQUAL(buffer.size(), SaveSnapshot(first, &buffer[0], buffer.size()));
+
+      statisticRegistry<int> restored;
+      restored.Add("stale", 1);
+      CHECK(LoadSnapshot(restored, &buffer[0], buffer.size()));
+      CHECK_EQUAL(4, (int)restored.Size());
+      CHECK(!restored.Find("stale"));
+      CHECK_EQUAL(15, restored.Find("requests")->GetSum());
+      CHECK_CLOSE(first.Find("requests")->GetDispersion(), restored.Find("requests")->GetDispersion(), 1e-12);
+      CHECK_EQUAL(10, restored.FindId(1)->GetSum());
+      CHECK(restored.Key(0).Name() == "requests");
+
+      // other value type and damaged payload
+      statisticRegistry<double> other;
+      CHECK(!LoadSnapshot(other, &buffer[0], buffer.size()));
+      buffer[buffer.size() - 3] ^= 0x55;
+      CHECK(!LoadSnapshot(restored, &buffer[0], buffer.size()));
+      CHECK_EQUAL(15, restored.Find("requests")->GetSum());
+
+      // a name longer than the payload is rejected before it is allocated
+      char payload[64];
+      statisticSnapshotWriter writer(payload, sizeof(payload));
+      writer.Put<uint64_t>(1);
+      writer.Put<uint32_t>(0x7ffffff0);
+      writer.Write("requests", 8);
+      CHECK(writer.Finish());
+      statisticSnapshotReader reader(payload, static_cast<size_t>(writer.Size()));
+      CHECK(!restored.LoadState(reader));
+      CHECK(reader.IsFailed());
+      CHECK_EQUAL(4, (int)restored.Size());
+   }
 } // Statistics